@@ -0,0 +1,43 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "util/flyweightstring.h"
+#include "util/interntable.h"
+
+namespace {
+
+std::vector<std::string> symbolNames() {
+    std::vector<std::string> names;
+    for (int i = 0; i < 1000; i++) {
+        names.push_back("SYMBOL" + std::to_string(i));
+    }
+    return names;
+}
+
+// every thread resolves strings already in the pool
+void BM_FlyweightStringLookup(benchmark::State &state) {
+    static const std::vector<std::string> names = symbolNames();
+    size_t i = state.thread_index();
+    for (auto _ : state) {
+        FlyweightString str{names[i++ % names.size()]};
+        benchmark::DoNotOptimize(str);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_SymbolLookup(benchmark::State &state) {
+    static const std::vector<std::string> names = symbolNames();
+    size_t i = state.thread_index();
+    for (auto _ : state) {
+        Symbol symbol{names[i++ % names.size()]};
+        benchmark::DoNotOptimize(symbol);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(BM_FlyweightStringLookup)->ThreadRange(1, 8);
+BENCHMARK(BM_SymbolLookup)->ThreadRange(1, 8);
@@ -0,0 +1,39 @@
+#include <benchmark/benchmark.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <string>
+
+#include "book/command_journal.hpp"
+
+namespace {
+
+// cost of append() on the matching thread, the writer syncing groups behind
+void BM_JournalAppend(benchmark::State &state) {
+    std::string path = "/tmp/journal_bench_" + std::to_string(getpid());
+    std::remove(path.c_str());
+    Order order{"order-1", OrderType::GoodTillCancel, Side::Buy, 100.0, 10};
+    OrderEvent event = OrderEvent::add("AAPL", order);
+    uint64_t commits = 0;
+    uint64_t spilled = 0;
+    {
+        CommandJournal<> journal{path};
+        auto &producer = journal.addProducer();
+        journal.start();
+        for (auto _ : state) {
+            event.sequence_++;
+            producer.append(event);
+        }
+        spilled = producer.spilled();
+        journal.stop();
+        commits = journal.stats().commits_;
+    }
+    std::remove(path.c_str());
+    state.counters["commits"] = commits;
+    state.counters["spilled"] = spilled;
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(BM_JournalAppend);
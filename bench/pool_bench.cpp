@@ -0,0 +1,94 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "concurrency/spscqueue.hpp"
+#include "util/objectpool.hpp"
+#include "util/threadcachingpool.hpp"
+
+namespace {
+
+struct BenchObject {
+    BenchObject() = default;
+    explicit BenchObject(int64_t v) : data{v} {}
+
+    int64_t data{0};
+    char payload[56];
+};
+
+// every thread allocates a burst of objects and frees them again
+template <typename Pool>
+void BM_PoolAllocFree(benchmark::State &state) {
+    auto &pool = Pool::GetInst();
+    const auto batch = state.range(0);
+    std::vector<BenchObject *> objs(batch);
+
+    for (auto _ : state) {
+        for (int64_t i = 0; i < batch; i++) {
+            objs[i] = pool.allocate(i);
+        }
+        benchmark::ClobberMemory();
+        for (int64_t i = 0; i < batch; i++) {
+            pool.deallocate(objs[i]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+
+// same burst on a pool instance owned by each thread, no lock, no sharing
+template <typename Pool>
+void BM_OwnedPoolAllocFree(benchmark::State &state) {
+    Pool pool;
+    const auto batch = state.range(0);
+    std::vector<BenchObject *> objs(batch);
+
+    for (auto _ : state) {
+        for (int64_t i = 0; i < batch; i++) {
+            objs[i] = pool.allocate(i);
+        }
+        benchmark::ClobberMemory();
+        for (int64_t i = 0; i < batch; i++) {
+            pool.deallocate(objs[i]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+
+// every thread hands its burst to its neighbour and frees the neighbour's,
+// so nearly every free takes the remote path
+template <typename Pool>
+void BM_PoolCrossThreadFree(benchmark::State &state) {
+    static constexpr int64_t BATCH = 64;
+    static SPSCQueue<BenchObject *, 4096> handoff[8];
+
+    auto &pool = Pool::GetInst();
+    auto &mine = handoff[state.thread_index()];
+    auto &theirs = handoff[(state.thread_index() + 1) % state.threads()];
+
+    for (auto _ : state) {
+        for (int64_t i = 0; i < BATCH; i++) {
+            BenchObject *obj = pool.allocate(i);
+            if (!mine.emplace(obj)) {
+                pool.deallocate(obj);
+            }
+        }
+        BenchObject *obj;
+        for (int64_t i = 0; i < BATCH && theirs.pop(obj); i++) {
+            pool.deallocate(obj);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * BATCH);
+}
+
+using MutexPool = ObjectPool<BenchObject>;
+using CachingPool = ThreadCachingObjectPool<BenchObject>;
+using OwnedPool =
+    ObjectPool<BenchObject, (1 << 12), PoolMapDefault, DefaultPoolTracking, SingleOwnerMutex>;
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_PoolAllocFree, MutexPool)->Arg(1)->Arg(64)->ThreadRange(1, 8);
+BENCHMARK_TEMPLATE(BM_PoolAllocFree, CachingPool)->Arg(1)->Arg(64)->ThreadRange(1, 8);
+BENCHMARK_TEMPLATE(BM_OwnedPoolAllocFree, OwnedPool)->Arg(1)->Arg(64)->ThreadRange(1, 8);
+BENCHMARK_TEMPLATE(BM_PoolCrossThreadFree, MutexPool)->ThreadRange(2, 8);
+BENCHMARK_TEMPLATE(BM_PoolCrossThreadFree, CachingPool)->ThreadRange(2, 8);
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include <benchmark/benchmark.h>
+
+#include <list>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "book/book_l3_map.hpp"
+#include "book/book_rebuild.hpp"
+
+namespace {
+
+using Book = MapBasedL3OrderBook<std::list<Order *>>;
+
+// adds and cancels over 64 symbols, a few of them much busier than the rest
+const std::vector<OrderEvent> &events() {
+    static const std::vector<OrderEvent> log = [] {
+        std::mt19937 rng{42};
+        std::vector<OrderEvent> result;
+        std::vector<std::vector<std::string>> resting(64);
+        for (int id = 0; id < 1'000'000; id++) {
+            size_t s = rng() % 4 == 0 ? rng() % 4 : rng() % 64;
+            std::string symbol = "SYM" + std::to_string(s);
+            auto &ids = resting[s];
+            if (ids.size() > 64 && rng() % 2 == 0) {
+                size_t pick = rng() % ids.size();
+                result.push_back(OrderEvent::cancel(symbol, ids[pick]));
+                ids[pick] = ids.back();
+                ids.pop_back();
+                continue;
+            }
+            Side side = rng() % 2 ? Side::Buy : Side::Sell;
+            Price price = 100.0 + static_cast<int>(rng() % 21) - 10;
+            Order order{std::to_string(id), OrderType::GoodTillCancel, side, price,
+                        static_cast<Quantity>(1 + rng() % 100)};
+            result.push_back(OrderEvent::add(symbol, order));
+            ids.push_back(order.getOrderId());
+        }
+        return result;
+    }();
+    return log;
+}
+
+void BM_Rebuild(benchmark::State &state) {
+    const auto &log = events();
+    BookRebuilder<Book> rebuilder{static_cast<size_t>(state.range(0))};
+    for (auto _ : state) {
+        auto result = rebuilder.rebuild(log);
+        benchmark::DoNotOptimize(result.book_count());
+    }
+    state.SetItemsProcessed(state.iterations() * log.size());
+}
+
+}  // namespace
+
+BENCHMARK(BM_Rebuild)->Arg(1)->Arg(2)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
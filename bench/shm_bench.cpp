@@ -0,0 +1,88 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "concurrency/shmspscqueue.hpp"
+#include "concurrency/spscqueue.hpp"
+
+namespace {
+
+struct Message {
+    uint64_t sequence_;
+    char payload_[56];
+};
+
+// round trip of one message through a ping and a pong ring, the echo thread
+// attaches through its own mapping as a separate process would
+void BM_ShmPingPong(benchmark::State &state) {
+    using Ring = ShmSPSCQueue<Message, 1024>;
+    ShmSegment pingSegment = ShmSegment::anonymous(Ring::segmentSize());
+    ShmSegment pongSegment = ShmSegment::anonymous(Ring::segmentSize());
+    Ring ping{pingSegment, Ring::Role::Producer};
+    Ring pong{pongSegment, Ring::Role::Consumer};
+
+    std::atomic<bool> stop{false};
+    std::thread echo([&] {
+        ShmSegment in = ShmSegment::fromFd(dup(pingSegment.fd()));
+        ShmSegment out = ShmSegment::fromFd(dup(pongSegment.fd()));
+        Ring request{in, Ring::Role::Consumer};
+        Ring reply{out, Ring::Role::Producer};
+        Message m;
+        while (!stop.load(std::memory_order_relaxed)) {
+            if (request.pop(m)) {
+                while (!reply.push(m));
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    Message m{};
+    for (auto _ : state) {
+        m.sequence_++;
+        while (!ping.push(m));
+        while (!pong.pop(m)) {
+            std::this_thread::yield();
+        }
+    }
+    stop.store(true);
+    echo.join();
+    state.SetItemsProcessed(state.iterations());
+}
+
+// the same round trip through in-process rings
+void BM_InProcessPingPong(benchmark::State &state) {
+    auto ping = std::make_unique<SPSCQueue<Message, 1024>>();
+    auto pong = std::make_unique<SPSCQueue<Message, 1024>>();
+
+    std::atomic<bool> stop{false};
+    std::thread echo([&] {
+        Message m;
+        while (!stop.load(std::memory_order_relaxed)) {
+            if (ping->pop(m)) {
+                while (!pong->emplace(m));
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    Message m{};
+    for (auto _ : state) {
+        m.sequence_++;
+        while (!ping->emplace(m));
+        while (!pong->pop(m)) {
+            std::this_thread::yield();
+        }
+    }
+    stop.store(true);
+    echo.join();
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(BM_ShmPingPong)->UseRealTime();
+BENCHMARK(BM_InProcessPingPong)->UseRealTime();
@@ -0,0 +1,70 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "concurrency/spscqueue.hpp"
+#include "util/threadtuning.h"
+
+namespace {
+
+// producer on cpu 0 pushes bursts of range(0), the consumer on cpu range(1)
+// drains them; with one element per burst the single-element calls are used
+void BM_SPSCBurst(benchmark::State &state) {
+    using Queue = SPSCQueue<uint64_t, 4096>;
+    const size_t batch = state.range(0);
+    const int consumerCpu = state.range(1);
+
+    auto queue = std::make_unique<Queue>();
+    std::atomic<bool> stop{false};
+    std::thread consumer([&] {
+        pinCurrentThread(consumerCpu);
+        uint64_t sum = 0;
+        std::vector<uint64_t> out(batch);
+        while (!stop.load(std::memory_order_relaxed)) {
+            size_t n;
+            if (batch == 1) {
+                n = queue->pop(out[0]) ? 1 : 0;
+                sum += n ? out[0] : 0;
+            } else {
+                n = queue->consume_all([&sum](uint64_t value) { sum += value; });
+            }
+            if (n == 0) {
+                std::this_thread::yield();
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    });
+
+    pinCurrentThread(0);
+    std::vector<uint64_t> burst(batch, 1);
+    size_t items = 0;
+    for (auto _ : state) {
+        size_t pushed = batch == 1 ? (queue->emplace(1) ? 1 : 0)
+                                   : queue->push_n(burst.begin(), batch);
+        if (pushed == 0) {
+            std::this_thread::yield();
+        }
+        items += pushed;
+    }
+    stop.store(true);
+    consumer.join();
+    state.SetItemsProcessed(items);
+}
+
+// a sibling, a core in the middle and the last core, as far as they exist
+void corePairs(benchmark::internal::Benchmark *bench) {
+    int cpus = std::max(1u, std::thread::hardware_concurrency());
+    std::set<int> consumers{std::min(1, cpus - 1), cpus / 2, cpus - 1};
+    for (int batch : {1, 8, 64, 256}) {
+        for (int cpu : consumers) {
+            bench->Args({batch, cpu});
+        }
+    }
+}
+
+}  // namespace
+
+BENCHMARK(BM_SPSCBurst)->Apply(corePairs)->ArgNames({"batch", "cpu"})->UseRealTime();
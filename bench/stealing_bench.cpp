@@ -0,0 +1,156 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <list>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "book/book_l3_map.hpp"
+#include "book/engine_runner.hpp"
+#include "book/stealing_engine.hpp"
+
+namespace {
+
+using Book = MapBasedL3OrderBook<std::list<Order *>>;
+
+constexpr int SYMBOLS = 64;
+constexpr int ORDERS = 1 << 14;
+
+struct CountingHandler {
+    std::atomic<uint64_t> *handled_;
+
+    void operator()(Book &, const BookCommand &, Trades &) const {
+        handled_->fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+// symbol of every order, Zipf with exponent s over SYMBOLS symbols
+std::vector<int> zipfSymbols(double s) {
+    std::vector<double> cdf(SYMBOLS);
+    double sum = 0;
+    for (int k = 0; k < SYMBOLS; k++) {
+        sum += 1.0 / std::pow(k + 1, s);
+        cdf[k] = sum;
+    }
+    std::mt19937 rng{42};
+    std::uniform_real_distribution<double> uniform{0, sum};
+    std::vector<int> symbols(ORDERS);
+    for (int &symbol : symbols) {
+        symbol = std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin();
+    }
+    return symbols;
+}
+
+// resting orders that never cross, added and cancelled again every iteration
+std::vector<Order> makeOrders() {
+    std::vector<Order> orders;
+    orders.reserve(ORDERS);
+    for (int i = 0; i < ORDERS; i++) {
+        Side side = i % 2 ? Side::Buy : Side::Sell;
+        Price price = side == Side::Buy ? 90.0 - i % 10 : 110.0 + i % 10;
+        orders.emplace_back(std::to_string(i), OrderType::GoodTillCancel, side, price, 10);
+    }
+    return orders;
+}
+
+RunnerConfig benchConfig(size_t workers) {
+    RunnerConfig config;
+    for (size_t i = 0; i < workers; i++) {
+        config.cores_.push_back(static_cast<int>(i % std::thread::hardware_concurrency()));
+    }
+    return config;
+}
+
+// pushes every order and its cancel to the queue of its symbol, one
+// producer, then waits until the workers handled all of them
+template <typename Push>
+void runIteration(const std::vector<int> &symbols, std::vector<Order> &orders,
+                  std::atomic<uint64_t> &handled, uint64_t target, Push &&push) {
+    for (int i = 0; i < ORDERS; i++) {
+        push(symbols[i], BookCommand::add(&orders[i]));
+    }
+    for (int i = 0; i < ORDERS; i++) {
+        push(symbols[i], BookCommand::cancel(&orders[i]));
+    }
+    while (handled.load(std::memory_order_relaxed) < target) {
+        std::this_thread::yield();
+    }
+}
+
+// book i on worker i % workers
+void BM_FixedSharding(benchmark::State &state) {
+    const auto symbols = zipfSymbols(state.range(1) / 100.0);
+    auto orders = makeOrders();
+    std::vector<Book> books(SYMBOLS);
+    std::atomic<uint64_t> handled{0};
+    const size_t workers = state.range(0);
+
+    EngineRunner<Book, CountingHandler> runner{benchConfig(workers), CountingHandler{&handled}};
+    std::vector<EngineRunner<Book, CountingHandler>::InputQueue *> queues;
+    for (int i = 0; i < SYMBOLS; i++) {
+        queues.push_back(&runner.attach(i % workers, books[i]));
+    }
+    runner.start();
+
+    uint64_t target = 0;
+    for (auto _ : state) {
+        target += 2 * ORDERS;
+        runIteration(symbols, orders, handled, target, [&](int symbol, const BookCommand &c) {
+            while (!queues[symbol]->emplace(c)) {
+                std::this_thread::yield();
+            }
+        });
+    }
+    runner.stop();
+    state.SetItemsProcessed(state.iterations() * 2 * ORDERS);
+}
+
+// any book on any worker
+void BM_WorkStealing(benchmark::State &state) {
+    const auto symbols = zipfSymbols(state.range(1) / 100.0);
+    auto orders = makeOrders();
+    std::vector<Book> books(SYMBOLS);
+    std::atomic<uint64_t> handled{0};
+
+    StealingEngine<Book, CountingHandler> engine{benchConfig(state.range(0)),
+                                                 CountingHandler{&handled}};
+    std::vector<StealingEngine<Book, CountingHandler>::BookQueue *> queues;
+    for (int i = 0; i < SYMBOLS; i++) {
+        queues.push_back(&engine.attach(books[i]));
+    }
+    engine.start();
+
+    uint64_t target = 0;
+    for (auto _ : state) {
+        target += 2 * ORDERS;
+        runIteration(symbols, orders, handled, target, [&](int symbol, const BookCommand &c) {
+            while (!queues[symbol]->push(c)) {
+                std::this_thread::yield();
+            }
+        });
+    }
+    engine.stop();
+
+    uint64_t steals = 0;
+    for (size_t i = 0; i < engine.worker_count(); i++) {
+        steals += engine.stats(i).steals_;
+    }
+    state.counters["steals"] = steals;
+    state.SetItemsProcessed(state.iterations() * 2 * ORDERS);
+}
+
+}  // namespace
+
+// workers, Zipf exponent * 100
+BENCHMARK(BM_FixedSharding)
+    ->ArgsProduct({{2, 4}, {0, 110}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(BM_WorkStealing)
+    ->ArgsProduct({{2, 4}, {0, 110}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
@@ -0,0 +1,51 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "util/objectpool.hpp"
+#include "util/slaballocator.hpp"
+
+namespace {
+
+struct TrackedObject {
+    TrackedObject() = default;
+    explicit TrackedObject(int64_t v) : data{v} {}
+
+    int64_t data{0};
+    char payload[56];
+};
+
+// cost of the bookkeeping per allocate/deallocate pair
+template <typename Pool>
+void BM_TrackingAllocFree(benchmark::State &state) {
+    auto &pool = Pool::GetInst();
+    const auto batch = state.range(0);
+    std::vector<TrackedObject *> objs(batch);
+
+    for (auto _ : state) {
+        for (int64_t i = 0; i < batch; i++) {
+            objs[i] = pool.allocate(i);
+        }
+        benchmark::ClobberMemory();
+        for (int64_t i = 0; i < batch; i++) {
+            pool.deallocate(objs[i]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+
+template <typename Tracking>
+using TrackedObjectPool = ObjectPool<TrackedObject, (1 << 12), PoolMapDefault, Tracking>;
+template <typename Tracking>
+using TrackedSlabAllocator = SlabAllocator<TrackedObject, (1 << 12), Tracking>;
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_TrackingAllocFree, TrackedObjectPool<NoTracking>)->Arg(64)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_TrackingAllocFree, TrackedObjectPool<HeaderTracking>)->Arg(64)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_TrackingAllocFree, TrackedObjectPool<FullTracking>)->Arg(64)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_TrackingAllocFree, TrackedSlabAllocator<NoTracking>)->Arg(64)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_TrackingAllocFree, TrackedSlabAllocator<HeaderTracking>)
+    ->Arg(64)
+    ->Arg(4096);
+BENCHMARK_TEMPLATE(BM_TrackingAllocFree, TrackedSlabAllocator<FullTracking>)->Arg(64)->Arg(4096);
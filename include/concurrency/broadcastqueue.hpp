@@ -0,0 +1,287 @@
+#ifndef _BROADCAST_QUEUE_H
+#define _BROADCAST_QUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "waitstrategy.hpp"
+
+// what the producer does when it catches up with the slowest consumer
+enum class BroadcastMode : uint8_t {
+    // waits, every consumer sees every element
+    Gating,
+    // overwrites, a lapped consumer skips to the oldest element still in the
+    // ring and counts what it lost; T must be trivially copyable
+    Lapping,
+};
+
+// Single-producer multi-consumer broadcast ring.
+//
+// The producer writes each element once into a ring of sequenced slots and
+// publishes a cursor, the sequence of the next element. Every consumer reads
+// every element on its own and publishes its own sequence, on its own cache
+// line. In Gating mode the producer does not pass the slowest consumer's
+// sequence by more than Capacity, it caches that minimum and only scans the
+// consumers again when the cache says full. In Lapping mode the producer
+// never waits; slots carry their sequence and a consumer checks it around
+// the copy like a seqlock reader.
+//
+// Consumers subscribe before the producer starts publishing in Gating mode,
+// a consumer subscribing later may miss the producer's next scan.
+template <typename T, size_t Capacity = 65536, size_t MAX_CONSUMERS = 16,
+          BroadcastMode MODE = BroadcastMode::Gating>
+class BroadcastQueue {
+    static_assert(Capacity >= 2 && std::has_single_bit(Capacity),
+                  "Capacity must be a power of 2");
+    static_assert(MODE != BroadcastMode::Lapping || std::is_trivially_copyable_v<T>,
+                  "lapping consumers copy elements being overwritten");
+
+   public:
+    // a subscription, used by one consumer thread
+    class Consumer {
+       public:
+        Consumer(Consumer &&other) noexcept
+            : queue_{std::exchange(other.queue_, nullptr)},
+              cursor_{other.cursor_},
+              next_{other.next_},
+              lapped_{other.lapped_} {}
+
+        Consumer &operator=(Consumer &&) = delete;
+
+        // stops gating the producer
+        ~Consumer() {
+            if (queue_ != nullptr) {
+                queue_->readers_[cursor_].active_.store(false, std::memory_order_release);
+            }
+        }
+
+        // the next element if any
+        bool poll(T &result) {
+            return consume(1, [&result](const T &value) { result = value; }) == 1;
+        }
+
+        // calls f(const T &) on every element published, returns how many
+        template <typename F>
+        size_t consume_all(F &&f) {
+            return consume(Capacity, std::forward<F>(f));
+        }
+
+        // elements published and not read yet, at most Capacity
+        size_t backlog() const noexcept {
+            return queue_->cursor_.load(std::memory_order_acquire) - next_;
+        }
+
+        // elements skipped after being lapped
+        uint64_t lapped() const noexcept { return lapped_; }
+
+       private:
+        friend class BroadcastQueue;
+
+        Consumer(BroadcastQueue *queue, size_t reader, uint64_t next)
+            : queue_{queue}, cursor_{reader}, next_{next} {}
+
+        template <typename F>
+        size_t consume(size_t n, F &&f) {
+            size_t total = 0;
+            while (total < n) {
+                uint64_t published = queue_->cursor_.load(std::memory_order_acquire);
+                size_t batch = std::min<uint64_t>(n - total, published - next_);
+                if (batch == 0) {
+                    break;
+                }
+
+                size_t read = 0;
+                if constexpr (MODE == BroadcastMode::Gating) {
+                    for (; read < batch; read++) {
+                        f(queue_->slots_[(next_ + read) & MASK].data_);
+                    }
+                } else {
+                    alignas(T) unsigned char copy[sizeof(T)];
+                    for (; read < batch && queue_->readSlot(next_ + read, copy); read++) {
+                        f(*std::launder(reinterpret_cast<const T *>(copy)));
+                    }
+                }
+                next_ += read;
+                total += read;
+                if (read == batch) [[likely]] {
+                    break;
+                }
+                // overwritten, go on from the oldest element still there
+                relap();
+            }
+            if (total > 0) {
+                queue_->readers_[cursor_].sequence_.store(next_, std::memory_order_release);
+            }
+            return total;
+        }
+
+        void relap() {
+            uint64_t published = queue_->cursor_.load(std::memory_order_acquire);
+            // the slot after the producer's may be rewritten meanwhile,
+            // keep one slot of distance
+            uint64_t oldest = published > Capacity - 1 ? published - (Capacity - 1) : 0;
+            if (oldest > next_) {
+                lapped_ += oldest - next_;
+                next_ = oldest;
+            }
+        }
+
+        BroadcastQueue *queue_;
+        size_t cursor_;   // index of the reader entry
+        uint64_t next_;   // sequence of the next element to read
+        uint64_t lapped_{0};
+    };
+
+    BroadcastQueue() : slots_{new Slot[Capacity]} {}
+
+    // non-copyable
+    BroadcastQueue(const BroadcastQueue &) = delete;
+    BroadcastQueue &operator=(const BroadcastQueue &) = delete;
+
+    // a consumer reading from the next element published on, throws
+    // std::length_error if MAX_CONSUMERS are subscribed
+    Consumer subscribe() {
+        for (size_t i = 0; i < MAX_CONSUMERS; i++) {
+            bool expected = false;
+            if (!readers_[i].active_.compare_exchange_strong(expected, true)) {
+                continue;
+            }
+            uint64_t next = cursor_.load(std::memory_order_acquire);
+            readers_[i].sequence_.store(next, std::memory_order_seq_cst);
+            return Consumer{this, i, next};
+        }
+        throw std::length_error("too many broadcast consumers");
+    }
+
+    // producer side
+
+    // false if the slowest consumer is Capacity elements behind
+    template <typename... Args>
+    bool try_publish(Args &&...args) {
+        uint64_t sequence = cursor_.load(std::memory_order_relaxed);
+        if (room(sequence, 1) == 0) {
+            return false;
+        }
+        write(sequence, T{std::forward<Args>(args)...});
+        cursor_.store(sequence + 1, std::memory_order_release);
+        return true;
+    }
+
+    // waits for the slowest consumer in Gating mode
+    template <typename... Args>
+    void publish(Args &&...args) {
+        uint64_t sequence = cursor_.load(std::memory_order_relaxed);
+        while (room(sequence, 1) == 0) {
+            cpuRelax();
+        }
+        write(sequence, T{std::forward<Args>(args)...});
+        cursor_.store(sequence + 1, std::memory_order_release);
+    }
+
+    // copies up to n elements, one release store for all, returns how many
+    size_t publish_n(const T *values, size_t n) {
+        uint64_t sequence = cursor_.load(std::memory_order_relaxed);
+        n = std::min<size_t>(n, room(sequence, n));
+        for (size_t i = 0; i < n; i++) {
+            write(sequence + i, values[i]);
+        }
+        if (n > 0) {
+            cursor_.store(sequence + n, std::memory_order_release);
+        }
+        return n;
+    }
+
+    uint64_t published() const noexcept { return cursor_.load(std::memory_order_acquire); }
+
+    size_t consumer_count() const noexcept {
+        size_t count = 0;
+        for (const auto &reader : readers_) {
+            count += reader.active_.load(std::memory_order_relaxed);
+        }
+        return count;
+    }
+
+   private:
+    static constexpr size_t MASK = Capacity - 1;
+
+    struct Empty {};
+
+    struct Slot {
+        // sequence of the element, with the high bit while it is written
+        [[no_unique_address]] std::conditional_t<MODE == BroadcastMode::Lapping,
+                                                 std::atomic<uint64_t>, Empty>
+            sequence_{};
+        T data_{};
+    };
+
+    struct alignas(64) Reader {
+        std::atomic<uint64_t> sequence_{0};
+        std::atomic<bool> active_{false};
+    };
+
+    static constexpr uint64_t WRITING = uint64_t{1} << 63;
+
+    // slots the producer may write from sequence on, the consumers are only
+    // scanned if the cached minimum leaves fewer than wanted
+    size_t room(uint64_t sequence, size_t wanted) {
+        if constexpr (MODE == BroadcastMode::Lapping) {
+            return Capacity;
+        } else {
+            if (Capacity - (sequence - gatingCache_) < wanted) {
+                gatingCache_ = slowest(sequence);
+            }
+            return Capacity - (sequence - gatingCache_);
+        }
+    }
+
+    // the sequence of the slowest consumer, sequence if there is none
+    uint64_t slowest(uint64_t sequence) const {
+        uint64_t minimum = sequence;
+        for (const auto &reader : readers_) {
+            if (reader.active_.load(std::memory_order_acquire)) {
+                minimum = std::min(minimum, reader.sequence_.load(std::memory_order_acquire));
+            }
+        }
+        return minimum;
+    }
+
+    template <typename U>
+    void write(uint64_t sequence, U &&value) {
+        Slot &slot = slots_[sequence & MASK];
+        if constexpr (MODE == BroadcastMode::Lapping) {
+            slot.sequence_.store(sequence | WRITING, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            std::memcpy(&slot.data_, &value, sizeof(T));
+            slot.sequence_.store(sequence, std::memory_order_release);
+        } else {
+            slot.data_ = std::forward<U>(value);
+        }
+    }
+
+    // copies the element of sequence unless the producer overwrote it
+    bool readSlot(uint64_t sequence, void *copy) const {
+        const Slot &slot = slots_[sequence & MASK];
+        if (slot.sequence_.load(std::memory_order_acquire) != sequence) {
+            return false;
+        }
+        std::memcpy(copy, &slot.data_, sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.sequence_.load(std::memory_order_relaxed) == sequence;
+    }
+
+    std::unique_ptr<Slot[]> slots_;
+    Reader readers_[MAX_CONSUMERS];
+
+    // producer
+    alignas(64) std::atomic<uint64_t> cursor_{0};
+    uint64_t gatingCache_{0};
+};
+
+#endif  // _BROADCAST_QUEUE_H
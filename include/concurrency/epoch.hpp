@@ -0,0 +1,283 @@
+#ifndef _EPOCH_H
+#define _EPOCH_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory_resource>
+#include <stdexcept>
+#include <utility>
+
+// Epoch-based reclamation between one writer thread and reader threads.
+//
+// The writer bumps the epoch around every modification: odd while it is
+// modifying, even in between. A reader announces the epoch it read on entry
+// in its own cache line and traverses without taking any lock. Whatever the
+// writer unlinks is retired with the current epoch instead of being freed,
+// and freed only once every reader inside announced a later epoch, so a
+// reader never touches memory given back meanwhile.
+//
+// A reader also learns whether the writer ran while it was inside, see
+// Guard::validate(): like a seqlock reader it gets a consistent view or
+// knows to try again, without ever making the writer wait.
+class EpochDomain {
+    struct alignas(64) Slot {
+        // announced epoch + 1, 0 while outside
+        std::atomic<uint64_t> epoch_{0};
+        std::atomic<bool> used_{false};
+    };
+
+   public:
+    static constexpr size_t MAX_READERS = 64;
+
+    // a registered reader thread, its guards touch its slot only
+    class Reader {
+       public:
+        Reader(Reader &&other) noexcept
+            : domain_{std::exchange(other.domain_, nullptr)}, slot_{other.slot_} {}
+        Reader &operator=(Reader &&) = delete;
+
+        ~Reader() {
+            if (domain_ != nullptr) {
+                slot_->epoch_.store(0, std::memory_order_release);
+                slot_->used_.store(false, std::memory_order_release);
+            }
+        }
+
+       private:
+        friend class EpochDomain;
+
+        Reader(EpochDomain *domain, Slot *slot) : domain_{domain}, slot_{slot} {}
+
+        EpochDomain *domain_;
+        Slot *slot_;
+    };
+
+    // a read section, retired memory stays valid until it ends
+    class Guard {
+       public:
+        explicit Guard(Reader &reader)
+            : domain_{*reader.domain_}, slot_{*reader.slot_} {
+            uint64_t epoch = domain_.epoch_.load(std::memory_order_acquire);
+            for (;;) {
+                slot_.epoch_.store(epoch + 1, std::memory_order_relaxed);
+                // the writer reclaiming now either sees the announcement or
+                // bumped the epoch before, which the load below then sees
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                uint64_t current = domain_.epoch_.load(std::memory_order_acquire);
+                if (current == epoch) {
+                    break;
+                }
+                epoch = current;
+            }
+            epoch_ = epoch;
+        }
+
+        ~Guard() { slot_.epoch_.store(0, std::memory_order_release); }
+
+        Guard(const Guard &) = delete;
+        Guard &operator=(const Guard &) = delete;
+
+        // the writer did not run since the guard was taken, what was read
+        // through it so far is consistent
+        bool validate() const noexcept {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return (epoch_ & 1) == 0 &&
+                   domain_.epoch_.load(std::memory_order_relaxed) == epoch_;
+        }
+
+        uint64_t epoch() const noexcept { return epoch_; }
+
+       private:
+        EpochDomain &domain_;
+        Slot &slot_;
+        uint64_t epoch_;
+    };
+
+    // a modification of the writer, scopes nest; no-op without a domain
+    class WriteScope {
+       public:
+        explicit WriteScope(EpochDomain *domain) : domain_{domain} {
+            if (domain_ != nullptr) {
+                domain_->beginWrite();
+            }
+        }
+        ~WriteScope() {
+            if (domain_ != nullptr) {
+                domain_->endWrite();
+            }
+        }
+
+        WriteScope(const WriteScope &) = delete;
+        WriteScope &operator=(const WriteScope &) = delete;
+
+       private:
+        EpochDomain *domain_;
+    };
+
+    // reclaims when reclaimThreshold objects were retired since the last time
+    explicit EpochDomain(size_t reclaimThreshold = 64)
+        : reclaimThreshold_{reclaimThreshold}, nextReclaim_{reclaimThreshold} {}
+
+    ~EpochDomain() { drain(); }
+
+    EpochDomain(const EpochDomain &) = delete;
+    EpochDomain &operator=(const EpochDomain &) = delete;
+
+    // throws std::length_error if MAX_READERS are registered
+    Reader registerReader() {
+        for (Slot &slot : slots_) {
+            bool expected = false;
+            if (slot.used_.compare_exchange_strong(expected, true)) {
+                return Reader{this, &slot};
+            }
+        }
+        throw std::length_error("too many epoch readers");
+    }
+
+    uint64_t epoch() const noexcept { return epoch_.load(std::memory_order_acquire); }
+
+    // writer side
+
+    void beginWrite() noexcept {
+        if (writeDepth_++ == 0) {
+            uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+            epoch_.store(epoch + 1, std::memory_order_relaxed);
+            // readers validating see the odd epoch before any change
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+    }
+
+    void endWrite() {
+        if (--writeDepth_ > 0) {
+            return;
+        }
+        epoch_.store(epoch_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        if (retired_.size() >= nextReclaim_) [[unlikely]] {
+            reclaim();
+            // a reader staying inside does not make every write scan
+            nextReclaim_ = retired_.size() + reclaimThreshold_;
+        }
+    }
+
+    // frees object, given back with its size and alignment
+    using Free = void (*)(void *context, void *object, size_t bytes, size_t alignment);
+
+    // free(context, object, bytes, alignment) once no reader can reach object
+    // anymore
+    void retire(void *object, Free free, void *context, size_t bytes = 0,
+                size_t alignment = 0) {
+        retired_.push_back(
+            {epoch_.load(std::memory_order_relaxed), object, free, context, bytes, alignment});
+    }
+
+    // obj goes back to pool once no reader can reach it anymore
+    template <typename Pool>
+    void retire(Pool &pool, typename Pool::value_type *obj) {
+        retire(
+            obj,
+            [](void *context, void *object, size_t, size_t) {
+                static_cast<Pool *>(context)->deallocate(
+                    static_cast<typename Pool::value_type *>(object));
+            },
+            &pool);
+    }
+
+    // frees what no reader inside can reach, returns how many
+    size_t reclaim() {
+        // pairs with the fence of the readers entering
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint64_t oldest = epoch_.load(std::memory_order_relaxed);
+        for (const Slot &slot : slots_) {
+            uint64_t announced = slot.epoch_.load(std::memory_order_acquire);
+            if (announced != 0 && announced - 1 < oldest) {
+                oldest = announced - 1;
+            }
+        }
+
+        // retired in epoch order
+        size_t freed = 0;
+        while (!retired_.empty() && retired_.front().epoch_ < oldest) {
+            Retired retired = retired_.front();
+            retired_.pop_front();
+            retired.release();
+            freed++;
+        }
+        return freed;
+    }
+
+    // frees everything retired, no reader may be inside anymore
+    void drain() {
+        while (!retired_.empty()) {
+            Retired retired = retired_.front();
+            retired_.pop_front();
+            retired.release();
+        }
+    }
+
+    // retired and not freed yet
+    size_t retired_count() const noexcept { return retired_.size(); }
+
+   private:
+    struct Retired {
+        uint64_t epoch_;
+        void *object_;
+        Free free_;
+        void *context_;
+        size_t bytes_;
+        size_t alignment_;
+
+        void release() const { free_(context_, object_, bytes_, alignment_); }
+    };
+
+    Slot slots_[MAX_READERS];
+
+    alignas(64) std::atomic<uint64_t> epoch_{0};
+    // writer only
+    uint32_t writeDepth_{0};
+    size_t reclaimThreshold_;
+    size_t nextReclaim_;
+    std::deque<Retired> retired_;
+};
+
+// Memory resource retiring deallocated blocks to an epoch domain before they
+// go back upstream, e.g. under the ArenaBookAllocator of a book read
+// concurrently: level and order nodes stay valid for readers inside.
+// Destroying it drains the domain, no reader may be inside anymore.
+class EpochResource : public std::pmr::memory_resource {
+   public:
+    EpochResource(EpochDomain &domain, std::pmr::memory_resource *upstream)
+        : domain_{domain}, upstream_{upstream} {}
+
+    ~EpochResource() override { domain_.drain(); }
+
+    EpochResource(const EpochResource &) = delete;
+    EpochResource &operator=(const EpochResource &) = delete;
+
+    EpochDomain &domain() const { return domain_; }
+
+   private:
+    void *do_allocate(size_t bytes, size_t alignment) override {
+        return upstream_->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+        domain_.retire(
+            p,
+            [](void *context, void *object, size_t bytes, size_t alignment) {
+                static_cast<std::pmr::memory_resource *>(context)->deallocate(object, bytes,
+                                                                              alignment);
+            },
+            upstream_, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+
+    EpochDomain &domain_;
+    std::pmr::memory_resource *upstream_;
+};
+
+#endif  // _EPOCH_H
@@ -2,28 +2,37 @@
 #define _MPMC_QUEUE_H
 
 #include <atomic>
+#include <cstdint>
 #include <memory>
+#include <new>
+
+#include "waitstrategy.hpp"
 
 // multi-producer multi-consumer queue
-template <typename T, size_t Capacity = 65536>
-class MPMCQueue : private std::allocator<T> {
+//
+// Every slot has a turn ticket: 2 * turn when free for the turn's producer,
+// 2 * turn + 1 when filled for the turn's consumer. Ticket and element share
+// a slot padded to cache lines, so neighbouring slots never false share.
+// emplace and pop wait for their slot as Wait decides, try_emplace and
+// try_pop never wait and fail on a full or empty queue.
+template <typename T, size_t Capacity = 65536, WaitStrategy Wait = BusySpinWait>
+class MPMCQueue {
+    static_assert(Capacity > 0);
+
    public:
-    MPMCQueue() noexcept {
-        data_ = std::allocator_traits<std::allocator<T>>::allocate(*this, Capacity);
-        ticket_ = new std::atomic<size_t>[Capacity];
-        for (size_t i = 0; i < Capacity; ++i) {
-            ticket_[i].store(0, std::memory_order_relaxed);
-        }
-    }
+    MPMCQueue() : slots_{new Slot[Capacity]} {}
 
     // non-copyable
     MPMCQueue(const MPMCQueue &) = delete;
     MPMCQueue &operator=(const MPMCQueue &) = delete;
 
     ~MPMCQueue() {
-        std::destroy(data_, data_ + Capacity);
-        std::allocator_traits<std::allocator<T>>::deallocate(*this, data_, Capacity);
-        delete[] ticket_;
+        // filled slots hold an element
+        for (size_t i = 0; i < Capacity; ++i) {
+            if (slots_[i].ticket_.load(std::memory_order_relaxed) & 1) {
+                std::destroy_at(slots_[i].data());
+            }
+        }
     }
 
     template <typename... Args>
@@ -33,11 +42,37 @@ class MPMCQueue : private std::allocator<T> {
                       "T must be constructible with Args&&...");
 
         auto tail = tail_.fetch_add(1);  // tail: before increment
-        auto id = idx(tail);
-        while (turn(tail) * 2 != ticket_[id].load(std::memory_order_acquire));
+        Slot &slot = slots_[idx(tail)];
+        waitFor(slot, turn(tail) * 2);
+
+        fill(slot, turn(tail), std::forward<Args>(args)...);
+    }
+
+    // false if the queue is full
+    template <typename... Args>
+    bool try_emplace(Args &&...args) noexcept(
+        std::is_nothrow_constructible<T, Args &&...>::value) {
+        static_assert(std::is_constructible<T, Args &&...>::value,
+                      "T must be constructible with Args&&...");
 
-        std::construct_at(data_ + id, std::forward<Args>(args)...);
-        ticket_[id].store(turn(tail) * 2 + 1, std::memory_order_release);
+        auto tail = tail_.load(std::memory_order_acquire);
+        for (;;) {
+            Slot &slot = slots_[idx(tail)];
+            if (static_cast<uint32_t>(turn(tail) * 2) ==
+                slot.ticket_.load(std::memory_order_acquire)) {
+                if (tail_.compare_exchange_strong(tail, tail + 1)) {
+                    fill(slot, turn(tail), std::forward<Args>(args)...);
+                    return true;
+                }
+            } else {
+                // the slot is still taken, full unless tail moved meanwhile
+                auto prevTail = tail;
+                tail = tail_.load(std::memory_order_acquire);
+                if (tail == prevTail) {
+                    return false;
+                }
+            }
+        }
     }
 
     void pop(T &result) noexcept {
@@ -45,34 +80,85 @@ class MPMCQueue : private std::allocator<T> {
                       "T must be nothrow destructible");
 
         auto head = head_.fetch_add(1);
-        auto id = idx(head);
+        Slot &slot = slots_[idx(head)];
+        waitFor(slot, turn(head) * 2 + 1);
 
-        while (turn(head) * 2 + 1 != ticket_[id].load(std::memory_order_acquire));
+        drain(slot, turn(head), result);
+    }
 
-        result = std::move(data_[id]);
+    // false if the queue is empty
+    bool try_pop(T &result) noexcept {
+        static_assert(std::is_nothrow_destructible<T>::value,
+                      "T must be nothrow destructible");
 
-        ticket_[id].store(turn(head) * 2 + 2, std::memory_order_release);
+        auto head = head_.load(std::memory_order_acquire);
+        for (;;) {
+            Slot &slot = slots_[idx(head)];
+            if (static_cast<uint32_t>(turn(head) * 2 + 1) ==
+                slot.ticket_.load(std::memory_order_acquire)) {
+                if (head_.compare_exchange_strong(head, head + 1)) {
+                    drain(slot, turn(head), result);
+                    return true;
+                }
+            } else {
+                auto prevHead = head;
+                head = head_.load(std::memory_order_acquire);
+                if (head == prevHead) {
+                    return false;
+                }
+            }
+        }
     }
 
-    size_t size() const noexcept {
-        return tail_.load(std::memory_order_acquire) -
-               head_.load(std::memory_order_acquire);
+    // negative while consumers wait on an empty queue
+    ptrdiff_t size() const noexcept {
+        return static_cast<ptrdiff_t>(tail_.load(std::memory_order_acquire) -
+                                      head_.load(std::memory_order_acquire));
     }
 
-    bool empty() const noexcept {
-        return head_.load(std::memory_order_acquire) ==
-               tail_.load(std::memory_order_acquire);
-    }
+    bool empty() const noexcept { return size() <= 0; }
+
+    Wait &wait_strategy() noexcept { return wait_; }
 
    private:
+    struct alignas(64) Slot {
+        // 32 bits so it can be a futex word, turns compare modulo 2^31
+        std::atomic<uint32_t> ticket_{0};
+        alignas(T) unsigned char storage_[sizeof(T)];
+
+        T *data() noexcept { return std::launder(reinterpret_cast<T *>(storage_)); }
+    };
+
     constexpr size_t idx(size_t i) const noexcept { return i % Capacity; }
 
     constexpr size_t turn(size_t i) const noexcept { return i / Capacity; }
 
-    T *data_;
-    std::atomic<size_t> *ticket_;
-    std::atomic<size_t> head_{0};
-    std::atomic<size_t> tail_{0};
+    void waitFor(Slot &slot, size_t ticket) noexcept {
+        auto expected = static_cast<uint32_t>(ticket);
+        uint32_t current;
+        while ((current = slot.ticket_.load(std::memory_order_acquire)) != expected) {
+            wait_.wait(slot.ticket_, current);
+        }
+    }
+
+    template <typename... Args>
+    void fill(Slot &slot, size_t turn, Args &&...args) {
+        std::construct_at(reinterpret_cast<T *>(slot.storage_), std::forward<Args>(args)...);
+        slot.ticket_.store(static_cast<uint32_t>(turn * 2 + 1), std::memory_order_release);
+        wait_.notify(slot.ticket_);
+    }
+
+    void drain(Slot &slot, size_t turn, T &result) noexcept {
+        result = std::move(*slot.data());
+        std::destroy_at(slot.data());
+        slot.ticket_.store(static_cast<uint32_t>(turn * 2 + 2), std::memory_order_release);
+        wait_.notify(slot.ticket_);
+    }
+
+    std::unique_ptr<Slot[]> slots_;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    alignas(64) Wait wait_;
 };
 
-#endif  // _MPMC_QUEUE_H
\ No newline at end of file
+#endif  // _MPMC_QUEUE_H
@@ -0,0 +1,62 @@
+#ifndef _SEQLOCK_H
+#define _SEQLOCK_H
+
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+// single-writer sequence lock
+// the writer never waits, readers retry until they copy a version that was
+// not modified while being read
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+
+   public:
+    SeqLock() = default;
+
+    // non-copyable
+    SeqLock(const SeqLock &) = delete;
+    SeqLock &operator=(const SeqLock &) = delete;
+
+    // spin until a consistent copy is read
+    T load() const noexcept {
+        T result;
+        while (!tryLoad(result));
+        return result;
+    }
+
+    // returns false if a write was in progress or happened during the copy
+    bool tryLoad(T &result) const noexcept {
+        size_t seq0 = seq_.load(std::memory_order_acquire);
+        if (seq0 & 1) [[unlikely]] {
+            return false;
+        }
+        std::memcpy(&result, &data_, sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return seq0 == seq_.load(std::memory_order_relaxed);
+    }
+
+    void store(const T &value) noexcept {
+        update([&value](T &data) { data = value; });
+    }
+
+    // modify the data in place, only one thread may write
+    template <typename Fn>
+    void update(Fn &&fn) noexcept {
+        size_t seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        fn(data_);
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    // for the writer thread only
+    const T &unsafeGet() const noexcept { return data_; }
+
+   private:
+    alignas(64) std::atomic<size_t> seq_{0};
+    alignas(64) T data_{};
+};
+
+#endif  // _SEQLOCK_H
\ No newline at end of file
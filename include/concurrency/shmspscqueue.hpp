@@ -0,0 +1,276 @@
+#ifndef _SHM_SPSC_QUEUE_H
+#define _SHM_SPSC_QUEUE_H
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "util/shmsegment.h"
+
+// Single-producer single-consumer ring between two processes.
+//
+// The ring, its indices and a small header live in a shared memory segment,
+// see ShmSegment. The algorithm is the one of SPSCQueue: free-running masked
+// indices on separate cache lines, the other side's index cached in process
+// memory, bulk calls publishing with one release store. Messages are copied
+// bytewise, so T must be trivially copyable.
+//
+// Whichever process first stores its pid as the creator in the zeroed header
+// initializes the ring, the others wait for it; a creator that died before
+// finishing is taken over and the ring initialized again. Each side claims
+// its role the same way. A role held by a process that died without
+// detaching is taken over, the indices in the segment are always consistent
+// since each is written by one side only. The producer stamps a heartbeat the
+// consumer can watch to tell a silent producer from a dead or hung one.
+template <typename T, size_t Capacity = 65536>
+class ShmSPSCQueue {
+    static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+    static_assert(Capacity >= 2 && std::has_single_bit(Capacity),
+                  "Capacity must be a power of 2");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free &&
+                  std::atomic<int32_t>::is_always_lock_free);
+
+   public:
+    enum class Role : uint8_t { Producer, Consumer };
+
+    // how long attaching waits for the creator to initialize the segment
+    static constexpr std::chrono::milliseconds ATTACH_TIMEOUT{1000};
+
+    // bytes of the segment needed
+    static constexpr size_t segmentSize() { return sizeof(Layout); }
+
+    // initializes the ring if no live process did, attaches to it otherwise.
+    // Throws std::runtime_error if the segment holds another layout, its
+    // creator does not finish within ATTACH_TIMEOUT or a live process holds
+    // the role.
+    ShmSPSCQueue(ShmSegment &segment, Role role)
+        : layout_{static_cast<Layout *>(segment.data())}, role_{role} {
+        if (segment.size() < sizeof(Layout)) {
+            throw std::runtime_error("shared ring segment too small");
+        }
+        attach();
+        claim(role_ == Role::Producer ? layout_->header_.producer_
+                                      : layout_->header_.consumer_);
+        headCache_ = layout_->head_.load(std::memory_order_acquire);
+        tailCache_ = layout_->tail_.load(std::memory_order_acquire);
+        if (role_ == Role::Producer) {
+            heartbeat();
+        }
+    }
+
+    ~ShmSPSCQueue() { detach(); }
+
+    // non-copyable
+    ShmSPSCQueue(const ShmSPSCQueue &) = delete;
+    ShmSPSCQueue &operator=(const ShmSPSCQueue &) = delete;
+
+    // gives up the role, another process may attach to it
+    void detach() noexcept {
+        if (layout_ == nullptr) {
+            return;
+        }
+        int32_t pid = getpid();
+        auto &owner = role_ == Role::Producer ? layout_->header_.producer_
+                                              : layout_->header_.consumer_;
+        owner.compare_exchange_strong(pid, 0, std::memory_order_acq_rel);
+        layout_ = nullptr;
+    }
+
+    // producer side
+
+    bool push(const T &value) noexcept { return push_n(&value, 1) == 1; }
+
+    // copies up to n messages, returns how many fit
+    size_t push_n(const T *values, size_t n) noexcept {
+        size_t t = layout_->tail_.load(std::memory_order_relaxed);
+        if (Capacity - (t - headCache_) < n) {
+            headCache_ = layout_->head_.load(std::memory_order_acquire);
+            n = std::min(n, Capacity - (t - headCache_));
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            std::memcpy(slot(t + i), values + i, sizeof(T));
+        }
+        if (n > 0) {
+            layout_->tail_.store(t + n, std::memory_order_release);
+        }
+        return n;
+    }
+
+    // the producer is alive, call it at least as often as the consumer's
+    // maxSilence
+    void heartbeat() noexcept {
+        layout_->heartbeat_.store(nowNs(), std::memory_order_relaxed);
+    }
+
+    // consumer side
+
+    bool pop(T &value) noexcept { return pop_n(&value, 1) == 1; }
+
+    // copies up to n messages out, returns how many
+    size_t pop_n(T *values, size_t n) noexcept {
+        return consume(n, [&values](const T &value) {
+            std::memcpy(values++, &value, sizeof(T));
+        });
+    }
+
+    // calls f(const T &) on every message available, returns how many
+    template <typename F>
+    size_t consume_all(F &&f) {
+        return consume(Capacity, std::forward<F>(f));
+    }
+
+    // a producer is attached, its process exists and it stamped a heartbeat
+    // within maxSilence
+    bool producerAlive(std::chrono::nanoseconds maxSilence) const noexcept {
+        int32_t pid = layout_->header_.producer_.load(std::memory_order_acquire);
+        if (pid == 0 || !processAlive(pid)) {
+            return false;
+        }
+        uint64_t beat = layout_->heartbeat_.load(std::memory_order_relaxed);
+        return nowNs() - beat <= static_cast<uint64_t>(maxSilence.count());
+    }
+
+    size_t size() const noexcept {
+        return layout_->tail_.load(std::memory_order_acquire) -
+               layout_->head_.load(std::memory_order_acquire);
+    }
+
+    bool empty() const noexcept { return size() == 0; }
+
+    static constexpr size_t capacity() noexcept { return Capacity; }
+
+   private:
+    static constexpr uint64_t MAGIC = 0x53505343524e4731;  // "SPSCRNG1"
+    static constexpr size_t MASK = Capacity - 1;
+
+    struct Header {
+        // stored last by the creator, attachers wait for it
+        std::atomic<uint64_t> magic_;
+        // pid of the process initializing the ring, 0 until one claims it;
+        // zeroed bytes are a valid lock free atomic, it is never constructed
+        std::atomic<int32_t> creator_;
+        uint64_t slotSize_;
+        uint64_t capacity_;
+        // pid holding each role, 0 if none
+        std::atomic<int32_t> producer_;
+        std::atomic<int32_t> consumer_;
+    };
+
+    struct Layout {
+        Header header_;
+
+        // producer
+        alignas(64) std::atomic<uint64_t> tail_;
+        std::atomic<uint64_t> heartbeat_;  // steady clock ns, system wide
+
+        // consumer
+        alignas(64) std::atomic<uint64_t> head_;
+
+        alignas(64) alignas(T) unsigned char slots_[Capacity * sizeof(T)];
+    };
+
+    static uint64_t nowNs() noexcept {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    static bool processAlive(int32_t pid) noexcept {
+        return kill(pid, 0) == 0 || errno == EPERM;
+    }
+
+    unsigned char *slot(size_t i) noexcept { return layout_->slots_ + (i & MASK) * sizeof(T); }
+
+    void initialize() {
+        // the segment is zeroed or left by a dead creator, construct the
+        // shared words in place
+        Header &header = layout_->header_;
+        new (&header.magic_) std::atomic<uint64_t>{0};
+        header.slotSize_ = sizeof(T);
+        header.capacity_ = Capacity;
+        new (&header.producer_) std::atomic<int32_t>{0};
+        new (&header.consumer_) std::atomic<int32_t>{0};
+        new (&layout_->tail_) std::atomic<uint64_t>{0};
+        new (&layout_->heartbeat_) std::atomic<uint64_t>{0};
+        new (&layout_->head_) std::atomic<uint64_t>{0};
+        header.magic_.store(MAGIC, std::memory_order_release);
+    }
+
+    // initializes the ring as its creator, or waits for the creator
+    void attach() {
+        Header &header = layout_->header_;
+        int32_t pid = getpid();
+        auto deadline = std::chrono::steady_clock::now() + ATTACH_TIMEOUT;
+        int32_t creator = 0;
+        while (header.magic_.load(std::memory_order_acquire) != MAGIC) {
+            // free, or held by a process that died before finishing
+            if ((creator == 0 || !processAlive(creator)) &&
+                header.creator_.compare_exchange_strong(creator, pid,
+                                                        std::memory_order_acq_rel)) {
+                initialize();
+                return;
+            }
+            if (creator != 0 && std::chrono::steady_clock::now() > deadline) {
+                throw std::runtime_error("shared ring not initialized");
+            }
+            std::this_thread::yield();
+            creator = header.creator_.load(std::memory_order_acquire);
+        }
+        if (header.slotSize_ != sizeof(T) || header.capacity_ != Capacity) {
+            throw std::runtime_error("shared ring has another layout");
+        }
+    }
+
+    // takes the role if free or held by a dead process
+    void claim(std::atomic<int32_t> &owner) {
+        int32_t pid = getpid();
+        int32_t current = owner.load(std::memory_order_acquire);
+        for (;;) {
+            if (current != 0 && processAlive(current)) {
+                throw std::runtime_error("shared ring role held by a live process");
+            }
+            if (owner.compare_exchange_weak(current, pid, std::memory_order_acq_rel)) {
+                return;
+            }
+        }
+    }
+
+    template <typename F>
+    size_t consume(size_t n, F &&f) {
+        size_t h = layout_->head_.load(std::memory_order_relaxed);
+        if (tailCache_ - h < n) {
+            tailCache_ = layout_->tail_.load(std::memory_order_acquire);
+            n = std::min(n, tailCache_ - h);
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            // the slot holds the bytes of a T, copied in by the producer
+            f(*std::launder(reinterpret_cast<const T *>(slot(h + i))));
+        }
+        if (n > 0) {
+            layout_->head_.store(h + n, std::memory_order_release);
+        }
+        return n;
+    }
+
+    Layout *layout_;
+    Role role_;
+    // the other side's index as last seen, in process memory
+    size_t headCache_{0};
+    size_t tailCache_{0};
+};
+
+#endif  // _SHM_SPSC_QUEUE_H
@@ -1,12 +1,24 @@
 #ifndef _SPSC_QUEUE_H
 #define _SPSC_QUEUE_H
 
+#include <algorithm>
 #include <atomic>
+#include <bit>
 #include <memory>
+#include <utility>
 
 // Simple lock-free single-producer single-consumer queue
+//
+// head_ and tail_ count up forever and are masked into the ring. Each side
+// keeps its own index and a cached copy of the other side's index on its own
+// cache line, and reloads the other side's index only when the cached copy
+// says full or empty. The bulk calls publish a whole burst with one release
+// store.
 template <typename T, size_t Capacity = 65536>
 class SPSCQueue : private std::allocator<T> {
+    static_assert(Capacity >= 2 && std::has_single_bit(Capacity),
+                  "Capacity must be a power of 2");
+
    public:
     SPSCQueue() {
         data_ = std::allocator_traits<std::allocator<T>>::allocate(*this, Capacity);
@@ -18,12 +30,14 @@ class SPSCQueue : private std::allocator<T> {
 
     ~SPSCQueue() {
         for (size_t i = head_.load(std::memory_order_acquire);
-             i != tail_.load(std::memory_order_acquire); i = (i + 1) % Capacity) {
-            std::allocator_traits<std::allocator<T>>::destroy(*this, data_ + i);
+             i != tail_.load(std::memory_order_acquire); i++) {
+            std::allocator_traits<std::allocator<T>>::destroy(*this, data_ + (i & MASK));
         }
         std::allocator_traits<std::allocator<T>>::deallocate(*this, data_, Capacity);
     }
 
+    // producer side
+
     template <typename... Args>
     bool emplace(Args &&...args) noexcept(
         std::is_nothrow_constructible<T, Args &&...>::value) {
@@ -31,38 +45,80 @@ class SPSCQueue : private std::allocator<T> {
                       "T must be constructible with Args&&...");
 
         size_t t = tail_.load(std::memory_order_relaxed);
-        if ((t + 1) % Capacity == head_.load(std::memory_order_acquire)) {  // (1)
-            return false;
+        if (t - headCache_ == Capacity) {
+            headCache_ = head_.load(std::memory_order_acquire);  // (1)
+            if (t - headCache_ == Capacity) {
+                return false;
+            }
         }
 
-        std::allocator_traits<std::allocator<T>>::construct(*this, data_ + t,
+        std::allocator_traits<std::allocator<T>>::construct(*this, data_ + (t & MASK),
                                                             std::forward<Args>(args)...);
         // (2) synchronizes with (3)
-        tail_.store((t + 1) % Capacity, std::memory_order_release);  // (2)
+        tail_.store(t + 1, std::memory_order_release);  // (2)
         return true;
     }
 
+    // copies up to n elements from first, returns how many fit
+    template <typename InputIt>
+    size_t push_n(InputIt first, size_t n) noexcept(
+        std::is_nothrow_copy_constructible<T>::value) {
+        size_t t = tail_.load(std::memory_order_relaxed);
+        if (Capacity - (t - headCache_) < n) {
+            headCache_ = head_.load(std::memory_order_acquire);  // (1)
+            n = std::min(n, Capacity - (t - headCache_));
+        }
+
+        for (size_t i = 0; i < n; i++, ++first) {
+            std::allocator_traits<std::allocator<T>>::construct(*this, data_ + ((t + i) & MASK),
+                                                                *first);
+        }
+        if (n > 0) {
+            tail_.store(t + n, std::memory_order_release);  // (2)
+        }
+        return n;
+    }
+
+    // consumer side
+
     bool pop(T &result) noexcept {
         static_assert(std::is_nothrow_destructible<T>::value,
                       "T must be nothrow destructible");
 
         size_t h = head_.load(std::memory_order_relaxed);
-        if (h == tail_.load(std::memory_order_acquire)) {  // (3)
-            return false;
+        if (h == tailCache_) {
+            tailCache_ = tail_.load(std::memory_order_acquire);  // (3)
+            if (h == tailCache_) {
+                return false;
+            }
         }
-        result = std::move(data_[h]);
-        std::allocator_traits<std::allocator<T>>::destroy(*this, data_ + h);
-        head_.store((h + 1) % Capacity, std::memory_order_release);  // (4)
+        T *slot = data_ + (h & MASK);
+        result = std::move(*slot);
+        std::allocator_traits<std::allocator<T>>::destroy(*this, slot);
+        head_.store(h + 1, std::memory_order_release);  // (4)
         return true;
     }
 
+    // moves up to n elements to out, returns how many
+    template <typename OutputIt>
+    size_t pop_n(OutputIt out, size_t n) noexcept {
+        return consume(n, [&out](T &value) { *out++ = std::move(value); });
+    }
+
+    // calls f(T &) on every element available, returns how many
+    template <typename F>
+    size_t consume_all(F &&f) {
+        return consume(Capacity, std::forward<F>(f));
+    }
+
+    // calls f(T &) on up to n elements, returns how many
+    template <typename F>
+    size_t consume_n(size_t n, F &&f) {
+        return consume(n, std::forward<F>(f));
+    }
+
     size_t size() const noexcept {
-        size_t diff =
-            tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
-        if (diff < 0) {
-            diff += Capacity;
-        }
-        return diff;
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
     }
 
     bool empty() const noexcept {
@@ -70,10 +126,47 @@ class SPSCQueue : private std::allocator<T> {
                tail_.load(std::memory_order_acquire);
     }
 
+    static constexpr size_t capacity() noexcept { return Capacity; }
+
+    // the ring's storage, e.g. to fault it in before the queue is used
+    void *storage() noexcept { return data_; }
+    static constexpr size_t storage_bytes() noexcept { return Capacity * sizeof(T); }
+
    private:
+    static constexpr size_t MASK = Capacity - 1;
+
+    // hands up to n elements to f, frees their slots with one store
+    template <typename F>
+    size_t consume(size_t n, F &&f) {
+        static_assert(std::is_nothrow_destructible<T>::value,
+                      "T must be nothrow destructible");
+
+        size_t h = head_.load(std::memory_order_relaxed);
+        if (tailCache_ - h < n) {
+            tailCache_ = tail_.load(std::memory_order_acquire);  // (3)
+            n = std::min(n, tailCache_ - h);
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            T *slot = data_ + ((h + i) & MASK);
+            f(*slot);
+            std::allocator_traits<std::allocator<T>>::destroy(*this, slot);
+        }
+        if (n > 0) {
+            head_.store(h + n, std::memory_order_release);  // (4)
+        }
+        return n;
+    }
+
     T *data_;  // queue data
-    std::atomic<size_t> head_{0};
-    std::atomic<size_t> tail_{0};
+
+    // producer
+    alignas(64) std::atomic<size_t> tail_{0};
+    size_t headCache_{0};
+
+    // consumer
+    alignas(64) std::atomic<size_t> head_{0};
+    size_t tailCache_{0};
 };
 
-#endif  // _SPSC_QUEUE_H
\ No newline at end of file
+#endif  // _SPSC_QUEUE_H
@@ -0,0 +1,100 @@
+#ifndef _WAIT_STRATEGY_H
+#define _WAIT_STRATEGY_H
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <thread>
+
+// How a thread waits for a 32-bit word to change, chosen at compile time.
+//
+// wait(word, old) returns once word may differ from old, spurious returns are
+// allowed, the caller reloads and checks. notify(word) is called after every
+// change a waiter may wait for.
+template <typename T>
+concept WaitStrategy = requires(T t, std::atomic<uint32_t> &word, uint32_t old) {
+    t.wait(word, old);
+    t.notify(word);
+};
+
+inline void cpuRelax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// spins on the core, lowest latency, the core is never given back
+struct BusySpinWait {
+    void wait(const std::atomic<uint32_t> &word, uint32_t old) noexcept {
+        while (word.load(std::memory_order_acquire) == old) {
+            cpuRelax();
+        }
+    }
+
+    void notify(std::atomic<uint32_t> &) noexcept {}
+};
+
+// spins a while, then yields the core to other runnable threads
+template <uint32_t SPINS = 1024>
+struct SpinYieldWait {
+    void wait(const std::atomic<uint32_t> &word, uint32_t old) noexcept {
+        for (uint32_t i = 0; word.load(std::memory_order_acquire) == old; i++) {
+            if (i < SPINS) {
+                cpuRelax();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void notify(std::atomic<uint32_t> &) noexcept {}
+};
+
+// spins a while, then sleeps in the kernel until notified. notify only enters
+// the kernel while some thread sleeps, so an idle consumer costs nothing and
+// a busy queue pays one load per notify.
+template <uint32_t SPINS = 1024>
+class FutexWait {
+   public:
+    void wait(std::atomic<uint32_t> &word, uint32_t old) noexcept {
+        for (uint32_t i = 0; i < SPINS; i++) {
+            if (word.load(std::memory_order_acquire) != old) {
+                return;
+            }
+            cpuRelax();
+        }
+
+        // seq_cst pairs with notify: either the notifier sees the sleeper or
+        // the sleeper sees the new value, futex rechecks word == old
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        if (word.load(std::memory_order_seq_cst) == old) {
+            syscall(SYS_futex, &word, FUTEX_WAIT_PRIVATE, old, nullptr, nullptr, 0);
+        }
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void notify(std::atomic<uint32_t> &word) noexcept {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_relaxed) > 0) [[unlikely]] {
+            syscall(SYS_futex, &word, FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
+        }
+    }
+
+    uint32_t sleepers() const noexcept { return sleepers_.load(std::memory_order_relaxed); }
+
+   private:
+    // own line, written only by threads going to sleep
+    alignas(64) std::atomic<uint32_t> sleepers_{0};
+};
+
+static_assert(WaitStrategy<BusySpinWait>);
+static_assert(WaitStrategy<SpinYieldWait<>>);
+static_assert(WaitStrategy<FutexWait<>>);
+
+#endif  // _WAIT_STRATEGY_H
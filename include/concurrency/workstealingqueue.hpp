@@ -0,0 +1,88 @@
+#ifndef _WORK_STEALING_QUEUE_H
+#define _WORK_STEALING_QUEUE_H
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <type_traits>
+
+// Bounded run queue of one worker thread that other workers steal from.
+//
+// The owner pushes at the tail and takes from the head, so it rotates
+// through its elements in FIFO order; thieves take from the head as well,
+// with the same CAS. Only the owner writes the tail. The owner reuses a slot
+// once the head passed it, so a thief reads the element before claiming it
+// and a thief whose slot was reused meanwhile fails its CAS. T is trivially
+// copyable, e.g. a pointer to a task.
+template <typename T, size_t Capacity = 1024>
+class WorkStealingQueue {
+    static_assert(Capacity >= 2 && std::has_single_bit(Capacity),
+                  "Capacity must be a power of 2");
+    static_assert(std::is_trivially_copyable_v<T>, "thieves read elements being reused");
+
+   public:
+    WorkStealingQueue() = default;
+
+    // non-copyable
+    WorkStealingQueue(const WorkStealingQueue &) = delete;
+    WorkStealingQueue &operator=(const WorkStealingQueue &) = delete;
+
+    // owner side
+
+    // false if full
+    bool push(T value) noexcept {
+        size_t t = tail_.load(std::memory_order_relaxed);
+        if (t - head_.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        slots_[t & MASK].store(value, std::memory_order_relaxed);
+        tail_.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // the oldest element
+    bool pop(T &result) noexcept { return take(result); }
+
+    // other workers' side
+
+    // the oldest element, the one the owner would run next
+    bool steal(T &result) noexcept { return take(result); }
+
+    // a snapshot, may be stale by the time it returns
+    size_t size() const noexcept {
+        size_t h = head_.load(std::memory_order_acquire);
+        return tail_.load(std::memory_order_acquire) - h;
+    }
+
+    bool empty() const noexcept { return size() == 0; }
+
+    static constexpr size_t capacity() noexcept { return Capacity; }
+
+   private:
+    static constexpr size_t MASK = Capacity - 1;
+
+    bool take(T &result) noexcept {
+        size_t h = head_.load(std::memory_order_acquire);
+        for (;;) {
+            if (h == tail_.load(std::memory_order_acquire)) {
+                return false;
+            }
+            T value = slots_[h & MASK].load(std::memory_order_relaxed);
+            // the owner overwrites the slot only after seeing the head pass it
+            if (head_.compare_exchange_weak(h, h + 1, std::memory_order_acq_rel,
+                                            std::memory_order_acquire)) {
+                result = value;
+                return true;
+            }
+        }
+    }
+
+    std::atomic<T> slots_[Capacity]{};
+
+    // thieves and owner
+    alignas(64) std::atomic<size_t> head_{0};
+    // owner
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+#endif  // _WORK_STEALING_QUEUE_H
@@ -0,0 +1,169 @@
+#ifndef _BUDDY_ALLOCATOR_H
+#define _BUDDY_ALLOCATOR_H
+
+#include <bit>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "pageprovider.h"
+#include "singleton.hpp"
+
+// Buddy allocator of page runs in one region reserved up front.
+//
+// Blocks are 2^order pages of 2^MIN_SHIFT bytes, the region is 2^REGION_SHIFT
+// bytes aligned to its size, so every block is aligned to its own size and
+// its buddy is found by flipping one bit of its page index. Free blocks are
+// linked through their first bytes, freed memory stays mapped, so after
+// warm-up neither allocate nor deallocate enters the kernel.
+template <size_t MIN_SHIFT = 12, size_t REGION_SHIFT = 32>
+class BuddyAllocator : public Singleton<BuddyAllocator<MIN_SHIFT, REGION_SHIFT>> {
+    friend class Singleton<BuddyAllocator<MIN_SHIFT, REGION_SHIFT>>;
+
+    static_assert(MIN_SHIFT >= 4 && REGION_SHIFT > MIN_SHIFT);
+    static_assert(REGION_SHIFT - MIN_SHIFT < 255);
+
+   public:
+    static constexpr size_t MIN_BLOCK = size_t{1} << MIN_SHIFT;
+    static constexpr size_t REGION_SIZE = size_t{1} << REGION_SHIFT;
+    static constexpr size_t MAX_ORDER = REGION_SHIFT - MIN_SHIFT;
+
+    // forbid copy
+    BuddyAllocator(const BuddyAllocator &) = delete;
+    BuddyAllocator &operator=(const BuddyAllocator &) = delete;
+
+    // a block of at least size bytes aligned to its power of 2 size,
+    // nullptr if the region is exhausted
+    void *allocate(size_t size) {
+        size_t order = orderOf(size);
+        if (order > MAX_ORDER) [[unlikely]] {
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock(mtx);
+        size_t k = order;
+        while (k <= MAX_ORDER && free_[k] == nullptr) {
+            k++;
+        }
+        if (k > MAX_ORDER) [[unlikely]] {
+            return nullptr;
+        }
+
+        FreeBlock *block = free_[k];
+        unlink(block, k);
+        // split, the upper halves go back as free buddies
+        size_t page = pageOf(block);
+        while (k > order) {
+            k--;
+            link(blockAt(page + (size_t{1} << k)), k);
+        }
+        freeBytes_ -= MIN_BLOCK << order;
+        return block;
+    }
+
+    // size must be the one passed to allocate
+    void deallocate(void *ptr, size_t size) {
+        size_t order = orderOf(size);
+        size_t page = pageOf(ptr);
+
+        std::lock_guard<std::mutex> lock(mtx);
+        freeBytes_ += MIN_BLOCK << order;
+        // merge with free buddies
+        while (order < MAX_ORDER) {
+            size_t buddy = page ^ (size_t{1} << order);
+            if (freeOrder_[buddy] != order + 1) {
+                break;
+            }
+            unlink(blockAt(buddy), order);
+            page &= ~(size_t{1} << order);
+            order++;
+        }
+        link(blockAt(page), order);
+    }
+
+    size_t free_bytes() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return freeBytes_;
+    }
+
+    bool owns(const void *ptr) const {
+        return ptr >= base_ && ptr < base_ + REGION_SIZE;
+    }
+
+   protected:
+    BuddyAllocator() : freeOrder_(size_t{1} << MAX_ORDER, 0) {
+        std::lock_guard<std::mutex> lock(mtx);
+        // only touched pages are backed
+        base_ = static_cast<char *>(
+            PageProvider::process().map(REGION_SIZE, REGION_SIZE, PoolMapNoReserve));
+        link(blockAt(0), MAX_ORDER);
+        freeBytes_ = REGION_SIZE;
+    }
+
+    ~BuddyAllocator() {
+        std::lock_guard<std::mutex> lock(mtx);
+        PageProvider::process().unmap(base_, REGION_SIZE);
+    }
+
+   private:
+    struct FreeBlock {
+        FreeBlock *prev_;
+        FreeBlock *next_;
+    };
+
+    static size_t orderOf(size_t size) {
+        size_t bytes = size < MIN_BLOCK ? MIN_BLOCK : std::bit_ceil(size);
+        return std::countr_zero(bytes) - MIN_SHIFT;
+    }
+
+    size_t pageOf(const void *ptr) const {
+        return (static_cast<const char *>(ptr) - base_) >> MIN_SHIFT;
+    }
+
+    FreeBlock *blockAt(size_t page) const {
+        return reinterpret_cast<FreeBlock *>(base_ + (page << MIN_SHIFT));
+    }
+
+    void link(FreeBlock *block, size_t order) {
+        block->prev_ = nullptr;
+        block->next_ = free_[order];
+        if (free_[order] != nullptr) {
+            free_[order]->prev_ = block;
+        }
+        free_[order] = block;
+        freeOrder_[pageOf(block)] = order + 1;
+    }
+
+    void unlink(FreeBlock *block, size_t order) {
+        if (block->prev_ != nullptr) {
+            block->prev_->next_ = block->next_;
+        } else {
+            free_[order] = block->next_;
+        }
+        if (block->next_ != nullptr) {
+            block->next_->prev_ = block->prev_;
+        }
+        freeOrder_[pageOf(block)] = 0;
+    }
+
+    char *base_{nullptr};
+    FreeBlock *free_[MAX_ORDER + 1]{};
+    // order + 1 of the free block starting at each page, 0 if none
+    std::vector<uint8_t> freeOrder_;
+    size_t freeBytes_{0};
+    std::mutex mtx;
+};
+
+// page allocator interface for slabs, every slab type shares one region
+template <size_t MIN_SHIFT = 12, size_t REGION_SHIFT = 32>
+struct BuddyPageAllocator {
+    void *allocate(size_t size) {
+        return BuddyAllocator<MIN_SHIFT, REGION_SHIFT>::GetInst().allocate(size);
+    }
+
+    void deallocate(void *page, size_t size) {
+        BuddyAllocator<MIN_SHIFT, REGION_SHIFT>::GetInst().deallocate(page, size);
+    }
+};
+
+#endif  // _BUDDY_ALLOCATOR_H
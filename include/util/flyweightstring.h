@@ -26,8 +26,11 @@ class FlyweightString {
 
     bool operator==(const FlyweightString& other) const { return value == other.value; }
     bool operator!=(const FlyweightString& other) const { return value != other.value; }
-    bool operator<(const FlyweightString& other) const { return value < other.value; }
-    bool operator>(const FlyweightString& other) const { return value > other.value; }
+    // by the strings, not by the addresses in the pool
+    bool operator<(const FlyweightString& other) const {
+        return value != other.value && *value < *other.value;
+    }
+    bool operator>(const FlyweightString& other) const { return other < *this; }
 
     friend std::ostream& operator<<(std::ostream& os, const FlyweightString& str) {
         return os << *str.value;
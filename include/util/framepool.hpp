@@ -0,0 +1,65 @@
+#ifndef _FRAMEPOOL_H
+#define _FRAMEPOOL_H
+
+#include <cstddef>
+#include <new>
+
+#include "objectpool.hpp"
+
+// Storage of coroutine frames, for the operator new and delete of a promise
+// type. A frame is served by the process-wide ObjectPool of the smallest size
+// class it fits in, larger ones by the heap, so starting and ending
+// coroutines recycles the same few blocks.
+class FramePool {
+   public:
+    static void *allocate(size_t bytes) { return allocateFrom<256, 512, 1024, 2048, 4096>(bytes); }
+
+    static void deallocate(void *frame, size_t bytes) {
+        deallocateFrom<256, 512, 1024, 2048, 4096>(frame, bytes);
+    }
+
+    // bytes of the size classes handed out and not returned
+    static size_t used_bytes() { return usedFrom<256, 512, 1024, 2048, 4096>(); }
+
+   private:
+    template <size_t N>
+    struct alignas(std::max_align_t) Block {
+        // left uninitialized, the frame is constructed over it
+        Block() {}
+        std::byte bytes_[N];
+    };
+
+    // about 1MB per chunk
+    template <size_t N>
+    using Pool = ObjectPool<Block<N>, (1 << 20) / N>;
+
+    template <size_t N, size_t... LARGER>
+    static void *allocateFrom(size_t bytes) {
+        if (bytes <= N) {
+            return Pool<N>::GetInst().allocate();
+        }
+        if constexpr (sizeof...(LARGER) > 0) {
+            return allocateFrom<LARGER...>(bytes);
+        } else {
+            return ::operator new(bytes);
+        }
+    }
+
+    template <size_t N, size_t... LARGER>
+    static void deallocateFrom(void *frame, size_t bytes) {
+        if (bytes <= N) {
+            Pool<N>::GetInst().deallocate(static_cast<Block<N> *>(frame));
+        } else if constexpr (sizeof...(LARGER) > 0) {
+            deallocateFrom<LARGER...>(frame, bytes);
+        } else {
+            ::operator delete(frame, bytes);
+        }
+    }
+
+    template <size_t... N>
+    static size_t usedFrom() {
+        return (Pool<N>::GetInst().used_bytes() + ...);
+    }
+};
+
+#endif  // _FRAMEPOOL_H
@@ -0,0 +1,71 @@
+#include "interntable.h"
+
+#include <bit>
+#include <stdexcept>
+
+InternTable::InternTable(size_t capacity)
+    : capacity_{capacity},
+      // at most half full, probe sequences stay short
+      mask_{std::bit_ceil(capacity * 2) - 1},
+      slots_{std::make_unique<std::atomic<uint64_t>[]>(mask_ + 1)},
+      strings_{std::make_unique<const std::string*[]>(capacity)} {
+    if (capacity == 0 || capacity >= InvalidHandle) {
+        throw std::invalid_argument("bad intern table capacity");
+    }
+}
+
+InternTable::Handle InternTable::intern(std::string_view str) {
+    size_t hash = std::hash<std::string_view>{}(str);
+    Handle handle;
+    probe(str, hash, handle);
+    if (handle != InvalidHandle) [[likely]] {
+        return handle;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // may have been added meanwhile
+    size_t slot = probe(str, hash, handle);
+    if (handle != InvalidHandle) {
+        return handle;
+    }
+
+    size_t count = size_.load(std::memory_order_relaxed);
+    if (count == capacity_) [[unlikely]] {
+        throw std::length_error("intern table full");
+    }
+    handle = static_cast<Handle>(count);
+    strings_[handle] = &storage_.emplace_back(str);
+    // publishes the string to readers finding the slot
+    slots_[slot].store((hash >> 32) << 32 | (uint64_t{handle} + 1), std::memory_order_release);
+    size_.store(count + 1, std::memory_order_release);
+    return handle;
+}
+
+InternTable::Handle InternTable::find(std::string_view str) const {
+    Handle handle;
+    probe(str, std::hash<std::string_view>{}(str), handle);
+    return handle;
+}
+
+size_t InternTable::probe(std::string_view str, size_t hash, Handle& handle) const {
+    uint64_t tag = hash >> 32;
+    for (size_t i = hash & mask_;; i = (i + 1) & mask_) {
+        uint64_t slot = slots_[i].load(std::memory_order_acquire);
+        if (slot == 0) {
+            handle = InvalidHandle;
+            return i;
+        }
+        if (slot >> 32 == tag) {
+            Handle candidate = static_cast<Handle>(slot) - 1;
+            if (*strings_[candidate] == str) {
+                handle = candidate;
+                return i;
+            }
+        }
+    }
+}
+
+InternTable& InternTable::symbols() {
+    static InternTable table;
+    return table;
+}
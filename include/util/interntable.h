@@ -0,0 +1,113 @@
+#ifndef _INTERNTABLE_H
+#define _INTERNTABLE_H
+
+#include <atomic>
+#include <compare>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+// Interning table of symbols and other repeated strings.
+//
+// Every distinct string gets a dense 32-bit handle, handle -> string is an
+// array lookup. The hash table is open addressed with one atomic word per
+// slot (hash tag and handle), so looking up a string already interned takes
+// no lock; adding a new one takes a mutex. Strings are never removed and the
+// capacity is fixed, the table never rehashes under its readers.
+class InternTable {
+   public:
+    using Handle = uint32_t;
+    static constexpr Handle InvalidHandle = ~Handle{0};
+
+    explicit InternTable(size_t capacity = 1 << 16);
+
+    InternTable(const InternTable&) = delete;
+    InternTable& operator=(const InternTable&) = delete;
+
+    // the handle of str, added if new, throws std::length_error when full
+    Handle intern(std::string_view str);
+
+    // InvalidHandle if str was never interned, never locks
+    Handle find(std::string_view str) const;
+
+    // handle must come from this table
+    const std::string& str(Handle handle) const { return *strings_[handle]; }
+
+    size_t size() const { return size_.load(std::memory_order_acquire); }
+    size_t capacity() const { return capacity_; }
+
+    // the process-wide table of Symbol
+    static InternTable& symbols();
+
+   private:
+    // the slot holding str, or the empty slot ending its probe sequence
+    size_t probe(std::string_view str, size_t hash, Handle& handle) const;
+
+    size_t capacity_;
+    size_t mask_;
+    // hash tag << 32 | handle + 1, 0 if empty
+    std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+    std::unique_ptr<const std::string*[]> strings_;
+    std::atomic<size_t> size_{0};
+
+    // element addresses are stable
+    std::deque<std::string> storage_;
+    // serializes adding strings
+    std::mutex mutex_;
+};
+
+// 4 byte interned string of the process-wide table. Equality and hashing use
+// the handle only, ordering is by the strings. A default constructed symbol
+// is invalid: it prints empty and orders before every valid one.
+class Symbol {
+   public:
+    Symbol() = default;
+    explicit Symbol(std::string_view str) : handle_{InternTable::symbols().intern(str)} {}
+
+    // a symbol only if str was interned before, never locks
+    static Symbol find(std::string_view str) {
+        Symbol symbol;
+        symbol.handle_ = InternTable::symbols().find(str);
+        return symbol;
+    }
+
+    bool valid() const { return handle_ != InternTable::InvalidHandle; }
+    InternTable::Handle handle() const { return handle_; }
+    // empty for an invalid symbol
+    const std::string& str() const {
+        static const std::string empty;
+        return valid() ? InternTable::symbols().str(handle_) : empty;
+    }
+
+    bool operator==(const Symbol& other) const { return handle_ == other.handle_; }
+
+    std::strong_ordering operator<=>(const Symbol& other) const {
+        if (handle_ == other.handle_) {
+            return std::strong_ordering::equal;
+        }
+        // invalid symbols first, apart from an interned empty string
+        if (!valid() || !other.valid()) {
+            return valid() ? std::strong_ordering::greater : std::strong_ordering::less;
+        }
+        return str() <=> other.str();
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const Symbol& symbol) {
+        return os << symbol.str();
+    }
+
+   private:
+    InternTable::Handle handle_{InternTable::InvalidHandle};
+};
+
+template <>
+struct std::hash<Symbol> {
+    size_t operator()(const Symbol& symbol) const noexcept { return symbol.handle(); }
+};
+
+#endif  // _INTERNTABLE_H
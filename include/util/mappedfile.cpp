@@ -0,0 +1,131 @@
+#include "mappedfile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+namespace {
+
+[[noreturn]] void throwErrno(const char *what, int err = errno) {
+    throw std::system_error(err, std::generic_category(), what);
+}
+
+size_t pageSize() {
+    static const size_t size = sysconf(_SC_PAGESIZE);
+    return size;
+}
+
+size_t pageFloor(size_t offset) { return offset & ~(pageSize() - 1); }
+
+}  // namespace
+
+MappedAppendFile::MappedAppendFile(const std::string &path, size_t offset, size_t window)
+    : windowBytes_{std::max(pageFloor(window + pageSize() - 1), pageSize())},
+      size_{offset},
+      synced_{offset} {
+    fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        throwErrno("open");
+    }
+    if (ftruncate(fd_, offset) != 0) {
+        int err = errno;
+        close(fd_);
+        throwErrno("ftruncate", err);
+    }
+    allocated_ = offset;
+    try {
+        map(offset);
+    } catch (...) {
+        close(fd_);
+        throw;
+    }
+}
+
+MappedAppendFile::~MappedAppendFile() {
+    try {
+        sync();
+    } catch (const std::system_error &) {
+        // nothing to report it to
+    }
+    release();
+}
+
+void MappedAppendFile::append(const void *data, size_t bytes) {
+    const char *from = static_cast<const char *>(data);
+    while (bytes > 0) {
+        size_t end = windowStart_ + windowBytes_;
+        if (size_ == end) [[unlikely]] {
+            map(size_);
+            continue;
+        }
+        size_t n = std::min(bytes, end - size_);
+        std::memcpy(window_ + (size_ - windowStart_), from, n);
+        size_ += n;
+        from += n;
+        bytes -= n;
+    }
+}
+
+void MappedAppendFile::sync() {
+    if (size_ > synced_) {
+        // earlier windows were synced when they were unmapped
+        size_t start = pageFloor(std::max(synced_, windowStart_));
+        if (msync(window_ + (start - windowStart_), size_ - start, MS_SYNC) != 0) {
+            throwErrno("msync");
+        }
+        synced_ = size_;
+    }
+    if (grown_) {
+        // the new size is metadata msync does not cover
+        if (fdatasync(fd_) != 0) {
+            throwErrno("fdatasync");
+        }
+        grown_ = false;
+    }
+}
+
+void MappedAppendFile::map(size_t offset) {
+    if (window_ != nullptr) {
+        sync();
+        munmap(window_, windowBytes_);
+        window_ = nullptr;
+    }
+
+    size_t start = pageFloor(offset);
+    size_t end = start + windowBytes_;
+    if (end > allocated_) {
+        // blocks allocated now are not allocated while syncing
+        if (int err = posix_fallocate(fd_, allocated_, end - allocated_); err != 0) {
+            throwErrno("posix_fallocate", err);
+        }
+        allocated_ = end;
+        grown_ = true;
+    }
+
+    void *window = mmap(nullptr, windowBytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, start);
+    if (window == MAP_FAILED) {
+        throwErrno("mmap");
+    }
+    window_ = static_cast<char *>(window);
+    windowStart_ = start;
+}
+
+void MappedAppendFile::release() noexcept {
+    if (window_ != nullptr) {
+        munmap(window_, windowBytes_);
+        window_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        // the blocks allocated ahead are not part of the file
+        if (ftruncate(fd_, size_) == 0 && allocated_ != size_) {
+            fdatasync(fd_);
+        }
+        close(fd_);
+        fd_ = -1;
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef _MAPPEDFILE_H
+#define _MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+// An append-only file written through a memory mapping.
+//
+// A window of the file is mapped at a time, appends are plain copies into it
+// and the window slides forward as it fills; the file is extended with
+// allocated blocks a window ahead, so appends never wait for the disk.
+// sync() makes everything appended so far durable. On destruction the file
+// is synced and cut to what was appended. Throws std::system_error.
+class MappedAppendFile {
+   public:
+    static constexpr size_t DEFAULT_WINDOW = 64 << 20;
+
+    // opens or creates path and appends from offset on, whatever follows
+    // offset is dropped; window is rounded up to whole pages
+    MappedAppendFile(const std::string &path, size_t offset, size_t window = DEFAULT_WINDOW);
+    ~MappedAppendFile();
+
+    MappedAppendFile(const MappedAppendFile &) = delete;
+    MappedAppendFile &operator=(const MappedAppendFile &) = delete;
+
+    void append(const void *data, size_t bytes);
+
+    // msync of what was appended since the last sync, plus fdatasync if the
+    // file grew meanwhile
+    void sync();
+
+    // bytes in the file, synced or not
+    size_t size() const { return size_; }
+    size_t synced() const { return synced_; }
+
+   private:
+    // maps the window holding offset, the previous one is synced first
+    void map(size_t offset);
+    void release() noexcept;
+
+    int fd_{-1};
+    char *window_{nullptr};
+    size_t windowStart_{0};  // file offset of window_, page aligned
+    size_t windowBytes_;
+    size_t allocated_{0};  // file size on disk, the end of the last window
+    size_t size_;
+    size_t synced_;
+    bool grown_{false};
+};
+
+#endif  // _MAPPEDFILE_H
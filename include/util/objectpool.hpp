@@ -1,23 +1,68 @@
 #ifndef _OBJECTPOOL_H
 #define _OBJECTPOOL_H
 
-#include <sys/mman.h>
-
 #include <concepts>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <unordered_set>
 #include <vector>
 
+#include "pageprovider.h"
+#include "poolmutex.hpp"
+#include "pooltracking.hpp"
 #include "singleton.hpp"
 
-template <typename T, size_t BLOCK_SIZE = (1 << 12)>
-class ObjectPool : public Singleton<ObjectPool<T, BLOCK_SIZE>> {
-    friend class Singleton<ObjectPool<T, BLOCK_SIZE>>;
+// Object pool growing by chunks of BLOCK_SIZE objects.
+//
+// A chunk is mapped on demand when the free list and the current chunk are
+// exhausted, so allocation never falls back to the heap and never copies
+// existing slots. Chunks are aligned to 2MB regions they own exclusively,
+// which makes the membership check a single lookup of the region id.
+// Chunks come from the process page provider, mapped as MAP_FLAGS asks; with
+// huge pages a region is resident whole, so a chunk fills its regions with
+// more than BLOCK_SIZE objects.
+//
+// Tracking decides the per-object bookkeeping, see pooltracking.hpp.
+//
+// GetInst() is the process-wide pool of the type. A book or shard thread can
+// own its own instance instead, mapped from its own provider; with
+// SingleOwnerMutex such an instance takes no lock, see poolmutex.hpp.
+template <typename T, size_t BLOCK_SIZE = (1 << 12), unsigned MAP_FLAGS = PoolMapDefault,
+          PoolTrackingPolicy Tracking = DefaultPoolTracking, typename Mutex = std::mutex>
+class ObjectPool : public Singleton<ObjectPool<T, BLOCK_SIZE, MAP_FLAGS, Tracking, Mutex>> {
+    static_assert(BLOCK_SIZE > 0);
 
    public:
     using value_type = T;
 
+    explicit ObjectPool(PageProvider &provider = PageProvider::process())
+        : provider_{provider} {
+        std::lock_guard<Mutex> lock(mtx);
+        newChunk();
+    }
+
+    ~ObjectPool() {
+        std::lock_guard<Mutex> lock(mtx);
+        // handle objs not returned
+        tracker_.reportLeaks("ObjectPool");
+        for (void *chunk : chunks_) {
+            char *begin = static_cast<char *>(chunk);
+            char *end = chunk == chunks_.back() ? bump_ : begin + CHUNK_USED;
+            for (char *slot = begin; slot != end; slot += SLOT_SIZE) {
+                if (tracker_.isLive(slot)) {
+                    reinterpret_cast<T *>(slot + HEADER_OFFSET)->~T();
+                }
+            }
+        }
+
+        // every free slot is not constructed
+        // so we can just do unmap
+        for (void *chunk : chunks_) {
+            provider_.unmap(chunk, CHUNK_BYTES);
+        }
+    }
+
     // forbid copy
     ObjectPool(const ObjectPool &) = delete;
     ObjectPool &operator=(const ObjectPool &) = delete;
@@ -25,89 +70,145 @@ class ObjectPool : public Singleton<ObjectPool<T, BLOCK_SIZE>> {
     // allocate object
     template <typename... Args>
     T *allocate(Args &&...args) {
-        std::lock_guard<std::mutex> lock(mtx);
-
-        T *obj = nullptr;
-        // if pool is not empty, return the last object
-        if (!objList_.empty()) [[likely]] {
-            obj = objList_.back();
-            objList_.pop_back();
-            new (obj) T{std::forward<Args>(args)...};
+        std::lock_guard<Mutex> lock(mtx);
+
+        char *slot;
+        if (freeList_ != nullptr) [[likely]] {
+            slot = reinterpret_cast<char *>(freeList_) - HEADER_OFFSET;
+            freeList_ = freeList_->next_;
+            freeCount_--;
         } else {
-            // if pool is empty, create a new object
-            obj = new T{std::forward<Args>(args)...};
+            if (bump_ == bumpEnd_) [[unlikely]] {
+                newChunk();
+            }
+            slot = bump_;
+            bump_ += SLOT_SIZE;
         }
-        unreturned_.insert(obj);
-        return obj;
+
+        tracker_.onAllocate(slot);
+        return new (slot + HEADER_OFFSET) T{std::forward<Args>(args)...};
     }
 
-    // release object
+    // release object, obj comes from this pool; checked builds ignore any
+    // other pointer before touching the header in front of it
     void deallocate(T *obj) {
-        std::lock_guard<std::mutex> lock(mtx);
+        std::lock_guard<Mutex> lock(mtx);
 
-        auto it = unreturned_.find(obj);
-        if (it == unreturned_.end()) [[unlikely]] {
+        if (obj == nullptr) [[unlikely]] {
             return;
         }
-        unreturned_.erase(it);
-
-        if (isMmapAllocated(obj)) [[likely]] {
-            obj->~T();
-            objList_.push_back(obj);
+#ifndef NDEBUG
+        if (!ownsLocked(obj)) [[unlikely]] {
             return;
         }
-        // allocated by new
-        delete obj;
+#endif
+        if (!tracker_.onDeallocate(reinterpret_cast<char *>(obj) - HEADER_OFFSET)) [[unlikely]] {
+            return;
+        }
+
+        obj->~T();
+        auto *node = reinterpret_cast<FreeNode *>(obj);
+        node->next_ = freeList_;
+        freeList_ = node;
+        freeCount_++;
     }
 
+    // objects available without mapping a new chunk
     size_t size() {
-        std::lock_guard<std::mutex> lock(mtx);
-        return objList_.size();
+        std::lock_guard<Mutex> lock(mtx);
+        return freeCount_ + (bumpEnd_ - bump_) / SLOT_SIZE;
     }
 
-   protected:
-    ObjectPool() {
-        std::lock_guard<std::mutex> lock(mtx);
-        void *map = mmap(0, sizeof(T) * BLOCK_SIZE, PROT_READ | PROT_WRITE,
-                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-        if (map == MAP_FAILED) {
-            throw std::runtime_error("fail to alloc pool buffer");
-        }
+    size_t chunk_count() {
+        std::lock_guard<Mutex> lock(mtx);
+        return chunks_.size();
+    }
 
-        buffer_ = reinterpret_cast<T *>(map);
-        objList_.reserve(BLOCK_SIZE);
-        T *tmp = buffer_;
-        for (int i = 0; i < BLOCK_SIZE; i++) {
-            objList_.push_back(tmp);
-            tmp++;
-        }
+    size_t mapped_bytes() {
+        std::lock_guard<Mutex> lock(mtx);
+        return chunks_.size() * CHUNK_BYTES;
     }
 
-    ~ObjectPool() {
-        std::lock_guard<std::mutex> lock(mtx);
-        // handle objs not returned
-        for (auto obj : unreturned_) {
-            if (isMmapAllocated(obj)) {
-                obj->~T();
-            } else {
-                delete obj;
-            }
-        }
+    // slots handed out and not returned
+    size_t used_bytes() {
+        std::lock_guard<Mutex> lock(mtx);
+        size_t available = freeCount_ + (bumpEnd_ - bump_) / SLOT_SIZE;
+        return (chunks_.size() * CHUNK_SLOTS - available) * SLOT_SIZE;
+    }
 
-        // every element in freeeList is not constructed
-        // so we can just do unmap
-        munmap(buffer_, sizeof(T) * BLOCK_SIZE);
+    // O(1): chunks own whole regions, nothing else is mapped in them
+    bool owns(const T *obj) {
+        std::lock_guard<Mutex> lock(mtx);
+        return ownsLocked(obj);
     }
 
+    PageProvider &provider() const { return provider_; }
+
    private:
-    bool isMmapAllocated(T *obj) const {
-        return (obj >= buffer_ && obj < buffer_ + BLOCK_SIZE);
+    struct FreeNode {
+        FreeNode *next_;
+    };
+
+    static constexpr size_t SLOT_ALIGN =
+        alignof(T) > alignof(FreeNode) ? alignof(T) : alignof(FreeNode);
+    // a free object links the free list, the tracking header stays intact
+    static constexpr size_t HEADER_OFFSET =
+        (Tracking::HEADER_SIZE + SLOT_ALIGN - 1) / SLOT_ALIGN * SLOT_ALIGN;
+    static constexpr size_t SLOT_SIZE =
+        (HEADER_OFFSET + (sizeof(T) > sizeof(FreeNode) ? sizeof(T) : sizeof(FreeNode)) +
+         SLOT_ALIGN - 1) /
+        SLOT_ALIGN * SLOT_ALIGN;
+
+    static constexpr size_t REGION_SHIFT = 21;
+    static constexpr size_t REGION_SIZE = size_t{1} << REGION_SHIFT;
+    static constexpr size_t CHUNK_BYTES =
+        (SLOT_SIZE * BLOCK_SIZE + REGION_SIZE - 1) & ~(REGION_SIZE - 1);
+
+   public:
+    // objects of a chunk
+    static constexpr size_t CHUNK_SLOTS =
+        (MAP_FLAGS & (PoolMapHugeTlb | PoolMapTransparentHuge)) != 0 ? CHUNK_BYTES / SLOT_SIZE
+                                                                     : BLOCK_SIZE;
+
+   private:
+    static constexpr size_t CHUNK_USED = SLOT_SIZE * CHUNK_SLOTS;
+
+    static_assert(SLOT_ALIGN <= REGION_SIZE);
+
+    bool ownsLocked(const T *obj) const {
+        return regions_.contains(reinterpret_cast<uintptr_t>(obj) >> REGION_SHIFT);
+    }
+
+    void newChunk() {
+        // prefault and lock only the slots that can be handed out
+        constexpr unsigned USED_ONLY = PoolMapPopulate | PoolMapLock;
+        void *chunk = provider_.map(CHUNK_BYTES, REGION_SIZE, MAP_FLAGS & ~USED_ONLY);
+        if constexpr ((MAP_FLAGS & PoolMapPopulate) != 0) {
+            provider_.prefault(chunk, CHUNK_USED);
+        }
+        if constexpr ((MAP_FLAGS & PoolMapLock) != 0) {
+            provider_.lock(chunk, CHUNK_USED);
+        }
+
+        chunks_.push_back(chunk);
+        uintptr_t region = reinterpret_cast<uintptr_t>(chunk) >> REGION_SHIFT;
+        for (size_t i = 0; i < CHUNK_BYTES >> REGION_SHIFT; i++) {
+            regions_.insert(region + i);
+        }
+
+        bump_ = static_cast<char *>(chunk);
+        bumpEnd_ = bump_ + CHUNK_USED;
     }
 
-    std::vector<T *> objList_;
-    std::unordered_set<T *> unreturned_;
-    T *buffer_;
-    std::mutex mtx;
+    PageProvider &provider_;
+    FreeNode *freeList_{nullptr};
+    size_t freeCount_{0};
+    char *bump_{nullptr};
+    char *bumpEnd_{nullptr};
+    std::vector<void *> chunks_;
+    std::unordered_set<uintptr_t> regions_;
+    Tracking tracker_;
+    Mutex mtx;
 };
 
-#endif  // _OBJECTPOOL_H
\ No newline at end of file
+#endif  // _OBJECTPOOL_H
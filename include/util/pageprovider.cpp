@@ -0,0 +1,209 @@
+#include "pageprovider.h"
+
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+constexpr size_t HUGE_PAGE_SIZE = size_t{2} << 20;
+
+size_t pageSize() {
+    static const size_t size = sysconf(_SC_PAGESIZE);
+    return size;
+}
+
+// highest node of a sysfs list such as "0-1,3"
+int parseNodeCount(const std::string &list) {
+    int count = 1;
+    size_t pos = 0;
+    while (pos < list.size()) {
+        size_t end = list.find_first_of(",\n", pos);
+        std::string range = list.substr(pos, end == std::string::npos ? end : end - pos);
+        size_t dash = range.find('-');
+        std::string last = dash == std::string::npos ? range : range.substr(dash + 1);
+        if (!last.empty()) {
+            count = std::max(count, std::stoi(last) + 1);
+        }
+        if (end == std::string::npos) {
+            break;
+        }
+        pos = end + 1;
+    }
+    return count;
+}
+
+}  // namespace
+
+SystemNumaTopology &SystemNumaTopology::instance() {
+    static SystemNumaTopology topology;
+    return topology;
+}
+
+SystemNumaTopology::SystemNumaTopology() {
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string list;
+    if (std::getline(online, list)) {
+        nodeCount_ = parseNodeCount(list);
+    }
+}
+
+int SystemNumaTopology::nodeOfCpu(int cpu) const {
+    // the cpu directory has a nodeN link
+    std::error_code ec;
+    std::filesystem::path dir{"/sys/devices/system/cpu/cpu" + std::to_string(cpu)};
+    for (const auto &entry : std::filesystem::directory_iterator(dir, ec)) {
+        std::string name = entry.path().filename();
+        if (name.starts_with("node")) {
+            return std::stoi(name.substr(4));
+        }
+    }
+    return 0;
+}
+
+bool SystemNumaTopology::bindMemory(void *addr, size_t bytes, int node) {
+    unsigned long mask = 1UL << node;
+    return syscall(SYS_mbind, addr, bytes, MPOL_BIND, &mask, sizeof(mask) * 8, 0) == 0;
+}
+
+bool SystemNumaTopology::preferNode(int node) {
+    unsigned long mask = 1UL << node;
+    return syscall(SYS_set_mempolicy, MPOL_PREFERRED, &mask, sizeof(mask) * 8) == 0;
+}
+
+PageProvider::PageProvider(int node, NumaTopology &topology)
+    : node_{node}, topology_{topology} {
+    if (node != AnyNode && (node < 0 || node >= topology.nodeCount())) {
+        throw std::invalid_argument("no such NUMA node");
+    }
+}
+
+void *PageProvider::map(size_t bytes, size_t align, unsigned flags) {
+    size_t page = pageSize();
+    bytes = (bytes + page - 1) / page * page;
+    align = align < page ? page : align;
+    if ((flags & PoolMapHugeTlb) && bytes % HUGE_PAGE_SIZE == 0 && align < HUGE_PAGE_SIZE) {
+        // huge pages only back a huge page aligned range
+        align = HUGE_PAGE_SIZE;
+    }
+
+    int mmapFlags = MAP_PRIVATE | MAP_ANONYMOUS;
+    if (flags & PoolMapNoReserve) {
+        mmapFlags |= MAP_NORESERVE;
+    }
+
+    // over-map to get an aligned range, then trim
+    size_t reserve = align > page ? bytes + align : bytes;
+    void *map = mmap(0, reserve, PROT_READ | PROT_WRITE, mmapFlags, -1, 0);
+    if (map == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    uintptr_t begin = reinterpret_cast<uintptr_t>(map);
+    uintptr_t aligned = (begin + align - 1) & ~(align - 1);
+    if (aligned > begin) {
+        munmap(map, aligned - begin);
+    }
+    if (begin + reserve > aligned + bytes) {
+        munmap(reinterpret_cast<void *>(aligned + bytes), begin + reserve - aligned - bytes);
+    }
+    void *addr = reinterpret_cast<void *>(aligned);
+
+    if ((flags & PoolMapHugeTlb) && bytes % HUGE_PAGE_SIZE == 0 &&
+        aligned % HUGE_PAGE_SIZE == 0) {
+        // needs reserved huge pages, keep the normal mapping without them
+        if (mmap(addr, bytes, PROT_READ | PROT_WRITE, mmapFlags | MAP_FIXED | MAP_HUGETLB, -1,
+                 0) != MAP_FAILED) {
+            hugeBytes_.fetch_add(bytes, std::memory_order_relaxed);
+        } else if (mmap(addr, bytes, PROT_READ | PROT_WRITE, mmapFlags | MAP_FIXED, -1, 0) ==
+                   MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+    }
+    if (flags & PoolMapTransparentHuge) {
+        madvise(addr, bytes, MADV_HUGEPAGE);
+    }
+
+    // before the first fault
+    if (node_ != AnyNode && !topology_.bindMemory(addr, bytes, node_)) {
+        bindFailures_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(mappingsMtx_);
+        mappings_.emplace(addr, std::make_pair(bytes, flags));
+        if (lockAll_ && !(flags & PoolMapNoReserve)) {
+            flags |= PoolMapPopulate | PoolMapLock;
+        }
+    }
+    if (flags & PoolMapPopulate) {
+        prefault(addr, bytes);
+    }
+    if (flags & PoolMapLock) {
+        lock(addr, bytes);
+    }
+
+    mappedBytes_.fetch_add(bytes, std::memory_order_relaxed);
+    return addr;
+}
+
+void PageProvider::unmap(void *addr, size_t bytes) {
+    size_t page = pageSize();
+    bytes = (bytes + page - 1) / page * page;
+    {
+        std::lock_guard<std::mutex> guard(mappingsMtx_);
+        mappings_.erase(addr);
+    }
+    munmap(addr, bytes);
+    mappedBytes_.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void PageProvider::prefault(void *addr, size_t bytes) {
+    if (madvise(addr, bytes, MADV_POPULATE_WRITE) == 0) {
+        return;
+    }
+    // kernels before 5.14, touch every page
+    size_t page = pageSize();
+    auto *p = static_cast<volatile char *>(addr);
+    for (size_t i = 0; i < bytes; i += page) {
+        p[i] = p[i];
+    }
+}
+
+void PageProvider::lock(void *addr, size_t bytes) {
+    if (mlock(addr, bytes) != 0) {
+        lockFailures_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool PageProvider::lockMappings() {
+    size_t failures = lock_failures();
+    std::lock_guard<std::mutex> guard(mappingsMtx_);
+    lockAll_ = true;
+    for (const auto &[addr, mapping] : mappings_) {
+        auto [bytes, flags] = mapping;
+        if (flags & PoolMapNoReserve) {
+            continue;
+        }
+        prefault(addr, bytes);
+        lock(addr, bytes);
+    }
+    return lock_failures() == failures;
+}
+
+bool PageProvider::bindThread() {
+    return node_ == AnyNode || topology_.preferNode(node_);
+}
+
+PageProvider &PageProvider::process() {
+    static PageProvider provider;
+    return provider;
+}
+
+PageProvider &PageProvider::current() { return current_ != nullptr ? *current_ : process(); }
@@ -0,0 +1,206 @@
+#ifndef _PAGEPROVIDER_H
+#define _PAGEPROVIDER_H
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+
+// how pages are mapped, may be combined
+enum PoolMapFlags : unsigned {
+    PoolMapDefault = 0,
+    PoolMapHugeTlb = 1 << 0,          // MAP_HUGETLB, falls back to normal pages
+    PoolMapTransparentHuge = 1 << 1,  // madvise(MADV_HUGEPAGE)
+    PoolMapPopulate = 1 << 2,         // prefault after the node binding
+    PoolMapLock = 1 << 3,             // mlock, kept if RLIMIT_MEMLOCK refuses
+    PoolMapNoReserve = 1 << 4,        // MAP_NORESERVE, for large reservations
+};
+
+// NUMA nodes and memory policy of the machine, virtual so tests can run a
+// multi-node topology on a single-node host
+class NumaTopology {
+   public:
+    virtual ~NumaTopology() = default;
+
+    virtual int nodeCount() const = 0;
+    virtual int nodeOfCpu(int cpu) const = 0;
+    // mbind(MPOL_BIND) of a range not faulted in yet
+    virtual bool bindMemory(void *addr, size_t bytes, int node) = 0;
+    // set_mempolicy(MPOL_PREFERRED) of the calling thread
+    virtual bool preferNode(int node) = 0;
+};
+
+// the topology in /sys/devices/system/node
+class SystemNumaTopology : public NumaTopology {
+   public:
+    static SystemNumaTopology &instance();
+
+    int nodeCount() const override { return nodeCount_; }
+    int nodeOfCpu(int cpu) const override;
+    bool bindMemory(void *addr, size_t bytes, int node) override;
+    bool preferNode(int node) override;
+
+   private:
+    SystemNumaTopology();
+
+    int nodeCount_{1};
+};
+
+// Source of the pages behind pools, slabs, order indexes and level vectors.
+//
+// A provider binds everything it maps to one NUMA node (or none), a shard
+// owns one provider for its node. Binding happens before any page is faulted
+// in, so prefaulted and locked pages land on the node.
+class PageProvider {
+   public:
+    static constexpr int AnyNode = -1;
+
+    explicit PageProvider(int node = AnyNode,
+                          NumaTopology &topology = SystemNumaTopology::instance());
+
+    PageProvider(const PageProvider &) = delete;
+    PageProvider &operator=(const PageProvider &) = delete;
+
+    // bytes rounded up to pages, aligned to align (a power of 2), throws
+    // std::bad_alloc if the kernel refuses; with PoolMapHugeTlb a multiple
+    // of 2MB is aligned to 2MB at least
+    void *map(size_t bytes, size_t align = 0, unsigned flags = PoolMapDefault);
+    void unmap(void *addr, size_t bytes);
+
+    // apply to part of a mapping, e.g. the used part of a chunk
+    void prefault(void *addr, size_t bytes);
+    void lock(void *addr, size_t bytes);
+
+    // prefaults and locks every mapping made so far and every later one,
+    // except PoolMapNoReserve reservations which would otherwise be made
+    // resident whole; false if the kernel refused to lock any of them
+    bool lockMappings();
+
+    // the calling thread's own allocations prefer the node too
+    bool bindThread();
+
+    int node() const { return node_; }
+    NumaTopology &topology() const { return topology_; }
+
+    size_t mapped_bytes() const { return mappedBytes_.load(std::memory_order_relaxed); }
+    size_t huge_bytes() const { return hugeBytes_.load(std::memory_order_relaxed); }
+    size_t lock_failures() const { return lockFailures_.load(std::memory_order_relaxed); }
+    // mappings left on whatever node the kernel picks, mbind refused
+    size_t bind_failures() const { return bindFailures_.load(std::memory_order_relaxed); }
+
+    // shared by the process-wide pools, not bound to a node
+    static PageProvider &process();
+
+    // the provider books of the calling thread draw from, process() unless
+    // a shard thread installed its own
+    static PageProvider &current();
+
+    // installs a provider as current() for a scope
+    class Scope {
+       public:
+        explicit Scope(PageProvider &provider) : previous_{current_} { current_ = &provider; }
+        ~Scope() { current_ = previous_; }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+       private:
+        PageProvider *previous_;
+    };
+
+   private:
+    int node_;
+    NumaTopology &topology_;
+
+    std::atomic<size_t> mappedBytes_{0};
+    std::atomic<size_t> hugeBytes_{0};
+    std::atomic<size_t> lockFailures_{0};
+    std::atomic<size_t> bindFailures_{0};
+
+    // flags of each mapping by address, for lockMappings()
+    std::mutex mappingsMtx_;
+    std::map<void *, std::pair<size_t, unsigned>> mappings_;
+    bool lockAll_{false};
+
+    static inline thread_local PageProvider *current_{nullptr};
+};
+
+// std allocator drawing large blocks (bucket arrays, level vectors) from a
+// page provider, small ones (nodes) from the heap, which lockMappings() does
+// not cover
+template <typename T>
+class ProviderAllocator {
+   public:
+    using value_type = T;
+
+    // bytes from which a block gets its own pages
+    static constexpr size_t LARGE_BYTES = size_t{1} << 16;
+
+    ProviderAllocator() noexcept : provider_{&PageProvider::current()} {}
+    explicit ProviderAllocator(PageProvider &provider) noexcept : provider_{&provider} {}
+
+    template <typename U>
+    ProviderAllocator(const ProviderAllocator<U> &other) noexcept
+        : provider_{&other.provider()} {}
+
+    T *allocate(size_t n) {
+        size_t bytes = n * sizeof(T);
+        if (bytes >= LARGE_BYTES) {
+            return static_cast<T *>(provider_->map(bytes, alignof(T)));
+        }
+        return static_cast<T *>(::operator new(bytes, std::align_val_t{alignof(T)}));
+    }
+
+    void deallocate(T *p, size_t n) noexcept {
+        size_t bytes = n * sizeof(T);
+        if (bytes >= LARGE_BYTES) {
+            provider_->unmap(p, bytes);
+            return;
+        }
+        ::operator delete(p, bytes, std::align_val_t{alignof(T)});
+    }
+
+    PageProvider &provider() const { return *provider_; }
+
+    template <typename U>
+    bool operator==(const ProviderAllocator<U> &other) const {
+        return provider_ == &other.provider();
+    }
+
+   private:
+    PageProvider *provider_;
+};
+
+// memory resource mapping every block from a page provider, the upstream of
+// pool resources that carve it into nodes
+class ProviderResource : public std::pmr::memory_resource {
+   public:
+    explicit ProviderResource(PageProvider &provider = PageProvider::current())
+        : provider_{provider} {}
+
+    PageProvider &provider() const { return provider_; }
+    size_t mapped_bytes() const { return mappedBytes_; }
+
+   private:
+    void *do_allocate(size_t bytes, size_t align) override {
+        void *p = provider_.map(bytes, align);
+        mappedBytes_ += bytes;
+        return p;
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t) override {
+        provider_.unmap(p, bytes);
+        mappedBytes_ -= bytes;
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+
+    PageProvider &provider_;
+    size_t mappedBytes_{0};  // not thread safe, neither are the pools over it
+};
+
+#endif  // _PAGEPROVIDER_H
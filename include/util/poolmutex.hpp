@@ -0,0 +1,37 @@
+#ifndef _POOL_MUTEX_H
+#define _POOL_MUTEX_H
+
+#include <atomic>
+#include <cassert>
+
+// Locking of a pool, chosen at compile time.
+//
+// The process-wide singleton pools are shared by every thread and keep
+// std::mutex. A pool instance owned by one book or one shard thread is only
+// ever touched by that thread and takes no lock at all.
+
+// no locking
+struct NullMutex {
+    void lock() {}
+    void unlock() {}
+};
+
+// no locking either, debug builds assert that no two threads use the pool at
+// the same time
+#ifdef NDEBUG
+using SingleOwnerMutex = NullMutex;
+#else
+struct SingleOwnerMutex {
+    void lock() {
+        [[maybe_unused]] bool busy = busy_.exchange(true, std::memory_order_acquire);
+        assert(!busy && "pool instance used by two threads at once");
+    }
+
+    void unlock() { busy_.store(false, std::memory_order_release); }
+
+   private:
+    std::atomic<bool> busy_{false};
+};
+#endif
+
+#endif  // _POOL_MUTEX_H
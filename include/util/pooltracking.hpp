@@ -0,0 +1,100 @@
+#ifndef _POOL_TRACKING_H
+#define _POOL_TRACKING_H
+
+#include <concepts>
+#include <cstdint>
+#include <cstdio>
+#include <unordered_set>
+
+// Bookkeeping of the objects handed out by a pool, chosen at compile time.
+//
+// A pool slot starts with HEADER_SIZE bytes owned by the policy, followed by
+// the object. The pool reports every allocation and release with the slot
+// address; a release the policy rejects (double or foreign free) is ignored.
+// At destruction the pool destroys the slots the policy reports as live.
+
+template <typename T>
+concept PoolTrackingPolicy = requires(T t, const T ct, void *slot, const char *owner) {
+    { T::HEADER_SIZE } -> std::convertible_to<size_t>;
+    t.onAllocate(slot);
+    { t.onDeallocate(slot) } -> std::same_as<bool>;
+    { ct.isLive(slot) } -> std::same_as<bool>;
+    ct.reportLeaks(owner);
+};
+
+// no bookkeeping at all, objects not returned are never destructed
+struct NoTracking {
+    static constexpr size_t HEADER_SIZE = 0;
+
+    void onAllocate(void *) {}
+    bool onDeallocate(void *) { return true; }
+    bool isLive(const void *) const { return false; }
+    void reportLeaks(const char *) const {}
+};
+
+// one word in front of every object, rejects double frees without touching
+// any shared structure
+struct HeaderTracking {
+    static constexpr size_t HEADER_SIZE = sizeof(uint64_t);
+
+    void onAllocate(void *slot) { *static_cast<uint64_t *>(slot) = LIVE; }
+
+    bool onDeallocate(void *slot) {
+        auto *header = static_cast<uint64_t *>(slot);
+        if (*header != LIVE) [[unlikely]] {
+            return false;
+        }
+        *header = FREE;
+        return true;
+    }
+
+    bool isLive(const void *slot) const { return *static_cast<const uint64_t *>(slot) == LIVE; }
+    void reportLeaks(const char *) const {}
+
+   private:
+    static constexpr uint64_t LIVE = 0x4f424a4c49564521;
+    static constexpr uint64_t FREE = 0x4f424a4652454521;
+};
+
+// every live slot in a hash set, rejects foreign frees too and reports the
+// objects not returned
+struct FullTracking {
+    static constexpr size_t HEADER_SIZE = 0;
+    static constexpr size_t MAX_REPORTED = 16;
+
+    void onAllocate(void *slot) { live_.insert(slot); }
+    bool onDeallocate(void *slot) { return live_.erase(slot) == 1; }
+    bool isLive(const void *slot) const { return live_.contains(slot); }
+
+    void reportLeaks(const char *owner) const {
+        if (live_.empty()) {
+            return;
+        }
+        std::fprintf(stderr, "%s: %zu objects not returned\n", owner, live_.size());
+        size_t reported = 0;
+        for (const void *slot : live_) {
+            if (reported++ == MAX_REPORTED) {
+                std::fprintf(stderr, "  ...\n");
+                break;
+            }
+            std::fprintf(stderr, "  %p\n", slot);
+        }
+    }
+
+    size_t live_count() const { return live_.size(); }
+
+   private:
+    std::unordered_set<const void *> live_;
+};
+
+#ifdef NDEBUG
+using DefaultPoolTracking = HeaderTracking;
+#else
+using DefaultPoolTracking = FullTracking;
+#endif
+
+static_assert(PoolTrackingPolicy<NoTracking>);
+static_assert(PoolTrackingPolicy<HeaderTracking>);
+static_assert(PoolTrackingPolicy<FullTracking>);
+
+#endif  // _POOL_TRACKING_H
@@ -0,0 +1,149 @@
+#include "shmsegment.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+namespace {
+
+[[noreturn]] void throwErrno(const char *what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+size_t sizeOf(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        throwErrno("fstat");
+    }
+    return st.st_size;
+}
+
+// shm_open(O_CREAT) and ftruncate are two steps, another process may open the
+// segment in between and find it empty; 0 if it stays so for timeout
+size_t waitSized(int fd, std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    size_t size;
+    while ((size = sizeOf(fd)) == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return size;
+}
+
+}  // namespace
+
+ShmSegment ShmSegment::openOrCreate(const std::string &name, size_t size,
+                                    std::chrono::milliseconds timeout) {
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0) {
+        if (ftruncate(fd, size) != 0) {
+            int err = errno;
+            close(fd);
+            shm_unlink(name.c_str());
+            errno = err;
+            throwErrno("ftruncate");
+        }
+        return ShmSegment(fd, size, true);
+    }
+    if (errno != EEXIST) {
+        throwErrno("shm_open");
+    }
+
+    fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        throwErrno("shm_open");
+    }
+    size_t existing = waitSized(fd, timeout);
+    if (existing == 0) {
+        // the creator is gone, the bytes are still zeroed
+        if (ftruncate(fd, size) != 0) {
+            int err = errno;
+            close(fd);
+            errno = err;
+            throwErrno("ftruncate");
+        }
+        existing = size;
+    }
+    return ShmSegment(fd, existing, false);
+}
+
+ShmSegment ShmSegment::open(const std::string &name, std::chrono::milliseconds timeout) {
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        throwErrno("shm_open");
+    }
+    size_t size = waitSized(fd, timeout);
+    if (size == 0) {
+        close(fd);
+        errno = ETIMEDOUT;
+        throwErrno("shm_open");
+    }
+    return ShmSegment(fd, size, false);
+}
+
+ShmSegment ShmSegment::anonymous(size_t size, const char *debugName) {
+    int fd = memfd_create(debugName, MFD_CLOEXEC);
+    if (fd < 0) {
+        throwErrno("memfd_create");
+    }
+    if (ftruncate(fd, size) != 0) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        throwErrno("ftruncate");
+    }
+    return ShmSegment(fd, size, true);
+}
+
+ShmSegment ShmSegment::fromFd(int fd) { return ShmSegment(fd, sizeOf(fd), false); }
+
+void ShmSegment::unlink(const std::string &name) { shm_unlink(name.c_str()); }
+
+ShmSegment::ShmSegment(int fd, size_t size, bool created)
+    : fd_{fd}, size_{size}, created_{created} {
+    data_ = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data_ == MAP_FAILED) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        throwErrno("mmap");
+    }
+}
+
+ShmSegment::ShmSegment(ShmSegment &&other) noexcept
+    : fd_{std::exchange(other.fd_, -1)},
+      data_{std::exchange(other.data_, nullptr)},
+      size_{std::exchange(other.size_, 0)},
+      created_{other.created_} {}
+
+ShmSegment &ShmSegment::operator=(ShmSegment &&other) noexcept {
+    if (this != &other) {
+        release();
+        fd_ = std::exchange(other.fd_, -1);
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        created_ = other.created_;
+    }
+    return *this;
+}
+
+ShmSegment::~ShmSegment() { release(); }
+
+void ShmSegment::release() noexcept {
+    if (data_ != nullptr) {
+        munmap(data_, size_);
+        data_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
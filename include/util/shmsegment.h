@@ -0,0 +1,64 @@
+#ifndef _SHMSEGMENT_H
+#define _SHMSEGMENT_H
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+// A shared memory mapping: a named POSIX segment (shm_open) processes attach
+// to by name, or an anonymous memfd shared with children across fork or by
+// passing its descriptor. The mapping and the descriptor are released on
+// destruction, a named segment lives on until unlink().
+class ShmSegment {
+   public:
+    // how long attaching waits for the creator to size the segment
+    static constexpr std::chrono::milliseconds SIZE_TIMEOUT{1000};
+
+    // opens name, creating it with size zeroed bytes if it does not exist,
+    // throws std::system_error. An existing segment the creator has not sized
+    // within timeout, e.g. as it died right after creating it, is sized here.
+    static ShmSegment openOrCreate(const std::string &name, size_t size,
+                                   std::chrono::milliseconds timeout = SIZE_TIMEOUT);
+
+    // attaches to an existing segment, its whole size once the creator sized
+    // it; throws std::system_error, ETIMEDOUT if it stays empty for timeout
+    static ShmSegment open(const std::string &name,
+                           std::chrono::milliseconds timeout = SIZE_TIMEOUT);
+
+    // anonymous segment of size zeroed bytes
+    static ShmSegment anonymous(size_t size, const char *debugName = "shm");
+
+    // maps the segment behind a descriptor received from another process,
+    // the descriptor is owned by the segment afterwards
+    static ShmSegment fromFd(int fd);
+
+    // removes the name, mappings stay valid
+    static void unlink(const std::string &name);
+
+    ShmSegment(ShmSegment &&other) noexcept;
+    ShmSegment &operator=(ShmSegment &&other) noexcept;
+    ~ShmSegment();
+
+    ShmSegment(const ShmSegment &) = delete;
+    ShmSegment &operator=(const ShmSegment &) = delete;
+
+    void *data() const { return data_; }
+    size_t size() const { return size_; }
+    int fd() const { return fd_; }
+    // this process created the segment, so it is still zeroed
+    bool created() const { return created_; }
+
+   private:
+    ShmSegment(int fd, size_t size, bool created);
+
+    void release() noexcept;
+
+    int fd_{-1};
+    void *data_{nullptr};
+    size_t size_{0};
+    bool created_{false};
+};
+
+#endif  // _SHMSEGMENT_H
@@ -1,78 +1,81 @@
 #ifndef _SLAB_ALLOCATOR_H
 #define _SLAB_ALLOCATOR_H
 
-#include <sys/mman.h>
-
+#include <algorithm>
+#include <bit>
 #include <concepts>
-#include <list>
+#include <cstdint>
 #include <memory>
 #include <mutex>
-#include <unordered_map>
-#include <vector>
+#include <stdexcept>
+#include <utility>
 
+#include "buddyallocator.hpp"
+#include "pageprovider.h"
+#include "poolmutex.hpp"
+#include "pooltracking.hpp"
 #include "singleton.hpp"
 
 namespace {
 struct MMapAllocator {
-    // allocate a heap memory of size
-    void *allocate(size_t size) {
-        void *map =
-            mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-        if (map == MAP_FAILED) {
-            return nullptr;
-        }
-        return map;
-    }
+    // allocate a heap memory of size, aligned to size (a power of 2)
+    void *allocate(size_t size) { return provider_->map(size, size); }
 
-    void deallocate(void *map, size_t size) { munmap(map, size); }
+    void deallocate(void *map, size_t size) { provider_->unmap(map, size); }
+
+    PageProvider *provider_{&PageProvider::process()};
 };
 
-// TODO: buddy allocator for page
+}  // namespace
 
-template <typename T, size_t MAX_OBJ_NUM = (1 << 12),
-          typename PageAllocator = MMapAllocator>
-class Slab {
-    std::vector<T *> objs_;
-    PageAllocator page_allocator_;
-    T *page_;
+// Every slab is a page of SLAB_SIZE slots, aligned to its power of 2 size and
+// starting with the slab header, so the slab of an object is found by masking
+// its address. Returned slots go on an intrusive free list inside the slab,
+// slots never handed out are carved by a bump pointer.
+//
+// Tracking decides the per-object bookkeeping, see pooltracking.hpp. Without
+// tracking, releasing a pointer not from this allocator is undefined.
+//
+// Pages come from the buddy allocator shared by all slab types by default,
+// MMapAllocator maps every page on its own.
+//
+// As with ObjectPool, GetInst() is the shared instance and a book or shard
+// thread may own one with SingleOwnerMutex instead.
+template <typename T, size_t SLAB_SIZE = (1 << 12),
+          PoolTrackingPolicy Tracking = DefaultPoolTracking,
+          typename PageAllocator = BuddyPageAllocator<>, typename Mutex = std::mutex>
+class SlabAllocator
+    : public Singleton<SlabAllocator<T, SLAB_SIZE, Tracking, PageAllocator, Mutex>> {
+
+    static_assert(SLAB_SIZE > 1);
 
    public:
-    Slab() {
-        static_assert(MAX_OBJ_NUM > 1);
-        objs_.reserve(MAX_OBJ_NUM);
-        page_ = (T *)page_allocator_.allocate(MAX_OBJ_NUM * sizeof(T));
+    using value_type = T;
 
-        for (int i = 0; i < MAX_OBJ_NUM; i++) {
-            objs_.push_back(page_ + i);
-        }
+    explicit SlabAllocator(PageAllocator pageAllocator = PageAllocator{})
+        : page_allocator_{std::move(pageAllocator)} {
+        std::lock_guard<Mutex> lock(mtx);
+        add_slab();
     }
 
-    ~Slab() { page_allocator_.deallocate(page_, MAX_OBJ_NUM * sizeof(T)); }
-
-    // get a ptr of unconstructed obj
-    T *get_one() {
-        T *ret = objs_.back();
-        objs_.pop_back();
-        return ret;
+    ~SlabAllocator() {
+        std::lock_guard<Mutex> lock(mtx);
+        tracker_.reportLeaks("SlabAllocator");
+        for (SlabList *list : {&partial_list_, &free_list_, &full_list_}) {
+            while (!list->empty()) {
+                Slab *slab = list->front();
+                list->remove(slab);
+                // every slot past bump_ was never constructed
+                for (char *slot = slab->slots(); slot != slab->bump_; slot += SLOT_SIZE) {
+                    if (tracker_.isLive(slot)) {
+                        reinterpret_cast<T *>(slot + HEADER_OFFSET)->~T();
+                    }
+                }
+                page_allocator_.deallocate(slab, PAGE_SIZE);
+            }
+        }
     }
 
-    // return a destructed obj
-    void return_one(T *obj) { objs_.push_back(obj); }
-
-    bool is_free() const { return objs_.size() == MAX_OBJ_NUM; }
-    bool is_full() const { return objs_.empty(); }
-    size_t get_obj_nr() const { return objs_.size(); }
-};
-
-}  // namespace
-
-template <typename T, size_t SLAB_SIZE = (1 << 12)>
-class SlabAllocator : public Singleton<SlabAllocator<T, SLAB_SIZE>> {
-    friend class Singleton<SlabAllocator<T, SLAB_SIZE>>;
-
-   public:
-    using value_type = T;
-
     // forbid copy
     SlabAllocator(const SlabAllocator &) = delete;
     SlabAllocator &operator=(const SlabAllocator &) = delete;
@@ -80,57 +83,60 @@ class SlabAllocator : public Singleton<SlabAllocator<T, SLAB_SIZE>> {
     // allocate object
     template <typename... Args>
     T *allocate(Args &&...args) {
-        std::lock_guard<std::mutex> lock(mtx);
+        std::lock_guard<Mutex> lock(mtx);
 
-        T *obj = nullptr;
-        typename slab_list::iterator it;
+        Slab *slab;
         if (!partial_list_.empty()) [[likely]] {
-            it = partial_list_.begin();
-            obj = it->get_one();
-            if (it->is_full()) {
-                // transfer from partial to full
-                full_list_.splice(full_list_.begin(), partial_list_, it);
-            }
+            slab = partial_list_.front();
         } else {
             if (free_list_.empty()) [[unlikely]] {
                 // add a new slab
-                free_list_.emplace_back();
+                add_slab();
             }
-            it = free_list_.begin();
-            obj = it->get_one();
+            slab = free_list_.front();
             // transfer from free to partial
-            partial_list_.splice(partial_list_.begin(), free_list_, it);
+            free_list_.remove(slab);
+            partial_list_.push_front(slab);
+        }
+
+        char *slot = slab->get_one();
+        if (slab->is_full()) {
+            // transfer from partial to full
+            partial_list_.remove(slab);
+            full_list_.push_front(slab);
         }
 
-        new (obj) T{std::forward<Args>(args)...};
-        obj_2_lst_map_[obj] = it;
-        return obj;
+        tracker_.onAllocate(slot);
+        inuse_++;
+        return new (slot + HEADER_OFFSET) T{std::forward<Args>(args)...};
     }
 
     // release object
     void deallocate(T *obj) {
-        std::lock_guard<std::mutex> lock(mtx);
+        std::lock_guard<Mutex> lock(mtx);
 
-        auto it = obj_2_lst_map_.find(obj);
-        if (it == obj_2_lst_map_.end()) [[unlikely]] {
+        if (obj == nullptr) [[unlikely]] {
+            return;
+        }
+        char *slot = reinterpret_cast<char *>(obj) - HEADER_OFFSET;
+        if (!tracker_.onDeallocate(slot)) [[unlikely]] {
             return;
         }
-        auto listIt = it->second;
-        obj_2_lst_map_.erase(it);
 
         obj->~T();
+        inuse_--;
 
-        if (listIt->is_full()) [[unlikely]] {
+        Slab *slab = slab_of(obj);
+        bool wasFull = slab->is_full();
+        slab->return_one(slot);
+        if (wasFull) [[unlikely]] {
             // full -> partial
-            listIt->return_one(obj);
-            partial_list_.splice(partial_list_.begin(), full_list_, listIt);
-            return;
-        }
-
-        listIt->return_one(obj);
-        if (listIt->is_free()) [[unlikely]] {
+            full_list_.remove(slab);
+            partial_list_.push_front(slab);
+        } else if (slab->is_free()) [[unlikely]] {
             // partial -> free
-            free_list_.splice(free_list_.begin(), partial_list_, listIt);
+            partial_list_.remove(slab);
+            free_list_.push_front(slab);
         }
     }
 
@@ -138,28 +144,125 @@ class SlabAllocator : public Singleton<SlabAllocator<T, SLAB_SIZE>> {
     auto free_list_size() const { return free_list_.size(); }
     auto full_list_size() const { return full_list_.size(); }
 
-   protected:
-    SlabAllocator() {
-        std::lock_guard<std::mutex> lock(mtx);
-        free_list_.emplace_back();
+    size_t mapped_bytes() {
+        std::lock_guard<Mutex> lock(mtx);
+        return (partial_list_.size() + free_list_.size() + full_list_.size()) * PAGE_SIZE;
     }
 
-    ~SlabAllocator() {
-        std::lock_guard<std::mutex> lock(mtx);
-        for (auto &[p, _] : obj_2_lst_map_) {
-            p->~T();
-        }
+    // slots handed out and not returned
+    size_t used_bytes() {
+        std::lock_guard<Mutex> lock(mtx);
+        return inuse_ * SLOT_SIZE;
     }
 
    private:
-    using slab_list = std::list<Slab<T, SLAB_SIZE>>;
+    // overlays a free object, the tracking header stays intact
+    struct FreeNode {
+        FreeNode *next_;
+    };
+
+    // header at the start of every slab page
+    struct Slab {
+        Slab *prev_{nullptr};
+        Slab *next_{nullptr};
+        FreeNode *free_{nullptr};
+        char *bump_;
+        size_t inuse_{0};
+
+        char *slots() { return reinterpret_cast<char *>(this) + FIRST_SLOT; }
+
+        // get a slot of unconstructed obj
+        char *get_one() {
+            inuse_++;
+            if (free_ != nullptr) {
+                char *slot = reinterpret_cast<char *>(free_) - HEADER_OFFSET;
+                free_ = free_->next_;
+                return slot;
+            }
+            char *slot = bump_;
+            bump_ += SLOT_SIZE;
+            return slot;
+        }
+
+        // return the slot of a destructed obj
+        void return_one(char *slot) {
+            inuse_--;
+            auto *node = reinterpret_cast<FreeNode *>(slot + HEADER_OFFSET);
+            node->next_ = free_;
+            free_ = node;
+        }
+
+        bool is_free() const { return inuse_ == 0; }
+        bool is_full() const { return inuse_ == SLAB_SIZE; }
+    };
+
+    // intrusive doubly linked list of slabs
+    class SlabList {
+       public:
+        bool empty() const { return head_ == nullptr; }
+        size_t size() const { return size_; }
+        Slab *front() const { return head_; }
+
+        void push_front(Slab *slab) {
+            slab->prev_ = nullptr;
+            slab->next_ = head_;
+            if (head_ != nullptr) {
+                head_->prev_ = slab;
+            }
+            head_ = slab;
+            size_++;
+        }
+
+        void remove(Slab *slab) {
+            if (slab->prev_ != nullptr) {
+                slab->prev_->next_ = slab->next_;
+            } else {
+                head_ = slab->next_;
+            }
+            if (slab->next_ != nullptr) {
+                slab->next_->prev_ = slab->prev_;
+            }
+            size_--;
+        }
 
-    slab_list partial_list_;
-    slab_list free_list_;
-    slab_list full_list_;  // fully used
+       private:
+        Slab *head_{nullptr};
+        size_t size_{0};
+    };
+
+    static constexpr size_t SLOT_ALIGN = std::max(
+        {alignof(T), alignof(FreeNode), Tracking::HEADER_SIZE > 0 ? alignof(uint64_t) : 1});
+    static constexpr size_t HEADER_OFFSET =
+        (Tracking::HEADER_SIZE + SLOT_ALIGN - 1) / SLOT_ALIGN * SLOT_ALIGN;
+    static constexpr size_t SLOT_SIZE =
+        (HEADER_OFFSET + std::max(sizeof(T), sizeof(FreeNode)) + SLOT_ALIGN - 1) /
+        SLOT_ALIGN * SLOT_ALIGN;
+    static constexpr size_t FIRST_SLOT =
+        (sizeof(Slab) + SLOT_ALIGN - 1) / SLOT_ALIGN * SLOT_ALIGN;
+    static constexpr size_t PAGE_SIZE = std::bit_ceil(FIRST_SLOT + SLAB_SIZE * SLOT_SIZE);
+
+    static Slab *slab_of(const T *obj) {
+        return reinterpret_cast<Slab *>(reinterpret_cast<uintptr_t>(obj) & ~(PAGE_SIZE - 1));
+    }
+
+    void add_slab() {
+        void *page = page_allocator_.allocate(PAGE_SIZE);
+        if (page == nullptr) [[unlikely]] {
+            throw std::runtime_error("fail to alloc slab page");
+        }
+        Slab *slab = new (page) Slab;
+        slab->bump_ = slab->slots();
+        free_list_.push_front(slab);
+    }
+
+    SlabList partial_list_;
+    SlabList free_list_;
+    SlabList full_list_;  // fully used
+    size_t inuse_{0};     // slots of all slabs
 
-    std::unordered_map<T *, typename slab_list::iterator> obj_2_lst_map_;
-    std::mutex mtx;
+    PageAllocator page_allocator_;
+    Tracking tracker_;
+    Mutex mtx;
 };
 
-#endif  // _SLAB_ALLOCATOR_H
\ No newline at end of file
+#endif  // _SLAB_ALLOCATOR_H
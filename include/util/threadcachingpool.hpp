@@ -0,0 +1,279 @@
+#ifndef _THREAD_CACHING_POOL_H
+#define _THREAD_CACHING_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "pageprovider.h"
+#include "singleton.hpp"
+
+// Object pool for objects allocated and freed on many threads.
+//
+// Every thread owns a cache: a magazine (array) of free slots plus the chunks
+// it carved. A free on the owning thread goes to its magazine. A free on any
+// other thread is pushed onto the owner's lock-free remote list, the owner
+// drains it when its magazine runs dry. Full magazines spill half of their
+// slots as one chain onto a lock-free global stack that any thread can refill
+// from. The owner of a slot is found by masking its address down to the
+// chunk header, chunks are CHUNK_SIZE aligned.
+//
+// No lock is taken unless a new chunk or thread cache is created.
+template <typename T, size_t CHUNK_SIZE = (1 << 18), size_t MAGAZINE_SIZE = 64>
+class ThreadCachingObjectPool
+    : public Singleton<ThreadCachingObjectPool<T, CHUNK_SIZE, MAGAZINE_SIZE>> {
+    friend class Singleton<ThreadCachingObjectPool<T, CHUNK_SIZE, MAGAZINE_SIZE>>;
+
+    static_assert((CHUNK_SIZE & (CHUNK_SIZE - 1)) == 0, "CHUNK_SIZE must be a power of 2");
+    static_assert(MAGAZINE_SIZE >= 2);
+
+   public:
+    using value_type = T;
+
+    // forbid copy
+    ThreadCachingObjectPool(const ThreadCachingObjectPool &) = delete;
+    ThreadCachingObjectPool &operator=(const ThreadCachingObjectPool &) = delete;
+
+    // allocate object
+    template <typename... Args>
+    T *allocate(Args &&...args) {
+        ThreadCache *cache = localCache();
+        void *slot = cache->count_ > 0 ? cache->magazine_[--cache->count_] : refill(cache);
+        return new (slot) T{std::forward<Args>(args)...};
+    }
+
+    // release object, from any thread
+    void deallocate(T *obj) {
+        if (obj == nullptr) [[unlikely]] {
+            return;
+        }
+        obj->~T();
+
+        ThreadCache *owner = chunkOf(obj)->owner_;
+        ThreadCache *cache = localCache();
+        if (owner != cache) [[unlikely]] {
+            owner->remoteFree(reinterpret_cast<FreeNode *>(obj));
+            return;
+        }
+
+        if (cache->count_ == MAGAZINE_SIZE) [[unlikely]] {
+            spill(cache);
+        }
+        cache->magazine_[cache->count_++] = obj;
+    }
+
+    size_t chunk_count() const { return chunkCount_.load(std::memory_order_relaxed); }
+
+   protected:
+    ThreadCachingObjectPool() = default;
+
+    ~ThreadCachingObjectPool() {
+        std::lock_guard<std::mutex> lock(mtx);
+        // objects still in use are not destructed
+        for (ChunkHeader *chunk = chunks_; chunk != nullptr;) {
+            ChunkHeader *next = chunk->next_;
+            provider_.unmap(chunk, CHUNK_SIZE);
+            chunk = next;
+        }
+        for (ThreadCache *cache = caches_; cache != nullptr;) {
+            ThreadCache *next = cache->next_;
+            delete cache;
+            cache = next;
+        }
+    }
+
+   private:
+    // a free slot, nextChain_ links chains on the global stack
+    struct FreeNode {
+        FreeNode *next_;
+        FreeNode *nextChain_;
+    };
+
+    struct alignas(64) ThreadCache {
+        void *magazine_[MAGAZINE_SIZE];
+        size_t count_{0};
+        char *bump_{nullptr};
+        char *bumpEnd_{nullptr};
+        ThreadCache *next_{nullptr};  // registry, never unlinked
+        std::atomic<bool> active_{true};
+
+        // pushed by other threads, taken as a whole by the owner
+        alignas(64) std::atomic<FreeNode *> remoteHead_{nullptr};
+
+        void remoteFree(FreeNode *node) {
+            FreeNode *head = remoteHead_.load(std::memory_order_relaxed);
+            do {
+                node->next_ = head;
+            } while (!remoteHead_.compare_exchange_weak(
+                head, node, std::memory_order_release, std::memory_order_relaxed));
+        }
+    };
+
+    struct ChunkHeader {
+        ThreadCache *owner_;
+        ChunkHeader *next_;
+    };
+
+    static constexpr size_t SLOT_ALIGN =
+        alignof(T) > alignof(FreeNode) ? alignof(T) : alignof(FreeNode);
+    static constexpr size_t SLOT_SIZE =
+        ((sizeof(T) > sizeof(FreeNode) ? sizeof(T) : sizeof(FreeNode)) + SLOT_ALIGN - 1) /
+        SLOT_ALIGN * SLOT_ALIGN;
+    static constexpr size_t FIRST_SLOT =
+        (sizeof(ChunkHeader) + SLOT_ALIGN - 1) / SLOT_ALIGN * SLOT_ALIGN;
+
+    static_assert(FIRST_SLOT + SLOT_SIZE <= CHUNK_SIZE, "CHUNK_SIZE too small");
+
+    // returns the thread's cache of this pool on thread exit
+    struct LocalHandle {
+        ThreadCachingObjectPool *pool_{nullptr};
+        ThreadCache *cache_{nullptr};
+
+        ~LocalHandle() {
+            if (cache_ != nullptr) {
+                pool_->releaseCache(cache_);
+            }
+        }
+    };
+
+    static inline thread_local LocalHandle local_;
+
+    static ChunkHeader *chunkOf(const void *obj) {
+        return reinterpret_cast<ChunkHeader *>(reinterpret_cast<uintptr_t>(obj) &
+                                               ~(CHUNK_SIZE - 1));
+    }
+
+    ThreadCache *localCache() {
+        if (local_.cache_ == nullptr) [[unlikely]] {
+            local_.pool_ = this;
+            local_.cache_ = acquireCache();
+        }
+        return local_.cache_;
+    }
+
+    // adopt the cache of an exited thread, or create one
+    ThreadCache *acquireCache() {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (ThreadCache *cache = caches_; cache != nullptr; cache = cache->next_) {
+            bool expected = false;
+            if (cache->active_.compare_exchange_strong(expected, true)) {
+                return cache;
+            }
+        }
+        ThreadCache *cache = new ThreadCache;
+        cache->next_ = caches_;
+        caches_ = cache;
+        return cache;
+    }
+
+    void releaseCache(ThreadCache *cache) {
+        if (cache->count_ > 0) {
+            pushChain(linkMagazine(cache, cache->count_));
+        }
+        cache->active_.store(false, std::memory_order_release);
+    }
+
+    // slow path of allocate: remote frees, global stack, then fresh memory
+    void *refill(ThreadCache *cache) {
+        FreeNode *list = cache->remoteHead_.exchange(nullptr, std::memory_order_acquire);
+        if (list == nullptr) {
+            list = popChain();
+        }
+
+        if (list != nullptr) {
+            while (list != nullptr && cache->count_ < MAGAZINE_SIZE) {
+                cache->magazine_[cache->count_++] = list;
+                list = list->next_;
+            }
+            if (list != nullptr) {
+                pushChain(list);
+            }
+            return cache->magazine_[--cache->count_];
+        }
+
+        if (cache->bump_ == cache->bumpEnd_) [[unlikely]] {
+            newChunk(cache);
+        }
+        void *slot = cache->bump_;
+        cache->bump_ += SLOT_SIZE;
+        return slot;
+    }
+
+    // move the older half of a full magazine to the global stack
+    void spill(ThreadCache *cache) {
+        FreeNode *chain = linkMagazine(cache, MAGAZINE_SIZE / 2);
+        pushChain(chain);
+    }
+
+    // links the first n magazine slots into a chain and compacts the rest
+    FreeNode *linkMagazine(ThreadCache *cache, size_t n) {
+        FreeNode *chain = nullptr;
+        for (size_t i = 0; i < n; i++) {
+            auto *node = static_cast<FreeNode *>(cache->magazine_[i]);
+            node->next_ = chain;
+            chain = node;
+        }
+        std::copy(cache->magazine_ + n, cache->magazine_ + cache->count_,
+                  cache->magazine_);
+        cache->count_ -= n;
+        return chain;
+    }
+
+    // global stack of chains, the top 16 bits of the head are an ABA tag
+    static constexpr uint64_t PTR_MASK = (uint64_t{1} << 48) - 1;
+
+    void pushChain(FreeNode *chain) {
+        uint64_t head = globalHead_.load(std::memory_order_relaxed);
+        uint64_t next;
+        do {
+            chain->nextChain_ = reinterpret_cast<FreeNode *>(head & PTR_MASK);
+            next = ((head & ~PTR_MASK) + (uint64_t{1} << 48)) |
+                   reinterpret_cast<uintptr_t>(chain);
+        } while (!globalHead_.compare_exchange_weak(head, next, std::memory_order_release,
+                                                    std::memory_order_relaxed));
+    }
+
+    FreeNode *popChain() {
+        uint64_t head = globalHead_.load(std::memory_order_acquire);
+        uint64_t next;
+        FreeNode *chain;
+        do {
+            chain = reinterpret_cast<FreeNode *>(head & PTR_MASK);
+            if (chain == nullptr) {
+                return nullptr;
+            }
+            // chunks are never unmapped while the pool lives, so this read is
+            // safe even if the chain was popped meanwhile, the tag rejects it
+            next = ((head & ~PTR_MASK) + (uint64_t{1} << 48)) |
+                   reinterpret_cast<uintptr_t>(chain->nextChain_);
+        } while (!globalHead_.compare_exchange_weak(head, next, std::memory_order_acquire,
+                                                    std::memory_order_acquire));
+        return chain;
+    }
+
+    void newChunk(ThreadCache *cache) {
+        void *map = provider_.map(CHUNK_SIZE, CHUNK_SIZE);
+        auto *chunk = static_cast<ChunkHeader *>(map);
+        chunk->owner_ = cache;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            chunk->next_ = chunks_;
+            chunks_ = chunk;
+        }
+        chunkCount_.fetch_add(1, std::memory_order_relaxed);
+
+        cache->bump_ = reinterpret_cast<char *>(chunk) + FIRST_SLOT;
+        cache->bumpEnd_ =
+            cache->bump_ + (CHUNK_SIZE - FIRST_SLOT) / SLOT_SIZE * SLOT_SIZE;
+    }
+
+    PageProvider &provider_{PageProvider::process()};
+    alignas(64) std::atomic<uint64_t> globalHead_{0};
+    alignas(64) std::atomic<size_t> chunkCount_{0};
+    ChunkHeader *chunks_{nullptr};
+    ThreadCache *caches_{nullptr};
+    std::mutex mtx;
+};
+
+#endif  // _THREAD_CACHING_POOL_H
\ No newline at end of file
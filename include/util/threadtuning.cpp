@@ -0,0 +1,26 @@
+#include "threadtuning.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+bool pinCurrentThread(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+bool setCurrentThreadRealtime(int priority) {
+    sched_param param{};
+    param.sched_priority = priority;
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+}
+
+// not inlined, the buffer is in a frame of its own below the caller
+[[gnu::noinline]] void prefaultStack(size_t bytes) {
+    constexpr size_t PAGE = 4096;
+    volatile char *buffer = static_cast<volatile char *>(__builtin_alloca(bytes));
+    for (size_t offset = 0; offset < bytes; offset += PAGE) {
+        buffer[offset] = 0;
+    }
+}
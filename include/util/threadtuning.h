@@ -0,0 +1,18 @@
+#ifndef _THREADTUNING_H
+#define _THREADTUNING_H
+
+#include <cstddef>
+
+// Setup of a latency critical thread, each call applies to the calling thread
+// and returns false if the system refused, the thread then runs as before.
+
+// runs the thread on cpu only
+bool pinCurrentThread(int cpu);
+
+// SCHED_FIFO at priority, needs CAP_SYS_NICE or an RLIMIT_RTPRIO allowing it
+bool setCurrentThreadRealtime(int priority);
+
+// faults in bytes of the thread's stack below the caller's frame
+void prefaultStack(size_t bytes);
+
+#endif  // _THREADTUNING_H
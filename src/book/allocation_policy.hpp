@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+
+#include "usings.h"
+
+// Allocation policies decide how an incoming quantity is split across the
+// resting orders of one price level. Resting quantities are passed in time
+// priority order as a contiguous array; the policy writes one allocation per
+// order into `out` and returns the total allocated.
+//
+// Every policy allocates exactly min(incoming, sum(resting)) and never gives
+// an order more than its resting quantity, so matching always makes progress.
+
+template <typename T>
+concept LevelAllocationPolicy =
+    requires(Quantity incoming, const Quantity* resting, Quantity* out, size_t n) {
+        { T::allocate(incoming, resting, out, n) } -> std::same_as<Quantity>;
+    };
+
+// price-time priority (FIFO)
+struct PriceTimeAllocation {
+    static Quantity allocate(Quantity incoming, const Quantity* resting, Quantity* out,
+                             size_t n) {
+        Quantity allocated = 0;
+        for (size_t i = 0; i < n; i++) {
+            out[i] = std::min(incoming - allocated, resting[i]);
+            allocated += out[i];
+        }
+        return allocated;
+    }
+};
+
+// pro-rata by resting quantity
+// each order gets floor(incoming * resting / total); the lots lost to
+// rounding go one by one to the oldest orders that still have room
+struct ProRataAllocation {
+    static Quantity allocate(Quantity incoming, const Quantity* resting, Quantity* out,
+                             size_t n) {
+        Quantity total = 0;
+        for (size_t i = 0; i < n; i++) {
+            total += resting[i];
+        }
+
+        if (incoming >= total) {
+            std::copy(resting, resting + n, out);
+            return total;
+        }
+
+        Quantity allocated = 0;
+        for (size_t i = 0; i < n; i++) {
+            // 128-bit product, incoming * resting may not fit in 64 bits
+            out[i] = static_cast<Quantity>(static_cast<__int128>(incoming) * resting[i] /
+                                           total);
+            allocated += out[i];
+        }
+
+        // at most n - 1 lots are left
+        for (size_t i = 0; i < n && allocated < incoming; i++) {
+            if (out[i] < resting[i]) {
+                out[i]++;
+                allocated++;
+            }
+        }
+        return allocated;
+    }
+};
+
+// FIFO for the first FifoPercent of the incoming quantity, pro-rata for the rest
+template <unsigned FifoPercent>
+struct FifoProRataAllocation {
+    static_assert(FifoPercent <= 100);
+
+    static Quantity allocate(Quantity incoming, const Quantity* resting, Quantity* out,
+                             size_t n) {
+        Quantity fifoQuantity = incoming * FifoPercent / 100;
+        Quantity fifoAllocated = 0;
+        Quantity total = 0;
+        for (size_t i = 0; i < n; i++) {
+            out[i] = std::min(fifoQuantity - fifoAllocated, resting[i]);
+            fifoAllocated += out[i];
+            total += resting[i] - out[i];
+        }
+
+        Quantity remaining = incoming - fifoAllocated;
+        if (remaining >= total) {
+            for (size_t i = 0; i < n; i++) {
+                out[i] = resting[i];
+            }
+            return fifoAllocated + total;
+        }
+
+        Quantity allocated = 0;
+        for (size_t i = 0; i < n; i++) {
+            Quantity left = resting[i] - out[i];
+            Quantity share =
+                static_cast<Quantity>(static_cast<__int128>(remaining) * left / total);
+            out[i] += share;
+            allocated += share;
+        }
+
+        for (size_t i = 0; i < n && allocated < remaining; i++) {
+            if (out[i] < resting[i]) {
+                out[i]++;
+                allocated++;
+            }
+        }
+        return fifoAllocated + allocated;
+    }
+};
+
+static_assert(LevelAllocationPolicy<PriceTimeAllocation>);
+static_assert(LevelAllocationPolicy<ProRataAllocation>);
+static_assert(LevelAllocationPolicy<FifoProRataAllocation<40>>);
@@ -0,0 +1,165 @@
+#ifndef _ASYNC_ENGINE_HPP
+#define _ASYNC_ENGINE_HPP
+
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <vector>
+
+#include "book_command.h"
+#include "concurrency/mpmcqueue.hpp"
+#include "engine_runner.hpp"
+#include "util/framepool.hpp"
+
+// what the matching thread did with a submitted command
+struct ExecutionResult {
+    bool accepted_{false};  // false if it never reached the book, see AsyncEngine
+    uint32_t trades_{0};
+    Quantity filled_{0};  // of the order so far, Add and Modify
+    Quantity remaining_{0};
+};
+
+// A coroutine started eagerly and never awaited, e.g. a client session
+// submitting its commands to an AsyncEngine. Its frame comes from FramePool
+// and is released when it returns.
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+
+        static void *operator new(size_t bytes) { return FramePool::allocate(bytes); }
+        static void operator delete(void *frame, size_t bytes) {
+            FramePool::deallocate(frame, bytes);
+        }
+    };
+};
+
+// Coroutine front end of an EngineRunner.
+//
+// One I/O thread owns the engine: co_await submit(book, order) pushes the
+// command into the book's input queue and suspends the calling coroutine
+// without blocking the thread. The matching thread fills in the result and
+// queues the request as completed, poll() on the I/O thread resumes it. The
+// request is the awaiter itself, kept in the coroutine frame while suspended,
+// so a command costs no allocation.
+//
+// At most MAX_IN_FLIGHT requests wait at once, beyond that, or if the book's
+// input queue is full, co_await returns at once with accepted_ false.
+// Coroutines still suspended when the engine is destroyed are never resumed.
+template <typename Book, size_t QueueCapacity = 4096, size_t MAX_IN_FLIGHT = 4096>
+class AsyncEngine {
+    struct Completion;
+
+   public:
+    using Runner = EngineRunner<Book, Completion, QueueCapacity>;
+
+    class Request {
+       public:
+        Request(const Request &) = delete;
+        Request &operator=(const Request &) = delete;
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> handle) noexcept {
+            if (engine_.inFlight_ == MAX_IN_FLIGHT) [[unlikely]] {
+                return false;
+            }
+            handle_ = handle;
+            command_.context_ = this;
+            if (!engine_.inputs_[book_]->emplace(command_)) [[unlikely]] {
+                return false;
+            }
+            engine_.inFlight_++;
+            return true;
+        }
+
+        ExecutionResult await_resume() const noexcept { return result_; }
+
+       private:
+        friend class AsyncEngine;
+
+        Request(AsyncEngine &engine, size_t book, const BookCommand &command)
+            : engine_{engine}, book_{book}, command_{command} {}
+
+        AsyncEngine &engine_;
+        size_t book_;
+        BookCommand command_;
+        std::coroutine_handle<> handle_;
+        ExecutionResult result_;
+    };
+
+    explicit AsyncEngine(RunnerConfig config) : runner_{std::move(config), Completion{this}} {}
+
+    AsyncEngine(const AsyncEngine &) = delete;
+    AsyncEngine &operator=(const AsyncEngine &) = delete;
+
+    // book is matched by shard, returns the handle to submit to it with;
+    // only before start()
+    size_t attach(size_t shard, Book &book) {
+        inputs_.push_back(&runner_.attach(shard, book));
+        return inputs_.size() - 1;
+    }
+
+    void start() { runner_.start(); }
+    void stop() { runner_.stop(); }
+
+    // I/O thread side
+
+    Request submit(size_t book, Order *order) {
+        return Request{*this, book, BookCommand::add(order)};
+    }
+
+    Request cancel(size_t book, Order *order) {
+        return Request{*this, book, BookCommand::cancel(order)};
+    }
+
+    Request modify(size_t book, Order *order, const OrderModify &modify) {
+        return Request{*this, book, BookCommand::modify(order, modify)};
+    }
+
+    // resumes the coroutines whose commands were handled, returns how many
+    size_t poll() {
+        size_t resumed = 0;
+        Request *request;
+        while (completed_.try_pop(request)) {
+            inFlight_--;
+            resumed++;
+            request->handle_.resume();
+        }
+        return resumed;
+    }
+
+    size_t in_flight() const noexcept { return inFlight_; }
+
+    // stats and setup of the matching threads
+    const Runner &runner() const { return runner_; }
+
+   private:
+    // runs on the matching threads
+    struct Completion {
+        AsyncEngine *engine_;
+
+        void operator()(Book &, const BookCommand &command, Trades &trades) const {
+            auto *request = static_cast<Request *>(command.context_);
+            ExecutionResult &result = request->result_;
+            result.accepted_ = true;
+            result.trades_ = trades.size();
+            if (command.type_ != CommandType::Cancel) {
+                result.filled_ = command.order_->getFilledQuantity();
+                result.remaining_ = command.order_->getRemainingQuantity();
+            }
+            // never full, at most MAX_IN_FLIGHT requests are out
+            engine_->completed_.emplace(request);
+        }
+    };
+
+    Runner runner_;
+    std::vector<typename Runner::InputQueue *> inputs_;
+    MPMCQueue<Request *, MAX_IN_FLIGHT> completed_;
+    size_t inFlight_{0};
+};
+
+#endif  // _ASYNC_ENGINE_HPP
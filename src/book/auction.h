@@ -0,0 +1,13 @@
+#pragma once
+
+#include "constants.h"
+#include "usings.h"
+
+enum class TradingMode { Continuous, Auction };
+
+// result of the equilibrium price search of a call auction
+struct UncrossInfo {
+    Price price_{Constants::InvalidPrice};
+    Quantity volume_{0};     // executable volume at price_
+    Quantity imbalance_{0};  // bid depth - ask depth at price_
+};
\ No newline at end of file
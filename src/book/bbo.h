@@ -0,0 +1,18 @@
+#pragma once
+
+#include "constants.h"
+#include "usings.h"
+
+// best bid and offer, an empty side has zero quantity and an invalid price
+struct BestBidOffer {
+    Price bidPrice_{Constants::InvalidPrice};
+    Quantity bidQuantity_{0};
+    Price askPrice_{Constants::InvalidPrice};
+    Quantity askQuantity_{0};
+    uint32_t bidCount_{0};
+    uint32_t askCount_{0};
+    uint64_t sequence_{0};  // bumped every time the top of book changes
+
+    bool hasBid() const { return bidQuantity_ > 0; }
+    bool hasAsk() const { return askQuantity_ > 0; }
+};
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include "order.h"
+#include "order_modify.h"
+
+enum class CommandType : uint8_t { Add, Cancel, Modify };
+
+// one command for a book, small and trivially copyable for the input queues
+// the order is owned by the sender; Cancel and Modify name it by its id
+struct BookCommand {
+    static BookCommand add(Order *order) { return {CommandType::Add, order}; }
+    static BookCommand cancel(Order *order) { return {CommandType::Cancel, order}; }
+    static BookCommand modify(Order *order, const OrderModify &modify) {
+        return {CommandType::Modify, order, modify.getSide(), modify.getPrice(),
+                modify.getQuantity()};
+    }
+
+    OrderModify getModify() const { return OrderModify{side_, price_, quantity_}; }
+
+    CommandType type_;
+    Order *order_;
+    // Modify only
+    Side side_{Side::Buy};
+    Price price_{0};
+    Quantity quantity_{0};
+    // the sender's, handed back with the result
+    void *context_{nullptr};
+};
+
+static_assert(std::is_trivially_copyable_v<BookCommand>);
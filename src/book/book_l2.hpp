@@ -1,7 +1,14 @@
 #ifndef _BOOK_L2_HPP
 #define _BOOK_L2_HPP
 
+#include <memory>
+
+#include "bbo.h"
 #include "book_l2_base.hpp"
+#include "book_memory.hpp"
+#include "concurrency/seqlock.hpp"
+#include "depth_snapshot.hpp"
+#include "level_delta.hpp"
 #include "level_info.h"
 #include "level_traits.hpp"
 #include "order.h"
@@ -27,12 +34,13 @@ class L2OrderBook : public Base {
         derived()->cancelOrderImpl(order);
     }
 
-    void cancelOrder(Side side, Price price, Quantity quantity) {
+    // count is the number of orders leaving the level, e.g. 0 for a partial fill
+    void cancelOrder(Side side, Price price, Quantity quantity, uint32_t count = 0) {
         if (price <= 0 || quantity <= 0) [[unlikely]] {
             return;
         }
 
-        derived()->cancelOrderImpl(side, price, quantity);
+        derived()->cancelOrderImpl(side, price, quantity, count);
     }
 
     const auto& getBidLevels() const { return derived()->bidLevels_; }
@@ -44,31 +52,152 @@ class L2OrderBook : public Base {
     void forEachBidLevel(Price pmin, Price pmax,
                          const std::function<bool(const L2LevelInfo&)>& cb) {
         for (auto it = derived()->bidBegin(); it != derived()->bidEnd(); ++it) {
-            const auto& [price, info] = *it;
-            if (price > pmax) continue;
-            if (price < pmin) break;
+            const L2LevelInfo& info = levelInfo(*it);
+            if (info.price_ > pmax) continue;
+            if (info.price_ < pmin) break;
             if (!cb(info)) break;
         }
     }
 
     void forEachAskLevel(Price pmin, Price pmax,
                          const std::function<bool(const L2LevelInfo&)>& cb) {
-        for (auto it = derived()->bidBegin(); it != derived()->bidEnd(); ++it) {
-            const auto& [price, info] = *it;
-            if (price < pmin) continue;
-            if (price > pmax) break;
+        for (auto it = derived()->askBegin(); it != derived()->askEnd(); ++it) {
+            const L2LevelInfo& info = levelInfo(*it);
+            if (info.price_ < pmin) continue;
+            if (info.price_ > pmax) break;
             if (!cb(info)) break;
         }
     }
 
     void print() const { derived()->printImpl(); }
 
+    // bytes held by the levels and the price index
+    BookMemoryUsage memoryUsage() const { return derived()->memoryUsageImpl(); }
+
+    // lock-free, callable from any thread
+    BestBidOffer getBestBidOffer() const { return bbo_.load(); }
+
+    // for the book's own thread: compare before and after an event
+    // to tell whether it touched the top of book
+    uint64_t getTopOfBookSequence() const { return bbo_.unsafeGet().sequence_; }
+    const BestBidOffer& getBestBidOfferUnsafe() const { return bbo_.unsafeGet(); }
+
+    // start publishing the top levels for reader threads
+    // must be called before readers start
+    void enableDepthSnapshot() {
+        depthSnapshot_ = std::make_unique<DepthSnapshotPublisher<>>();
+        for (auto it = derived()->bidBegin(); it != derived()->bidEnd(); ++it) {
+            depthSnapshot_->onLevelUpdated(Side::Buy, levelInfo(*it));
+        }
+        for (auto it = derived()->askBegin(); it != derived()->askEnd(); ++it) {
+            depthSnapshot_->onLevelUpdated(Side::Sell, levelInfo(*it));
+        }
+    }
+
+    // lock-free, callable from any thread once enabled
+    const DepthSnapshotPublisher<>* getDepthSnapshotPublisher() const {
+        return depthSnapshot_.get();
+    }
+
+    // start emitting level deltas, consumed from getDeltaStream() by one thread
+    void enableDeltaStream() { deltaStream_ = std::make_unique<LevelDeltaStream<>>(); }
+
+    LevelDeltaStream<>* getDeltaStream() { return deltaStream_.get(); }
+
+    // updates between begin and end are coalesced per level
+    void beginDeltaBatch() {
+        if (deltaStream_) [[unlikely]] {
+            deltaStream_->beginBatch();
+        }
+    }
+
+    void endDeltaBatch() {
+        if (deltaStream_) [[unlikely]] {
+            deltaStream_->commitBatch();
+        }
+    }
+
    protected:
     L2OrderBook() = default;
     ~L2OrderBook() = default;
 
     Derived* derived() { return static_cast<Derived*>(this); }
     const Derived* derived() const { return static_cast<const Derived*>(this); }
+
+    // called by the derived book after a level is added or changed
+    void onLevelUpdated(Side side, const L2LevelInfo& info,
+                        LevelAction action = LevelAction::Change) {
+        const BestBidOffer& bbo = bbo_.unsafeGet();
+        if (side == Side::Buy) {
+            if (!bbo.hasBid() || info.price_ >= bbo.bidPrice_) {
+                setBestBid(info);
+            }
+        } else {
+            if (!bbo.hasAsk() || info.price_ <= bbo.askPrice_) {
+                setBestAsk(info);
+            }
+        }
+
+        if (depthSnapshot_) [[unlikely]] {
+            depthSnapshot_->onLevelUpdated(side, info);
+        }
+
+        if (deltaStream_) [[unlikely]] {
+            deltaStream_->onLevel(side, info.price_, info.quantity_, info.count_, action);
+        }
+    }
+
+    // called by the derived book after a level is erased
+    void onLevelRemoved(Side side, Price price) {
+        const BestBidOffer& bbo = bbo_.unsafeGet();
+        if (side == Side::Buy && price == bbo.bidPrice_) {
+            auto it = derived()->bidBegin();
+            setBestBid(it == derived()->bidEnd() ? L2LevelInfo{Constants::InvalidPrice, 0, 0}
+                                                 : levelInfo(*it));
+        } else if (side == Side::Sell && price == bbo.askPrice_) {
+            auto it = derived()->askBegin();
+            setBestAsk(it == derived()->askEnd() ? L2LevelInfo{Constants::InvalidPrice, 0, 0}
+                                                 : levelInfo(*it));
+        }
+
+        if (depthSnapshot_) [[unlikely]] {
+            depthSnapshot_->onLevelRemoved(*this, side, price);
+        }
+
+        if (deltaStream_) [[unlikely]] {
+            deltaStream_->onLevel(side, price, 0, 0, LevelAction::Delete);
+        }
+    }
+
+    // level iterators yield either L2LevelInfo or a (price, L2LevelInfo) pair
+    static const L2LevelInfo& levelInfo(const L2LevelInfo& info) { return info; }
+    template <typename Key>
+    static const L2LevelInfo& levelInfo(const std::pair<const Key, L2LevelInfo>& entry) {
+        return entry.second;
+    }
+
+   private:
+    void setBestBid(const L2LevelInfo& info) {
+        bbo_.update([&info](BestBidOffer& bbo) {
+            bbo.bidPrice_ = info.price_;
+            bbo.bidQuantity_ = info.quantity_;
+            bbo.bidCount_ = info.count_;
+            bbo.sequence_++;
+        });
+    }
+
+    void setBestAsk(const L2LevelInfo& info) {
+        bbo_.update([&info](BestBidOffer& bbo) {
+            bbo.askPrice_ = info.price_;
+            bbo.askQuantity_ = info.quantity_;
+            bbo.askCount_ = info.count_;
+            bbo.sequence_++;
+        });
+    }
+
+    SeqLock<BestBidOffer> bbo_;
+    std::unique_ptr<DepthSnapshotPublisher<>> depthSnapshot_;
+    std::unique_ptr<LevelDeltaStream<>> deltaStream_;
 };
 
 #endif  // _BOOK_L2_HPP
\ No newline at end of file
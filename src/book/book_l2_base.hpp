@@ -9,7 +9,7 @@ class L2OrderBookBase {
 
     void cancelOrderImpl(const Order* order);
 
-    void cancelOrderImpl(Side side, Price price, Quantity quantity);
+    void cancelOrderImpl(Side side, Price price, Quantity quantity, uint32_t count);
 
     decltype(auto) bidBegin();
     decltype(auto) askBegin();
@@ -7,42 +7,61 @@
 #include <utility>
 
 #include "book_l2.hpp"
+#include "book_memory.hpp"
 #include "level_searcher.hpp"
 
-class MapBasedL2OrderBook : public L2OrderBook<MapBasedL2OrderBook> {
-    friend class L2OrderBook<MapBasedL2OrderBook>;
+template <typename Allocator = DefaultBookAllocator>
+class BasicMapBasedL2OrderBook : private BookMemory<Allocator>,
+                                 public L2OrderBook<BasicMapBasedL2OrderBook<Allocator>> {
+    friend class L2OrderBook<BasicMapBasedL2OrderBook<Allocator>>;
+
+   public:
+    BasicMapBasedL2OrderBook() = default;
+    explicit BasicMapBasedL2OrderBook(const Allocator& allocator)
+        : BookMemory<Allocator>{allocator} {}
+
+    using BookMemory<Allocator>::get_allocator;
 
    protected:
     void addOrderImpl(const Order* order) {
         if (order->side_ == Side::Buy) {
-            levelAdd(price2BidLevelIterMap_, bidLevels_, order->price_,
-                     order->remainingQuantity_);
+            levelAdd(price2BidLevelIterMap_, bidLevels_, Side::Buy, order->price_,
+                     order->remainingQuantity_, 1);
         } else {
-            levelAdd(price2AskLevelIterMap_, askLevels_, order->price_,
-                     order->remainingQuantity_);
+            levelAdd(price2AskLevelIterMap_, askLevels_, Side::Sell, order->price_,
+                     order->remainingQuantity_, 1);
         }
     }
 
     void cancelOrderImpl(const Order* order) {
         if (order->side_ == Side::Buy) {
-            levelRemove(price2BidLevelIterMap_, bidLevels_, order->price_,
-                        order->remainingQuantity_);
+            levelRemove(price2BidLevelIterMap_, bidLevels_, Side::Buy, order->price_,
+                        order->remainingQuantity_, 1);
         } else {
-            levelRemove(price2AskLevelIterMap_, askLevels_, order->price_,
-                        order->remainingQuantity_);
+            levelRemove(price2AskLevelIterMap_, askLevels_, Side::Sell, order->price_,
+                        order->remainingQuantity_, 1);
         }
     }
 
-    void cancelOrderImpl(Side side, Price price, Quantity quantity) {
+    void cancelOrderImpl(Side side, Price price, Quantity quantity, uint32_t count) {
         if (side == Side::Buy) {
-            levelRemove(price2BidLevelIterMap_, bidLevels_, price, quantity);
+            levelRemove(price2BidLevelIterMap_, bidLevels_, side, price, quantity, count);
         } else {
-            levelRemove(price2AskLevelIterMap_, askLevels_, price, quantity);
+            levelRemove(price2AskLevelIterMap_, askLevels_, side, price, quantity, count);
         }
     }
 
     void printImpl() const {}
 
+    BookMemoryUsage memoryUsageImpl() const {
+        BookMemoryUsage usage;
+        usage.levels_ = containerBytes(bidLevels_) + containerBytes(askLevels_);
+        usage.priceIndex_ =
+            containerBytes(price2BidLevelIterMap_) + containerBytes(price2AskLevelIterMap_);
+        usage.arena_ = this->arenaBytes();
+        return usage;
+    }
+
     decltype(auto) bidBegin() { return bidLevels_.begin(); }
     decltype(auto) askBegin() { return askLevels_.begin(); }
 
@@ -51,21 +70,26 @@ class MapBasedL2OrderBook : public L2OrderBook<MapBasedL2OrderBook> {
 
    private:
     template <typename M, typename T>
-    void levelAdd(M& price2levelItMap, T& levels, Price price, Quantity quantity) {
+    void levelAdd(M& price2levelItMap, T& levels, Side side, Price price,
+                  Quantity quantity, uint32_t count) {
         // create a new level if it doesn't exist
         if (price2levelItMap.contains(price)) [[likely]] {
             auto& info = price2levelItMap[price]->second;
             info.quantity_ += quantity;
             info.volume_ += price * quantity;
+            info.count_ += count;
+            this->onLevelUpdated(side, info);
         } else {
-            auto [it, inserted] =
-                levels.emplace(price, L2LevelInfo{price, quantity, price * quantity});
+            auto [it, inserted] = levels.emplace(
+                price, L2LevelInfo{price, quantity, price * quantity, count});
             price2levelItMap[price] = it;
+            this->onLevelUpdated(side, it->second, LevelAction::New);
         }
     }
 
     template <typename M, typename T>
-    void levelRemove(M& price2levelItMap, T& levels, Price price, Quantity quantity) {
+    void levelRemove(M& price2levelItMap, T& levels, Side side, Price price,
+                     Quantity quantity, uint32_t count) {
         if (!price2levelItMap.contains(price)) [[unlikely]] {
             return;
         }
@@ -74,18 +98,34 @@ class MapBasedL2OrderBook : public L2OrderBook<MapBasedL2OrderBook> {
         auto& info = it->second;
         info.quantity_ -= quantity;
         info.volume_ -= price * quantity;
+        info.count_ -= std::min(count, info.count_);
 
         if (info.quantity_ <= 0) [[unlikely]] {
             levels.erase(it);
             price2levelItMap.erase(price);
+            this->onLevelRemoved(side, price);
+        } else {
+            this->onLevelUpdated(side, info);
         }
     }
 
-    std::map<Price, L2LevelInfo, std::greater<Price>> bidLevels_;
-    std::map<Price, L2LevelInfo, std::less<Price>> askLevels_;
-
-    std::unordered_map<Price, decltype(bidLevels_)::iterator> price2BidLevelIterMap_;
-    std::unordered_map<Price, decltype(askLevels_)::iterator> price2AskLevelIterMap_;
+    template <typename Compare>
+    using Levels = std::map<Price, L2LevelInfo, Compare,
+                            BookRebind<Allocator, std::pair<const Price, L2LevelInfo>>>;
+    template <typename Iterator>
+    using PriceIndex = std::unordered_map<Price, Iterator, std::hash<Price>,
+                                          std::equal_to<Price>,
+                                          BookRebind<Allocator, std::pair<const Price, Iterator>>>;
+
+    Levels<std::greater<Price>> bidLevels_{get_allocator()};
+    Levels<std::less<Price>> askLevels_{get_allocator()};
+
+    PriceIndex<typename decltype(bidLevels_)::iterator> price2BidLevelIterMap_{
+        get_allocator()};
+    PriceIndex<typename decltype(askLevels_)::iterator> price2AskLevelIterMap_{
+        get_allocator()};
 };
 
+using MapBasedL2OrderBook = BasicMapBasedL2OrderBook<>;
+
 #endif  // _BOOK_L2_MAP_HPP
\ No newline at end of file
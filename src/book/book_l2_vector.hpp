@@ -7,12 +7,15 @@
 #include <utility>
 
 #include "book_l2.hpp"
+#include "book_memory.hpp"
 #include "level_searcher.hpp"
 
-template <typename LevelSearcher = BinaryLevelSearcher, size_t MAX_DEPTH = 65536>
+template <typename LevelSearcher = BinaryLevelSearcher, size_t MAX_DEPTH = 65536,
+          typename Allocator = DefaultBookAllocator>
 class VectorBasedL2OrderBook
-    : public L2OrderBook<VectorBasedL2OrderBook<LevelSearcher, MAX_DEPTH>> {
-    friend class L2OrderBook<VectorBasedL2OrderBook<LevelSearcher, MAX_DEPTH>>;
+    : private BookMemory<Allocator>,
+      public L2OrderBook<VectorBasedL2OrderBook<LevelSearcher, MAX_DEPTH, Allocator>> {
+    friend class L2OrderBook<VectorBasedL2OrderBook<LevelSearcher, MAX_DEPTH, Allocator>>;
 
    public:
     VectorBasedL2OrderBook() {
@@ -21,39 +24,55 @@ class VectorBasedL2OrderBook
         askLevels_.reserve(MAX_DEPTH);
     }
 
+    explicit VectorBasedL2OrderBook(const Allocator& allocator)
+        : BookMemory<Allocator>{allocator} {
+        bidLevels_.reserve(MAX_DEPTH);
+        askLevels_.reserve(MAX_DEPTH);
+    }
+
+    using BookMemory<Allocator>::get_allocator;
+
     ~VectorBasedL2OrderBook() = default;
 
    protected:
     void addOrderImpl(const Order* order) {
         if (order->side_ == Side::Buy) {
-            levelAdd(bidLevels_, order->price_, order->remainingQuantity_,
-                          std::less<Price>{});
+            levelAdd(bidLevels_, Side::Buy, order->price_, order->remainingQuantity_, 1,
+                     std::less<Price>{});
         } else {
-            levelAdd(askLevels_, order->price_, order->remainingQuantity_,
-                          std::greater<Price>{});
+            levelAdd(askLevels_, Side::Sell, order->price_, order->remainingQuantity_, 1,
+                     std::greater<Price>{});
         }
     }
 
     void cancelOrderImpl(const Order* order) {
         if (order->side_ == Side::Buy) {
-            levelRemove(bidLevels_, order->price_, order->remainingQuantity_,
-                             std::less<Price>{});
+            levelRemove(bidLevels_, Side::Buy, order->price_, order->remainingQuantity_, 1,
+                        std::less<Price>{});
         } else {
-            levelRemove(askLevels_, order->price_, order->remainingQuantity_,
-                             std::greater<Price>{});
+            levelRemove(askLevels_, Side::Sell, order->price_, order->remainingQuantity_, 1,
+                        std::greater<Price>{});
         }
     }
 
-    void cancelOrderImpl(Side side, Price price, Quantity quantity) {
+    void cancelOrderImpl(Side side, Price price, Quantity quantity, uint32_t count) {
         if (side == Side::Buy) {
-            levelRemove(bidLevels_, price, quantity, std::less<Price>{});
+            levelRemove(bidLevels_, side, price, quantity, count, std::less<Price>{});
         } else {
-            levelRemove(askLevels_, price, quantity, std::greater<Price>{});
+            levelRemove(askLevels_, side, price, quantity, count, std::greater<Price>{});
         }
     }
 
     void printImpl() const {}
 
+    // the reserved MAX_DEPTH levels count in full
+    BookMemoryUsage memoryUsageImpl() const {
+        BookMemoryUsage usage;
+        usage.levels_ = containerBytes(bidLevels_) + containerBytes(askLevels_);
+        usage.arena_ = this->arenaBytes();
+        return usage;
+    }
+
     decltype(auto) bidBegin() { return bidLevels_.rbegin(); }
     decltype(auto) askBegin() { return askLevels_.rbegin(); }
 
@@ -62,7 +81,8 @@ class VectorBasedL2OrderBook
 
    private:
     template <typename T, typename Compare>
-    void levelRemove(T& levels, Price price, Quantity quantity, Compare cmp) {
+    void levelRemove(T& levels, Side side, Price price, Quantity quantity, uint32_t count,
+                     Compare cmp) {
         auto it = LevelSearcher::findLevelIt(levels, price, cmp);
 
         if (it == levels.end() || it->price_ != price) [[unlikely]] {
@@ -72,31 +92,40 @@ class VectorBasedL2OrderBook
         auto& info = *it;
         info.quantity_ -= quantity;
         info.volume_ -= price * quantity;
+        info.count_ -= std::min(count, info.count_);
 
         // erase the level if it's empty
         if (info.quantity_ <= 0) [[unlikely]] {
             levels.erase(it);
+            this->onLevelRemoved(side, price);
+        } else {
+            this->onLevelUpdated(side, info);
         }
     }
 
     template <typename T, typename Compare>
-    void levelAdd(T& levels, Price price, Quantity quantity, Compare cmp) {
+    void levelAdd(T& levels, Side side, Price price, Quantity quantity, uint32_t count,
+                  Compare cmp) {
         auto it = LevelSearcher::findLevelIt(levels, price, cmp);
 
         if (it != levels.end() && it->price_ == price) [[likely]] {
             // level exists
             it->quantity_ += quantity;
             it->volume_ += price * quantity;
+            it->count_ += count;
+            this->onLevelUpdated(side, *it);
         } else {
             // level does not exist
-            levels.insert(it, L2LevelInfo{price, quantity, price * quantity});
+            it = levels.insert(it, L2LevelInfo{price, quantity, price * quantity, count});
+            this->onLevelUpdated(side, *it, LevelAction::New);
         }
     }
 
-    using LevelInfos = std::vector<L2LevelInfo>;
+    // MAX_DEPTH levels are reserved, by default in pages of the page provider
+    using LevelInfos = std::vector<L2LevelInfo, BookRebind<Allocator, L2LevelInfo>>;
 
-    LevelInfos bidLevels_;  // largest price at the end
-    LevelInfos askLevels_;  // smallest price at the end
+    LevelInfos bidLevels_{get_allocator()};  // largest price at the end
+    LevelInfos askLevels_{get_allocator()};  // smallest price at the end
 };
 
 #endif  // _BOOK_L2_VECTOR_HPP
\ No newline at end of file
@@ -1,8 +1,14 @@
 #ifndef _BOOK_L3_HPP
 #define _BOOK_L3_HPP
 
+#include <stdexcept>
+#include <type_traits>
+
+#include "allocation_policy.hpp"
+#include "auction.h"
 #include "book_l2.hpp"
 #include "book_l3_base.hpp"
+#include "book_memory.hpp"
 #include "level_info.h"
 #include "level_traits.hpp"
 #include "order.h"
@@ -10,9 +16,11 @@
 #include "order_modify.h"
 #include "order_validate.h"
 #include "trade.h"
+#include "concurrency/epoch.hpp"
 #include "util/objectpool.hpp"
 
-template <typename Derived, typename Base = L3OrderBookBase>
+template <typename Derived, typename Base = L3OrderBookBase,
+          LevelAllocationPolicy AllocationPolicy = PriceTimeAllocation>
 class L3OrderBook : public L3OrderBookBase {
    public:
     // add order to the order book
@@ -25,6 +33,9 @@ class L3OrderBook : public L3OrderBookBase {
             return {};
         }
 
+        DeltaBatch batch{getL2Book()};
+        EpochDomain::WriteScope write{epochDomain_};
+
         if (order->getOrderType() == OrderType::Market) {
             // the worst price is only used for matching
             // the actual price executed is on the other side
@@ -39,6 +50,17 @@ class L3OrderBook : public L3OrderBookBase {
             }
         }
 
+        if (tradingMode_ == TradingMode::Auction) [[unlikely]] {
+            // immediate orders make no sense without continuous matching
+            if (order->getOrderType() == OrderType::FillAndKill ||
+                order->getOrderType() == OrderType::FillOrKill) {
+                return {};
+            }
+            derived()->addOrderImpl(order);
+            onOrderAdded(order);
+            return {};
+        }
+
         if (order->getOrderType() == OrderType::FillAndKill &&
             !canMatch(order->getSide(), order->getPrice())) {
             return {};
@@ -52,7 +74,7 @@ class L3OrderBook : public L3OrderBookBase {
 
         derived()->addOrderImpl(order);
         onOrderAdded(order);
-        return MatchOrders();
+        return MatchOrders(order->getSide());
     }
 
     // cancel order by order ID
@@ -60,6 +82,8 @@ class L3OrderBook : public L3OrderBookBase {
         if (!derived()->orderExistsImpl(orderId)) [[unlikely]] {
             return;
         }
+        DeltaBatch batch{getL2Book()};
+        EpochDomain::WriteScope write{epochDomain_};
         Order *order = derived()->cancelOrderImpl(orderId);
         onOrderCancelled(order);
     }
@@ -76,13 +100,126 @@ class L3OrderBook : public L3OrderBookBase {
         if (!derived()->orderExistsImpl(orderId)) [[unlikely]] {
             return {};
         }
+        DeltaBatch batch{getL2Book()};
+        EpochDomain::WriteScope write{epochDomain_};
         Order *order = derived()->cancelOrderImpl(orderId);
+        onOrderCancelled(order);
         modify.toOrderPointer(order);
-        return derived()->addOrderImpl(order);
+        derived()->addOrderImpl(order);
+        onOrderAdded(order);
+        if (tradingMode_ == TradingMode::Auction) [[unlikely]] {
+            return {};
+        }
+        return MatchOrders(order->getSide());
+    }
+
+    // stop continuous matching, orders accumulate until uncross()
+    void startAuction() { tradingMode_ = TradingMode::Auction; }
+
+    TradingMode getTradingMode() const { return tradingMode_; }
+
+    // equilibrium price if the auction uncrossed now: maximum executable volume,
+    // then minimum imbalance, then the lowest price
+    UncrossInfo getIndicativeUncross() {
+        UncrossInfo result;
+        if (isBidEmpty() || isAskEmpty()) {
+            return result;
+        }
+
+        const Price bestBidPrice = levelPrice(derived()->getBestBidLevelImpl());
+        const Price bestAskPrice = levelPrice(derived()->getBestAskLevelImpl());
+        if (bestBidPrice < bestAskPrice) {
+            return result;
+        }
+
+        // only the crossed range [bestAsk, bestBid] can trade
+        auctionBids_.clear();
+        auctionAsks_.clear();
+        Quantity totalBid = 0;
+        derived()->getL2BookImpl()->forEachBidLevel(
+            bestAskPrice, bestBidPrice, [this, &totalBid](const L2LevelInfo &info) {
+                auctionBids_.push_back(info);
+                totalBid += info.quantity_;
+                return true;
+            });
+        derived()->getL2BookImpl()->forEachAskLevel(
+            bestAskPrice, bestBidPrice, [this](const L2LevelInfo &info) {
+                auctionAsks_.push_back(info);
+                return true;
+            });
+
+        // single ascending pass over candidate prices:
+        // ask depth accumulates, bid depth is what remains at or above the price
+        auto bidIt = auctionBids_.rbegin();  // ascending
+        auto askIt = auctionAsks_.begin();   // ascending
+        Quantity askDepth = 0;
+        Quantity bidBelow = 0;
+        while (bidIt != auctionBids_.rend() || askIt != auctionAsks_.end()) {
+            Price price;
+            if (askIt == auctionAsks_.end()) {
+                price = bidIt->price_;
+            } else if (bidIt == auctionBids_.rend()) {
+                price = askIt->price_;
+            } else {
+                price = std::min(bidIt->price_, askIt->price_);
+            }
+
+            if (askIt != auctionAsks_.end() && askIt->price_ == price) {
+                askDepth += askIt->quantity_;
+                ++askIt;
+            }
+            Quantity bidDepth = totalBid - bidBelow;
+            if (bidIt != auctionBids_.rend() && bidIt->price_ == price) {
+                bidBelow += bidIt->quantity_;
+                ++bidIt;
+            }
+
+            Quantity volume = std::min(bidDepth, askDepth);
+            Quantity imbalance = bidDepth - askDepth;
+            if (volume > result.volume_ ||
+                (volume == result.volume_ && volume > 0 &&
+                 std::abs(imbalance) < std::abs(result.imbalance_))) {
+                result = UncrossInfo{price, volume, imbalance};
+            }
+        }
+        return result;
+    }
+
+    // execute every crossed order at the equilibrium price and
+    // return to continuous trading
+    Trades uncross() {
+        DeltaBatch batch{getL2Book()};
+        EpochDomain::WriteScope write{epochDomain_};
+        UncrossInfo info = getIndicativeUncross();
+        tradingMode_ = TradingMode::Continuous;
+
+        Trades trades;
+        if (info.volume_ == 0) {
+            return trades;
+        }
+
+        // the side with surplus depth is rationed by the allocation policy
+        Side aggressorSide = info.imbalance_ > 0 ? Side::Sell : Side::Buy;
+        const Price price = info.price_;
+        while (!isBidEmpty() && !isAskEmpty()) {
+            auto &[bidPrice, bids] = derived()->getBestBidLevelImpl();
+            auto &[askPrice, asks] = derived()->getBestAskLevelImpl();
+
+            if (bidPrice < price || askPrice > price) break;
+
+            matchLevels(bids, asks, price, price, aggressorSide, trades);
+        }
+        return trades;
     }
 
     size_t getOrderCount() const { return derived()->getOrderCountImpl(); }
 
+    // the order rests in the book
+    bool hasOrder(const OrderId &orderId) const { return derived()->orderExistsImpl(orderId); }
+
+    // bytes held by levels, indexes, level containers and the L2 mirror
+    BookMemoryUsage memoryUsage() const { return derived()->memoryUsageImpl(); }
+
     void print() const { derived()->printImpl(); }
 
     bool isBidEmpty() const { return derived()->bidLevels_.empty(); }
@@ -91,7 +228,50 @@ class L3OrderBook : public L3OrderBookBase {
     Order *getBestBid() { return derived()->getBestBidImpl(); }
     Order *getBestAsk() { return derived()->getBestAskImpl(); }
 
+    // aggregated price levels maintained alongside the orders
+    auto &getL2Book() { return *derived()->getL2BookImpl(); }
+    const auto &getL2Book() const { return *derived()->getL2BookImpl(); }
+
+    // every modification bumps the epoch of the domain of resource, so that
+    // other threads can read the book with readOrders(). The book's nodes must
+    // be deallocated through resource, throws std::invalid_argument
+    // otherwise; nullptr detaches
+    void setEpochDomain(EpochResource *resource) {
+        static_assert(readableAllocator(), "only an EpochResource keeps nodes for readers");
+        if (resource == nullptr) {
+            epochDomain_ = nullptr;
+            return;
+        }
+        if (derived()->get_allocator().resource() != resource) {
+            throw std::invalid_argument("book nodes are not deallocated through the resource");
+        }
+        epochDomain_ = &resource->domain();
+    }
+
+    // Walks the resting orders of side level by level from a reader thread
+    // while the matching thread keeps modifying the book. The book must be
+    // attached to the domain of guard, see setEpochDomain(), and removed
+    // orders retired, not freed. f(Price, const
+    // Order &) returns false to stop. Returns false if the book was modified
+    // meanwhile, what f saw may then be torn: take a new guard and retry.
+    template <typename F>
+    bool readOrders(const EpochDomain::Guard &guard, Side side, F &&f) const {
+        static_assert(Derived::STABLE_LEVELS, "levels move in memory, readers cannot follow");
+        static_assert(readableAllocator(), "only an EpochResource keeps nodes for readers");
+        if (side == Side::Buy) {
+            return walkOrders(guard, derived()->bidLevels_, f);
+        }
+        return walkOrders(guard, derived()->askLevels_, f);
+    }
+
    protected:
+    // nodes can go through an EpochResource, others are freed at once
+    static constexpr bool readableAllocator() {
+        using Allocator =
+            std::decay_t<decltype(std::declval<const Derived &>().get_allocator())>;
+        return std::is_same_v<Allocator, ArenaBookAllocator>;
+    }
+
     bool canFullyFill(Side side, Price price, Quantity quantity) {
         if (!canMatch(side, price)) return false;
 
@@ -99,18 +279,18 @@ class L3OrderBook : public L3OrderBookBase {
             const auto &[askPrice, _] = derived()->getBestAskLevelImpl();
 
             derived()->getL2BookImpl()->forEachAskLevel(
-                price, askPrice, [&quantity](const L2LevelInfo &info) -> bool {
+                askPrice, price, [&quantity](const L2LevelInfo &info) -> bool {
                     quantity -= info.quantity_;
-                    return quantity <= 0;
+                    return quantity > 0;
                 });
 
         } else {
             const auto [bidPrice, _] = derived()->getBestBidLevelImpl();
 
             derived()->getL2BookImpl()->forEachBidLevel(
-                bidPrice, price, [&quantity](const L2LevelInfo &info) -> bool {
+                price, bidPrice, [&quantity](const L2LevelInfo &info) -> bool {
                     quantity -= info.quantity_;
-                    return quantity <= 0;
+                    return quantity > 0;
                 });
         }
 
@@ -118,23 +298,19 @@ class L3OrderBook : public L3OrderBookBase {
     }
 
     // determines if an order can be matched immediately
+    // reads the cached top of book of the L2 mirror
     bool canMatch(Side side, Price price) {
+        const BestBidOffer &bbo = getL2Book().getBestBidOfferUnsafe();
         if (side == Side::Buy) {
-            if (isAskEmpty()) [[unlikely]] {
-                return false;
-            }
-            const auto &[askPrice, _] = derived()->getBestAskLevelImpl();
-            return askPrice <= price;
+            return bbo.hasAsk() && bbo.askPrice_ <= price;
         } else {
-            if (isBidEmpty()) [[unlikely]] {
-                return false;
-            }
-            const auto &[bidPrice, _] = derived()->getBestBidLevelImpl();
-            return bidPrice >= price;
+            return bbo.hasBid() && bbo.bidPrice_ >= price;
         }
     }
 
-    Trades MatchOrders() {
+    // aggressorSide is the side of the order that triggered matching,
+    // the other side is resting and gets allocated by AllocationPolicy
+    Trades MatchOrders(Side aggressorSide) {
         Trades trades;
 
         while (true) {
@@ -146,61 +322,155 @@ class L3OrderBook : public L3OrderBookBase {
             // no cross
             if (bidPrice < askPrice) break;
 
-            using BidLevelContainer = std::remove_reference_t<decltype(bids)>;
-            using AskLevelContainer = std::remove_reference_t<decltype(asks)>;
+            matchLevels(bids, asks, bidPrice, askPrice, aggressorSide, trades);
+        }
 
-            while (!bids.empty() && !asks.empty()) {
-                auto bidIt = LevelContainerTraits<BidLevelContainer>::first(bids);
-                auto askIt = LevelContainerTraits<AskLevelContainer>::first(asks);
+        if (!isBidEmpty()) {
+            Order *order = derived()->getBestBidImpl();
+            if (order->getOrderType() == OrderType::FillAndKill) {
+                cancelOrder(order->getOrderId());
+            }
+        }
 
-                auto bid = *bidIt;
-                auto ask = *askIt;
+        if (!isAskEmpty()) {
+            Order *order = derived()->getBestAskImpl();
+            if (order->getOrderType() == OrderType::FillAndKill) {
+                cancelOrder(order->getOrderId());
+            }
+        }
+        return trades;
+    }
 
-                Quantity quantity =
-                    std::min(bid->getRemainingQuantity(), ask->getRemainingQuantity());
+    // match the best bid level against the best ask level
+    // and remove whichever becomes empty
+    template <typename LevelContainer>
+    void matchLevels(LevelContainer &bids, LevelContainer &asks, Price bidPrice,
+                     Price askPrice, Side aggressorSide, Trades &trades) {
+        // level prices are keys of the level, copy them before it gets erased
+        const Price bidLevelPrice = levelPrice(derived()->getBestBidLevelImpl());
+        const Price askLevelPrice = levelPrice(derived()->getBestAskLevelImpl());
+
+        if constexpr (std::same_as<AllocationPolicy, PriceTimeAllocation>) {
+            matchLevelsFifo(bids, bidPrice, asks, askPrice, trades);
+        } else if (aggressorSide == Side::Buy) {
+            matchLevelsAllocated(bids, bidPrice, asks, askPrice, trades);
+        } else {
+            matchLevelsAllocated(asks, askPrice, bids, bidPrice, trades);
+        }
 
-                bid->fill(quantity);
-                ask->fill(quantity);
+        if (LevelContainerTraits<LevelContainer>::empty(bids)) {
+            derived()->removeEmptyBidLevelImpl(bidLevelPrice);
+        }
 
-                trades.emplace_back(TradeInfo{bid->getOrderId(), bidPrice, quantity},
-                                    TradeInfo{ask->getOrderId(), askPrice, quantity});
+        if (LevelContainerTraits<LevelContainer>::empty(asks)) {
+            derived()->removeEmptyAskLevelImpl(askLevelPrice);
+        }
+    }
 
-                onOrderMatched(bid, ask, quantity);
+    // price-time: pair the first order of each level until one level empties
+    template <typename LevelContainer>
+    void matchLevelsFifo(LevelContainer &bids, Price bidPrice, LevelContainer &asks,
+                         Price askPrice, Trades &trades) {
+        while (!bids.empty() && !asks.empty()) {
+            auto bidIt = LevelContainerTraits<LevelContainer>::first(bids);
+            auto askIt = LevelContainerTraits<LevelContainer>::first(asks);
 
-                if (bid->isFilled()) {
-                    derived()->levelRemoveOrderImpl(bids, bidIt);
-                    onOrderCancelled(bid, false);
-                }
+            auto bid = *bidIt;
+            auto ask = *askIt;
 
-                if (ask->isFilled()) {
-                    derived()->levelRemoveOrderImpl(asks, askIt);
-                    onOrderCancelled(bid, false);
-                }
-            }
+            Quantity quantity =
+                std::min(bid->getRemainingQuantity(), ask->getRemainingQuantity());
 
-            if (LevelContainerTraits<BidLevelContainer>::empty(bids)) {
-                derived()->removeEmptyBidLevelImpl(bidPrice);
+            executeMatch(bid, bidPrice, ask, askPrice, quantity, trades);
+
+            if (bid->isFilled()) {
+                derived()->levelRemoveOrderImpl(bids, bidIt);
+                onOrderCancelled(bid, false);
             }
 
-            if (LevelContainerTraits<AskLevelContainer>::empty(asks)) {
-                derived()->removeEmptyAskLevelImpl(askPrice);
+            if (ask->isFilled()) {
+                derived()->levelRemoveOrderImpl(asks, askIt);
+                onOrderCancelled(ask, false);
             }
         }
+    }
 
-        if (!isBidEmpty()) {
-            Order *order = derived()->getBestBidImpl();
-            if (order->getOrderType() == OrderType::FillAndKill) {
-                cancelOrder(order->getOrderId());
-            }
+    // each aggressing order in time priority is split across the whole resting
+    // level in one call to AllocationPolicy::allocate; the resting quantities
+    // are gathered once per level and kept in step as allocations are applied
+    template <typename LevelContainer>
+    void matchLevelsAllocated(LevelContainer &aggressors, Price aggressorPrice,
+                              LevelContainer &resting, Price restingPrice,
+                              Trades &trades) {
+        auto &[quantities, allocations] = allocationScratch_;
+
+        // gather resting quantities into a contiguous array
+        quantities.clear();
+        for (const Order *order : resting) {
+            quantities.push_back(order->getRemainingQuantity());
         }
 
-        if (!isAskEmpty()) {
-            Order *order = derived()->getBestAskImpl();
-            if (order->getOrderType() == OrderType::FillAndKill) {
-                cancelOrder(order->getOrderId());
+        while (!aggressors.empty() && !resting.empty()) {
+            auto aggressorIt = LevelContainerTraits<LevelContainer>::first(aggressors);
+            Order *aggressor = *aggressorIt;
+
+            allocations.resize(quantities.size());
+            AllocationPolicy::allocate(aggressor->getRemainingQuantity(), quantities.data(),
+                                       allocations.data(), quantities.size());
+
+            // apply allocations, erasing an order does not invalidate the others;
+            // filled entries are compacted out of quantities
+            auto it = LevelContainerTraits<LevelContainer>::first(resting);
+            size_t kept = 0;
+            for (size_t i = 0; i < allocations.size(); i++) {
+                auto restingIt = it++;
+                Quantity left = quantities[i] - allocations[i];
+                if (left > 0) {
+                    quantities[kept++] = left;
+                }
+                if (allocations[i] == 0) {
+                    continue;
+                }
+
+                Order *order = *restingIt;
+                if (aggressor->getSide() == Side::Buy) {
+                    executeMatch(aggressor, aggressorPrice, order, restingPrice,
+                                 allocations[i], trades);
+                } else {
+                    executeMatch(order, restingPrice, aggressor, aggressorPrice,
+                                 allocations[i], trades);
+                }
+
+                if (order->isFilled()) {
+                    derived()->levelRemoveOrderImpl(resting, restingIt);
+                    onOrderCancelled(order, false);
+                }
+            }
+            quantities.resize(kept);
+
+            if (aggressor->isFilled()) {
+                derived()->levelRemoveOrderImpl(aggressors, aggressorIt);
+                onOrderCancelled(aggressor, false);
             }
         }
-        return trades;
+    }
+
+    // levels are either (price, container) pairs or L3LevelInfo
+    template <typename Level>
+    static Price levelPrice(const Level &level) {
+        const auto &[price, _] = level;
+        return price;
+    }
+
+    void executeMatch(Order *bid, Price bidPrice, Order *ask, Price askPrice,
+                      Quantity quantity, Trades &trades) {
+        bid->fill(quantity);
+        ask->fill(quantity);
+
+        trades.emplace_back(TradeInfo{bid->getOrderId(), bidPrice, quantity},
+                            TradeInfo{ask->getOrderId(), askPrice, quantity});
+
+        onOrderMatched(bid, ask, quantity);
     }
 
     void onOrderCancelled(Order *order, bool updateL2 = true) {
@@ -216,8 +486,11 @@ class L3OrderBook : public L3OrderBookBase {
     }
 
     void onOrderMatched(Order *bid, const Order *ask, Quantity quantity) {
-        derived()->getL2BookImpl()->cancelOrder(Side::Buy, bid->price_, quantity);
-        derived()->getL2BookImpl()->cancelOrder(Side::Sell, ask->price_, quantity);
+        // a filled order leaves its level
+        derived()->getL2BookImpl()->cancelOrder(Side::Buy, bid->price_, quantity,
+                                                bid->isFilled());
+        derived()->getL2BookImpl()->cancelOrder(Side::Sell, ask->price_, quantity,
+                                                ask->isFilled());
         // TODO: support external callback
     }
 
@@ -227,6 +500,48 @@ class L3OrderBook : public L3OrderBookBase {
 
     Derived *derived() { return static_cast<Derived *>(this); }
     const Derived *derived() const { return static_cast<const Derived *>(this); }
+
+   private:
+    // a torn level may link anywhere, validate often enough to leave it
+    static constexpr size_t READ_VALIDATE_INTERVAL = 64;
+
+    template <typename Levels, typename F>
+    static bool walkOrders(const EpochDomain::Guard &guard, const Levels &levels, F &f) {
+        size_t steps = 0;
+        for (const auto &level : levels) {
+            if (!guard.validate()) {
+                return false;
+            }
+            const auto &[price, orders] = level;
+            for (const Order *order : orders) {
+                if (++steps % READ_VALIDATE_INTERVAL == 0 && !guard.validate()) {
+                    return false;
+                }
+                if (!f(price, *order)) {
+                    return guard.validate();
+                }
+            }
+        }
+        return guard.validate();
+    }
+
+    TradingMode tradingMode_{TradingMode::Continuous};
+    EpochDomain *epochDomain_{nullptr};
+
+    // scratch buffers reused across matches by non price-time policies,
+    // price-time books carry none
+    struct AllocationScratch {
+        std::vector<Quantity> resting_;
+        std::vector<Quantity> allocations_;
+    };
+    struct NoAllocationScratch {};
+    [[no_unique_address]] std::conditional_t<std::same_as<AllocationPolicy, PriceTimeAllocation>,
+                                             NoAllocationScratch, AllocationScratch>
+        allocationScratch_;
+
+    // scratch buffers for the equilibrium price search
+    std::vector<L2LevelInfo> auctionBids_;
+    std::vector<L2LevelInfo> auctionAsks_;
 };
 
 #endif  // _BOOK_L3_HPP
\ No newline at end of file
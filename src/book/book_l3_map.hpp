@@ -3,21 +3,39 @@
 
 #include "book_l3.hpp"
 #include "book_l2_map.hpp"
+#include "book_memory.hpp"
 #include "book_l2_vector.hpp"
 #include "level_searcher.hpp"
+#include "order_index.h"
 
 // NOTE: do not use vector for level container (because of it invalidation)
-template <LevelContainerBase LevelContainer, typename L2BookInternal = MapBasedL2OrderBook>
+// with ArenaBookAllocator, pmr level containers and L2 book share the arena
+template <LevelContainerBase LevelContainer, typename L2BookInternal = MapBasedL2OrderBook,
+          LevelAllocationPolicy AllocationPolicy = PriceTimeAllocation,
+          typename Allocator = DefaultBookAllocator>
     requires std::same_as<typename LevelContainer::value_type, Order*> &&
              std::default_initializable<L2BookInternal>
-class MapBasedL3OrderBook : public L3OrderBook<MapBasedL3OrderBook<LevelContainer, L2BookInternal>> {
-    friend class L3OrderBook<MapBasedL3OrderBook<LevelContainer, L2BookInternal>>;
+class MapBasedL3OrderBook
+    : private BookMemory<Allocator>,
+      public L3OrderBook<
+          MapBasedL3OrderBook<LevelContainer, L2BookInternal, AllocationPolicy, Allocator>,
+          L3OrderBookBase, AllocationPolicy> {
+    friend class L3OrderBook<
+        MapBasedL3OrderBook<LevelContainer, L2BookInternal, AllocationPolicy, Allocator>,
+        L3OrderBookBase, AllocationPolicy>;
 
    public:
     MapBasedL3OrderBook() = default;
+    explicit MapBasedL3OrderBook(const Allocator& allocator)
+        : BookMemory<Allocator>{allocator} {}
     ~MapBasedL3OrderBook() = default;
 
+    using BookMemory<Allocator>::get_allocator;
+
    protected:
+    // level and order nodes stay where they are, see readOrders()
+    static constexpr bool STABLE_LEVELS = true;
+
     void addOrderImpl(Order* order) {
         if (order->side_ == Side::Buy) {
             oidToLevelContainerItMap_[order->orderId_] =
@@ -49,8 +67,8 @@ class MapBasedL3OrderBook : public L3OrderBook<MapBasedL3OrderBook<LevelContaine
     // does not remove empty level
     void levelRemoveOrderImpl(LevelContainer& levelContainer,
                               typename LevelContainer::iterator levelContainerIt) {
-        LevelContainerTraits<LevelContainer>::erase(levelContainer, levelContainerIt);
         oidToLevelContainerItMap_.erase((*levelContainerIt)->orderId_);
+        LevelContainerTraits<LevelContainer>::erase(levelContainer, levelContainerIt);
     }
 
     void removeEmptyBidLevelImpl(Price price) {
@@ -88,6 +106,20 @@ class MapBasedL3OrderBook : public L3OrderBook<MapBasedL3OrderBook<LevelContaine
 
     void printImpl() const {}
 
+    BookMemoryUsage memoryUsageImpl() const {
+        BookMemoryUsage usage;
+        usage.levels_ = containerBytes(bidLevels_) + containerBytes(askLevels_);
+        usage.priceIndex_ =
+            containerBytes(priceToBidLevelItMap_) + containerBytes(priceToAskLevelItMap_);
+        usage.orderIndex_ = containerBytes(oidToLevelContainerItMap_);
+        // one node per resting order
+        usage.levelContainers_ = getOrderCountImpl() * nodeBytes<LevelContainer>();
+        BookMemoryUsage l2 = l2_book_.memoryUsage();
+        usage.l2Mirror_ = l2.total();
+        usage.arena_ = this->arenaBytes() + l2.arena_;
+        return usage;
+    }
+
     template <typename T, typename M>
     decltype(auto) addOrderToMap(T& levels, M& price2levelIt, Order* order) {
         if (price2levelIt.contains(order->price_)) [[likely]] {
@@ -95,7 +127,8 @@ class MapBasedL3OrderBook : public L3OrderBook<MapBasedL3OrderBook<LevelContaine
             return LevelContainerTraits<LevelContainer>::insert(levelContainer, order);
         }
         // create a new level
-        auto [it, inserted] = levels.emplace(order->price_, LevelContainer{});
+        auto [it, inserted] = levels.emplace(
+            order->price_, makeLevelContainer<LevelContainer>(get_allocator()));
         price2levelIt[order->price_] = it;
 
         // insert order into the level
@@ -118,17 +151,25 @@ class MapBasedL3OrderBook : public L3OrderBook<MapBasedL3OrderBook<LevelContaine
         }
     }
 
-    std::map<Price, LevelContainer, std::greater<Price>> bidLevels_;
-    std::map<Price, LevelContainer, std::less<Price>> askLevels_;
-
-    std::unordered_map<Price, typename decltype(bidLevels_)::iterator>
-        priceToBidLevelItMap_;
-    std::unordered_map<Price, typename decltype(askLevels_)::iterator>
-        priceToAskLevelItMap_;
-    std::unordered_map<OrderId, typename LevelContainer::iterator>
-        oidToLevelContainerItMap_;
-
-    L2BookInternal l2_book_;
+    template <typename Compare>
+    using Levels = std::map<Price, LevelContainer, Compare,
+                            BookRebind<Allocator, std::pair<const Price, LevelContainer>>>;
+    template <typename Iterator>
+    using PriceIndex = std::unordered_map<Price, Iterator, std::hash<Price>,
+                                          std::equal_to<Price>,
+                                          BookRebind<Allocator, std::pair<const Price, Iterator>>>;
+
+    Levels<std::greater<Price>> bidLevels_{get_allocator()};
+    Levels<std::less<Price>> askLevels_{get_allocator()};
+
+    PriceIndex<typename decltype(bidLevels_)::iterator> priceToBidLevelItMap_{
+        get_allocator()};
+    PriceIndex<typename decltype(askLevels_)::iterator> priceToAskLevelItMap_{
+        get_allocator()};
+    OrderIndex<typename LevelContainer::iterator, Allocator> oidToLevelContainerItMap_{
+        get_allocator()};
+
+    L2BookInternal l2_book_{makeL2Book<L2BookInternal>(get_allocator())};
 };
 
 #endif  // _BOOK_L3_MAP_HPP
\ No newline at end of file
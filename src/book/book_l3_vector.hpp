@@ -4,18 +4,27 @@
 #include "book_l2_map.hpp"
 #include "book_l2_vector.hpp"
 #include "book_l3.hpp"
+#include "book_memory.hpp"
 #include "level_searcher.hpp"
+#include "order_index.h"
 
 // NOTE: do not use vector for level container (because of it invalidation)
+// with ArenaBookAllocator, pmr level containers and L2 book share the arena
 template <LevelContainerBase LevelContainer, typename LevelSearcher = BinaryLevelSearcher,
-          typename L2BookInternal = MapBasedL2OrderBook, size_t MAX_DEPTH = 65536>
+          typename L2BookInternal = MapBasedL2OrderBook, size_t MAX_DEPTH = 65536,
+          LevelAllocationPolicy AllocationPolicy = PriceTimeAllocation,
+          typename Allocator = DefaultBookAllocator>
     requires std::same_as<typename LevelContainer::value_type, Order*> &&
              std::default_initializable<L2BookInternal>
 class VectorBasedL3OrderBook
-    : public L3OrderBook<VectorBasedL3OrderBook<LevelContainer, LevelSearcher,
-                                                L2BookInternal, MAX_DEPTH>> {
-    friend class L3OrderBook<
-        VectorBasedL3OrderBook<LevelContainer, LevelSearcher, L2BookInternal, MAX_DEPTH>>;
+    : private BookMemory<Allocator>,
+      public L3OrderBook<VectorBasedL3OrderBook<LevelContainer, LevelSearcher, L2BookInternal,
+                                                MAX_DEPTH, AllocationPolicy, Allocator>,
+                         L3OrderBookBase, AllocationPolicy> {
+    friend class L3OrderBook<VectorBasedL3OrderBook<LevelContainer, LevelSearcher,
+                                                    L2BookInternal, MAX_DEPTH,
+                                                    AllocationPolicy, Allocator>,
+                             L3OrderBookBase, AllocationPolicy>;
 
    public:
     VectorBasedL3OrderBook() {
@@ -24,9 +33,20 @@ class VectorBasedL3OrderBook
         askLevels_.reserve(MAX_DEPTH);
     }
 
+    explicit VectorBasedL3OrderBook(const Allocator& allocator)
+        : BookMemory<Allocator>{allocator} {
+        bidLevels_.reserve(MAX_DEPTH);
+        askLevels_.reserve(MAX_DEPTH);
+    }
+
+    using BookMemory<Allocator>::get_allocator;
+
     ~VectorBasedL3OrderBook() = default;
 
    protected:
+    // inserting or erasing a level moves the ones after it
+    static constexpr bool STABLE_LEVELS = false;
+
     void addOrderImpl(Order* order) {
         if (order->side_ == Side::Buy) {
             oidToLevelContainerItMap_[order->orderId_] =
@@ -58,8 +78,8 @@ class VectorBasedL3OrderBook
     // does not remove empty level
     void levelRemoveOrderImpl(LevelContainer& levelContainer,
                               typename LevelContainer::iterator levelContainerIt) {
-        LevelContainerTraits<LevelContainer>::erase(levelContainer, levelContainerIt);
         oidToLevelContainerItMap_.erase((*levelContainerIt)->orderId_);
+        LevelContainerTraits<LevelContainer>::erase(levelContainer, levelContainerIt);
     }
 
     void removeEmptyBidLevelImpl(Price price) {
@@ -93,8 +113,22 @@ class VectorBasedL3OrderBook
         return oidToLevelContainerItMap_.contains(orderId);
     }
 
+    auto getOrderCountImpl() const { return oidToLevelContainerItMap_.size(); }
+
     void printImpl() const {}
 
+    BookMemoryUsage memoryUsageImpl() const {
+        BookMemoryUsage usage;
+        usage.levels_ = containerBytes(bidLevels_) + containerBytes(askLevels_);
+        usage.orderIndex_ = containerBytes(oidToLevelContainerItMap_);
+        // one node per resting order
+        usage.levelContainers_ = getOrderCountImpl() * nodeBytes<LevelContainer>();
+        BookMemoryUsage l2 = l2_book_.memoryUsage();
+        usage.l2Mirror_ = l2.total();
+        usage.arena_ = this->arenaBytes() + l2.arena_;
+        return usage;
+    }
+
    private:
     template <typename T, typename Compare>
     decltype(auto) levelAddOrder(T& levels, Order* order, Compare cmp) {
@@ -107,7 +141,8 @@ class VectorBasedL3OrderBook
         }
 
         // price level doesn't exist, create a new level
-        auto vecIt = levels.insert(it, L3LevelInfo{order->price_, LevelContainer{}});
+        auto vecIt = levels.insert(
+            it, L3LevelInfo{order->price_, makeLevelContainer<LevelContainer>(get_allocator())});
         return LevelContainerTraits<LevelContainer>::insert(vecIt->levelContainer_,
                                                             order);
     }
@@ -128,14 +163,15 @@ class VectorBasedL3OrderBook
         }
     }
 
-    using Levels = std::vector<L3LevelInfo<LevelContainer>>;
-    Levels bidLevels_;  // largest price at the end
-    Levels askLevels_;  // smallest price at the end
+    using Levels = std::vector<L3LevelInfo<LevelContainer>,
+                               BookRebind<Allocator, L3LevelInfo<LevelContainer>>>;
+    Levels bidLevels_{get_allocator()};  // largest price at the end
+    Levels askLevels_{get_allocator()};  // smallest price at the end
 
-    std::unordered_map<OrderId, typename LevelContainer::iterator>
-        oidToLevelContainerItMap_;
+    OrderIndex<typename LevelContainer::iterator, Allocator> oidToLevelContainerItMap_{
+        get_allocator()};
 
-    L2BookInternal l2_book_;
+    L2BookInternal l2_book_{makeL2Book<L2BookInternal>(get_allocator())};
 };
 
 #endif  // _BOOK_L3_VECTOR_HPP
\ No newline at end of file
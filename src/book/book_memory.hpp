@@ -0,0 +1,247 @@
+#ifndef _BOOK_MEMORY_HPP
+#define _BOOK_MEMORY_HPP
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "util/pageprovider.h"
+
+// Allocators a book can be instantiated with. The containers of a book (levels,
+// price maps, order index, level containers) are all rebound from it.
+//
+// the default takes large blocks from the page provider, nodes from the heap
+using DefaultBookAllocator = ProviderAllocator<std::byte>;
+// nodes from a per-book arena, see BookArena
+using ArenaBookAllocator = std::pmr::polymorphic_allocator<std::byte>;
+
+template <typename Allocator, typename T>
+using BookRebind = typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+
+// Node storage of one book. Nodes are recycled in size-class pools carved from
+// chunks of the page provider, so related nodes sit close together and a book
+// never contends on the global allocator. Not thread safe, like the book.
+class BookArena {
+   public:
+    explicit BookArena(PageProvider &provider = PageProvider::current())
+        : upstream_{provider}, pool_{options(), &upstream_} {}
+
+    BookArena(const BookArena &) = delete;
+    BookArena &operator=(const BookArena &) = delete;
+
+    std::pmr::memory_resource *resource() { return &pool_; }
+
+    // pages taken from the provider, freed nodes stay in the pools
+    size_t mapped_bytes() const { return upstream_.mapped_bytes(); }
+
+   private:
+    static std::pmr::pool_options options() {
+        std::pmr::pool_options opts;
+        opts.max_blocks_per_chunk = 4096;
+        opts.largest_required_pool_block = 512;
+        return opts;
+    }
+
+    ProviderResource upstream_;
+    std::pmr::unsynchronized_pool_resource pool_;
+};
+
+// Base of every book holding its allocator. With ArenaBookAllocator the book
+// owns a BookArena, unless it is handed an allocator to share one.
+template <typename Allocator>
+class BookMemory {
+   public:
+    BookMemory() = default;
+    explicit BookMemory(const Allocator &allocator) : allocator_{allocator} {}
+
+    const Allocator &get_allocator() const { return allocator_; }
+
+   protected:
+    size_t arenaBytes() const { return 0; }
+
+   private:
+    Allocator allocator_;
+};
+
+template <>
+class BookMemory<ArenaBookAllocator> {
+   public:
+    BookMemory() : arena_{std::make_unique<BookArena>()}, allocator_{arena_->resource()} {}
+    explicit BookMemory(const ArenaBookAllocator &allocator) : allocator_{allocator} {}
+
+    const ArenaBookAllocator &get_allocator() const { return allocator_; }
+
+   protected:
+    // only an owned arena, a shared one is reported by its owner
+    size_t arenaBytes() const { return arena_ ? arena_->mapped_bytes() : 0; }
+
+   private:
+    std::unique_ptr<BookArena> arena_;
+    ArenaBookAllocator allocator_;
+};
+
+// Heap bytes of the containers of a book, from the sizes the containers keep
+// anyway, so nothing is traversed. Node layouts are those of libstdc++.
+template <typename Container>
+constexpr size_t nodeBytes() {
+    using Value = typename Container::value_type;
+    constexpr size_t ptr = sizeof(void *);
+    size_t bytes;
+    if constexpr (requires { typename Container::hasher; }) {
+        // next pointer, the hash is cached unless hashing is cheap
+        bool cached = !std::is_arithmetic_v<typename Container::key_type>;
+        bytes = ptr + sizeof(Value) + (cached ? sizeof(size_t) : 0);
+    } else if constexpr (requires { typename Container::key_compare; }) {
+        // color, parent, left, right
+        bytes = 4 * ptr + sizeof(Value);
+    } else if constexpr (requires(Container c) { c[0]; }) {
+        // vector, deque: no nodes
+        return sizeof(Value);
+    } else if constexpr (requires(Container c) { c.before_begin(); }) {
+        bytes = ptr + sizeof(Value);
+    } else {
+        bytes = 2 * ptr + sizeof(Value);
+    }
+    return (bytes + ptr - 1) / ptr * ptr;
+}
+
+template <typename Container>
+size_t containerBytes(const Container &container) {
+    using Value = typename Container::value_type;
+    if constexpr (requires { container.capacity(); }) {
+        return container.capacity() * sizeof(Value);
+    } else if constexpr (requires { container.bucket_count(); }) {
+        return container.size() * nodeBytes<Container>() +
+               container.bucket_count() * sizeof(void *);
+    } else {
+        return container.size() * nodeBytes<Container>();
+    }
+}
+
+// Memory of one book by structure, see memoryUsage() of the L2 and L3 books.
+struct BookMemoryUsage {
+    size_t levels_{0};           // level maps or vectors
+    size_t priceIndex_{0};       // price -> level
+    size_t orderIndex_{0};       // order id -> position in the level
+    size_t levelContainers_{0};  // the orders' nodes in their levels
+    size_t l2Mirror_{0};         // the L2 book of an L3 book
+    // pages of the book's own arena, the structures above live in them
+    size_t arena_{0};
+
+    size_t total() const {
+        return levels_ + priceIndex_ + orderIndex_ + levelContainers_ + l2Mirror_;
+    }
+
+    BookMemoryUsage &operator+=(const BookMemoryUsage &other) {
+        levels_ += other.levels_;
+        priceIndex_ += other.priceIndex_;
+        orderIndex_ += other.orderIndex_;
+        levelContainers_ += other.levelContainers_;
+        l2Mirror_ += other.l2Mirror_;
+        arena_ += other.arena_;
+        return *this;
+    }
+};
+
+// Engine-wide footprint: the books and pools of every shard are added, the
+// report tells the totals and the books that grew the most.
+class MemoryReport {
+   public:
+    struct BookEntry {
+        std::string name_;
+        BookMemoryUsage usage_;
+    };
+
+    struct PoolEntry {
+        std::string name_;
+        size_t mappedBytes_;
+        size_t usedBytes_;
+    };
+
+    void addBook(std::string name, const BookMemoryUsage &usage) {
+        books_.push_back({std::move(name), usage});
+        bookTotal_ += usage;
+    }
+
+    template <typename Book>
+        requires requires(const Book &book) { book.memoryUsage(); }
+    void addBook(std::string name, const Book &book) {
+        addBook(std::move(name), book.memoryUsage());
+    }
+
+    template <typename Pool>
+    void addPool(std::string name, Pool &pool) {
+        pools_.push_back({std::move(name), pool.mapped_bytes(), pool.used_bytes()});
+        poolMappedBytes_ += pools_.back().mappedBytes_;
+    }
+
+    const BookMemoryUsage &bookTotal() const { return bookTotal_; }
+    size_t poolMappedBytes() const { return poolMappedBytes_; }
+    // structures of all books plus all pool pages
+    size_t total() const { return bookTotal_.total() + poolMappedBytes_; }
+
+    const std::vector<BookEntry> &books() const { return books_; }
+    const std::vector<PoolEntry> &pools() const { return pools_; }
+
+    // the n books using the most memory, largest first
+    std::vector<BookEntry> largestBooks(size_t n) const {
+        std::vector<BookEntry> largest = books_;
+        n = std::min(n, largest.size());
+        std::partial_sort(largest.begin(), largest.begin() + n, largest.end(),
+                          [](const BookEntry &a, const BookEntry &b) {
+                              return a.usage_.total() > b.usage_.total();
+                          });
+        largest.resize(n);
+        return largest;
+    }
+
+    void print(std::ostream &os, size_t topBooks = 10) const {
+        os << "books: " << books_.size() << ", " << bookTotal_.total() << " bytes"
+           << " (levels " << bookTotal_.levels_ << ", price index " << bookTotal_.priceIndex_
+           << ", order index " << bookTotal_.orderIndex_ << ", level containers "
+           << bookTotal_.levelContainers_ << ", l2 " << bookTotal_.l2Mirror_ << ", arenas "
+           << bookTotal_.arena_ << ")\n";
+        for (const auto &[name, usage] : largestBooks(topBooks)) {
+            os << "  " << name << ": " << usage.total() << " bytes\n";
+        }
+        for (const auto &[name, mapped, used] : pools_) {
+            os << "pool " << name << ": " << used << " of " << mapped << " bytes used\n";
+        }
+    }
+
+   private:
+    std::vector<BookEntry> books_;
+    std::vector<PoolEntry> pools_;
+    BookMemoryUsage bookTotal_;
+    size_t poolMappedBytes_{0};
+};
+
+// a level container using the book's allocator if it can
+template <typename LevelContainer, typename Allocator>
+LevelContainer makeLevelContainer(const Allocator &allocator) {
+    if constexpr (std::constructible_from<typename LevelContainer::allocator_type,
+                                          const Allocator &>) {
+        return LevelContainer(typename LevelContainer::allocator_type(allocator));
+    } else {
+        return LevelContainer();
+    }
+}
+
+// the L2 mirror of an L3 book, sharing the book's allocator if it can
+template <typename L2Book, typename Allocator>
+L2Book makeL2Book(const Allocator &allocator) {
+    if constexpr (std::constructible_from<L2Book, const Allocator &>) {
+        return L2Book(allocator);
+    } else {
+        return L2Book();
+    }
+}
+
+#endif  // _BOOK_MEMORY_HPP
@@ -0,0 +1,264 @@
+#ifndef _BOOK_REBUILD_HPP
+#define _BOOK_REBUILD_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "concurrency/spscqueue.hpp"
+#include "event_log.hpp"
+#include "order.h"
+#include "order_event.h"
+#include "trade.h"
+
+// std::string keys looked up by std::string_view
+struct StringViewHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view str) const noexcept {
+        return std::hash<std::string_view>{}(str);
+    }
+};
+
+template <typename Value>
+using StringViewMap = std::unordered_map<std::string, Value, StringViewHash, std::equal_to<>>;
+
+// Rebuilds the books of many symbols from an event log on a pool of workers.
+//
+// Books are independent, so the symbols are split between the workers and
+// each worker replays the events of its symbols in log order, in books and
+// with an order pool it owns. The calling thread decodes the log and hands
+// the events over through one SPSCQueue per worker while the workers apply
+// them. A first pass counts the events of every symbol, the symbols are then
+// given largest first to the least loaded worker, so the rebuild takes about
+// as long as the busiest symbol or an even share of the log, whichever is
+// longer. Order ids are taken as unique across the symbols of a log.
+template <typename Book, size_t QueueCapacity = 4096>
+class BookRebuilder {
+   public:
+    // the books of one worker with the pool of their orders, e.g. to be
+    // handed to a matching thread as is
+    struct Shard {
+        Shard() = default;
+        Shard(const Shard &) = delete;
+        Shard &operator=(const Shard &) = delete;
+
+        ~Shard() {
+            books_.clear();
+            for (auto &[id, order] : orders_) {
+                pool_.deallocate(order);
+            }
+        }
+
+        Book *find(std::string_view symbol) {
+            auto it = books_.find(symbol);
+            return it == books_.end() ? nullptr : it->second.get();
+        }
+
+        LocalOrderPool pool_;
+        StringViewMap<std::unique_ptr<Book>> books_;
+        // the orders of the books, by id
+        StringViewMap<Order *> orders_;
+        size_t events_{0};
+    };
+
+    struct Result {
+        Book *find(std::string_view symbol) {
+            for (auto &shard : shards_) {
+                if (Book *book = shard->find(symbol)) {
+                    return book;
+                }
+            }
+            return nullptr;
+        }
+
+        size_t book_count() const {
+            size_t count = 0;
+            for (const auto &shard : shards_) {
+                count += shard->books_.size();
+            }
+            return count;
+        }
+
+        std::vector<std::unique_ptr<Shard>> shards_;
+        size_t events_{0};
+    };
+
+    static constexpr size_t DECODE_BATCH = 1024;
+
+    explicit BookRebuilder(size_t workers) : workers_{std::max<size_t>(workers, 1)} {}
+
+    Result rebuild(const std::string &path) {
+        StringViewMap<size_t> counts;
+        {
+            EventLogReader reader{path};
+            std::vector<OrderEvent> batch(DECODE_BATCH);
+            while (size_t n = reader.read(batch.data(), batch.size())) {
+                for (size_t i = 0; i < n; i++) {
+                    countEvent(counts, batch[i].symbol());
+                }
+            }
+        }
+
+        EventLogReader reader{path};
+        return replay(assign(counts), [&reader](OrderEvent *out, size_t n) {
+            return reader.read(out, n);
+        });
+    }
+
+    // events in memory, in log order
+    Result rebuild(const std::vector<OrderEvent> &events) {
+        StringViewMap<size_t> counts;
+        for (const OrderEvent &event : events) {
+            countEvent(counts, event.symbol());
+        }
+
+        size_t next = 0;
+        return replay(assign(counts), [&events, &next](OrderEvent *out, size_t n) {
+            n = std::min(n, events.size() - next);
+            std::copy_n(events.begin() + next, n, out);
+            next += n;
+            return n;
+        });
+    }
+
+    // symbol -> worker, largest symbol first to the least loaded worker
+    StringViewMap<size_t> assign(const StringViewMap<size_t> &counts) const {
+        std::vector<std::pair<size_t, std::string_view>> bySize;
+        bySize.reserve(counts.size());
+        for (const auto &[symbol, count] : counts) {
+            bySize.emplace_back(count, symbol);
+        }
+        std::sort(bySize.begin(), bySize.end(), std::greater<>{});
+
+        std::vector<size_t> load(workers_, 0);
+        StringViewMap<size_t> assignment;
+        for (const auto &[count, symbol] : bySize) {
+            size_t worker = std::min_element(load.begin(), load.end()) - load.begin();
+            load[worker] += count;
+            assignment.emplace(symbol, worker);
+        }
+        return assignment;
+    }
+
+   private:
+    using Queue = SPSCQueue<OrderEvent, QueueCapacity>;
+
+    static void countEvent(StringViewMap<size_t> &counts, std::string_view symbol) {
+        auto it = counts.find(symbol);
+        if (it == counts.end()) [[unlikely]] {
+            it = counts.emplace(symbol, 0).first;
+        }
+        it->second++;
+    }
+
+    template <typename Decode>
+    Result replay(const StringViewMap<size_t> &assignment, Decode &&decode) {
+        Result result;
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::vector<std::thread> threads;
+        std::atomic<bool> decoded{false};
+        for (size_t i = 0; i < workers_; i++) {
+            queues.push_back(std::make_unique<Queue>());
+            result.shards_.push_back(nullptr);
+        }
+        for (size_t i = 0; i < workers_; i++) {
+            threads.emplace_back([&, i] {
+                // pages of the pool and the books are mapped by the worker
+                result.shards_[i] = std::make_unique<Shard>();
+                work(*result.shards_[i], *queues[i], decoded);
+            });
+        }
+
+        std::vector<OrderEvent> batch(DECODE_BATCH);
+        while (size_t n = decode(batch.data(), batch.size())) {
+            for (size_t i = 0; i < n; i++) {
+                auto it = assignment.find(batch[i].symbol());
+                // the first pass saw every symbol
+                Queue &queue = *queues[it->second];
+                while (!queue.emplace(batch[i])) {
+                    std::this_thread::yield();
+                }
+            }
+            result.events_ += n;
+        }
+        decoded.store(true, std::memory_order_release);
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        return result;
+    }
+
+    static void work(Shard &shard, Queue &queue, const std::atomic<bool> &decoded) {
+        for (;;) {
+            // checked first, what was pushed before is drained below
+            bool last = decoded.load(std::memory_order_acquire);
+            size_t n = queue.consume_all([&shard](const OrderEvent &event) { apply(shard, event); });
+            shard.events_ += n;
+            if (n == 0) {
+                if (last) {
+                    return;
+                }
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    static void apply(Shard &shard, const OrderEvent &event) {
+        auto bookIt = shard.books_.find(event.symbol());
+        if (bookIt == shard.books_.end()) [[unlikely]] {
+            bookIt = shard.books_.emplace(event.symbol(), std::make_unique<Book>()).first;
+        }
+        Book &book = *bookIt->second;
+
+        OrderId orderId{event.orderId()};
+        Trades trades;
+        switch (event.type_) {
+            case CommandType::Add: {
+                if (shard.orders_.contains(orderId)) [[unlikely]] {
+                    return;
+                }
+                Order *order = shard.pool_.allocate(orderId, event.orderType(), event.side_,
+                                                    event.price_, event.quantity_);
+                shard.orders_.emplace(orderId, order);
+                trades = book.addOrder(order);
+                break;
+            }
+            case CommandType::Cancel:
+                book.cancelOrder(orderId);
+                break;
+            case CommandType::Modify:
+                trades = book.modifyOrder(orderId, event.getModify());
+                break;
+        }
+
+        // orders that left the book go back to the pool
+        release(shard, book, orderId);
+        for (const Trade &trade : trades) {
+            release(shard, book, trade.bidTrade_.orderId_);
+            release(shard, book, trade.askTrade_.orderId_);
+        }
+    }
+
+    static void release(Shard &shard, const Book &book, const OrderId &orderId) {
+        if (book.hasOrder(orderId)) {
+            return;
+        }
+        auto it = shard.orders_.find(orderId);
+        if (it != shard.orders_.end()) {
+            shard.pool_.deallocate(it->second);
+            shard.orders_.erase(it);
+        }
+    }
+
+    size_t workers_;
+};
+
+#endif  // _BOOK_REBUILD_HPP
@@ -0,0 +1,346 @@
+#ifndef _COMMAND_JOURNAL_HPP
+#define _COMMAND_JOURNAL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "book_command.h"
+#include "concurrency/seqlock.hpp"
+#include "concurrency/spscqueue.hpp"
+#include "engine_runner.hpp"
+#include "event_log.hpp"
+#include "order_event.h"
+#include "util/mappedfile.h"
+#include "util/threadtuning.h"
+
+struct JournalConfig {
+    // most records made durable by one sync, the rest wait for the next
+    size_t groupRecords_{8192};
+    // how long the writer sleeps when it finds no record
+    std::chrono::microseconds idle_{50};
+    // records a producer holds back while its queue is full, allocated up
+    // front; appends past them are dropped and counted
+    size_t spillRecords_{16384};
+    // cpu of the writer thread, -1 leaves it unpinned
+    int core_{-1};
+    size_t window_{MappedAppendFile::DEFAULT_WINDOW};
+};
+
+// counters of the writer thread, published after every commit
+struct JournalStats {
+    uint64_t records_{0};
+    uint64_t commits_{0};
+    uint64_t maxGroup_{0};  // most records made durable by one sync
+};
+
+// Append-only binary journal of the commands handled by the matching threads.
+//
+// Records are OrderEvents with the book's sequence number and a checksum,
+// written back to back, so the file replays as an event log, e.g. by
+// BookRebuilder. Each matching thread appends through its own Producer into
+// an SPSCQueue and never waits: when the queue is full, records spill to a
+// fixed buffer of the producer pushed on by its next append, or by flush()
+// when the matching thread goes idle, see JournalingHandler. A record finding
+// the spill buffer full too is dropped and counted. A writer thread moves
+// records into a memory mapped file and syncs once per group: whatever was
+// queued while the last sync ran goes into the next one, so under load a
+// single sync covers many commands. Producer::durable() tells the matching
+// thread how many of its records reached the disk, e.g. to acknowledge them.
+//
+// After a crash the file may end in records never synced or torn,
+// recover() cuts it after the last intact record.
+template <size_t RingCapacity = 65536>
+class CommandJournal {
+   public:
+    // the appending end of one matching thread
+    class Producer {
+       public:
+        Producer(const Producer &) = delete;
+        Producer &operator=(const Producer &) = delete;
+
+        // false if the record was dropped, the queue and the spill buffer
+        // being full
+        bool append(const OrderEvent &event) {
+            if ((spillHead_ == spillTail_ || flush()) && ring_.emplace(event)) [[likely]] {
+                appended_++;
+                return true;
+            }
+            if (spillTail_ - spillHead_ == spill_.size()) [[unlikely]] {
+                dropped_++;
+                return false;
+            }
+            spill_[spillTail_++ % spill_.size()] = event;
+            appended_++;
+            spilled_++;
+            return true;
+        }
+
+        // pushes spilled records on, true if none is left
+        bool flush() {
+            while (spillHead_ < spillTail_) {
+                size_t begin = spillHead_ % spill_.size();
+                size_t n = std::min<size_t>(spillTail_ - spillHead_, spill_.size() - begin);
+                size_t pushed = ring_.push_n(spill_.data() + begin, n);
+                spillHead_ += pushed;
+                if (pushed < n) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // records appended so far, durable() of them are on disk, in order
+        uint64_t appended() const noexcept { return appended_; }
+        uint64_t durable() const noexcept { return durable_.load(std::memory_order_acquire); }
+        // records that went through the spill buffer
+        uint64_t spilled() const noexcept { return spilled_; }
+        // records refused by append(), never journaled
+        uint64_t dropped() const noexcept { return dropped_; }
+
+       private:
+        friend class CommandJournal;
+
+        explicit Producer(size_t spillRecords) : spill_(std::max<size_t>(spillRecords, 1)) {}
+
+        SPSCQueue<OrderEvent, RingCapacity> ring_;
+
+        // matching thread; the spill buffer is a ring of free-running indices
+        std::vector<OrderEvent> spill_;
+        uint64_t spillHead_{0};
+        uint64_t spillTail_{0};
+        uint64_t appended_{0};
+        uint64_t dropped_{0};
+        uint64_t spilled_{0};
+
+        // writer thread
+        alignas(64) std::atomic<uint64_t> durable_{0};
+        uint64_t taken_{0};
+    };
+
+    // cuts the journal at path after its last intact record, returns how
+    // many records it holds, 0 if there is no file
+    static size_t recover(const std::string &path) {
+        if (!std::filesystem::exists(path)) {
+            return 0;
+        }
+        size_t records = 0;
+        {
+            EventLogReader reader{path};
+            std::vector<OrderEvent> batch(1024);
+            while (size_t n = reader.read(batch.data(), batch.size())) {
+                size_t intact = std::find_if(batch.begin(), batch.begin() + n,
+                                             [](const OrderEvent &e) { return !e.intact(); }) -
+                                batch.begin();
+                records += intact;
+                if (intact < n) {
+                    break;
+                }
+            }
+        }
+        std::filesystem::resize_file(path, records * sizeof(OrderEvent));
+        return records;
+    }
+
+    // appends to the journal at path after recover(), throws std::system_error
+    explicit CommandJournal(const std::string &path, JournalConfig config = JournalConfig{})
+        : config_{config},
+          recovered_{recover(path)},
+          file_{path, recovered_ * sizeof(OrderEvent), config.window_} {}
+
+    ~CommandJournal() {
+        try {
+            stop();
+        } catch (const std::system_error &) {
+            // nothing to report it to
+        }
+    }
+
+    CommandJournal(const CommandJournal &) = delete;
+    CommandJournal &operator=(const CommandJournal &) = delete;
+
+    // one per matching thread; only before start(), throws std::logic_error
+    // otherwise
+    Producer &addProducer() {
+        if (running_.load(std::memory_order_relaxed)) {
+            throw std::logic_error("producers are added before the journal starts");
+        }
+        producers_.push_back(std::unique_ptr<Producer>(new Producer{config_.spillRecords_}));
+        return *producers_.back();
+    }
+
+    void start() {
+        if (running_.exchange(true)) {
+            return;
+        }
+        writer_ = std::thread([this] { run(); });
+    }
+
+    // makes every record appended durable, the producers have stopped
+    // appending; throws std::system_error if the writer failed
+    void stop() {
+        if (!running_.exchange(false)) {
+            return;
+        }
+        writer_.join();
+        if (int err = error_.load(std::memory_order_acquire)) {
+            throw std::system_error(err, std::generic_category(), "journal");
+        }
+
+        // whatever the writer's last look missed, then the spilled records,
+        // never pushed; they follow the queued ones of their producer
+        while (gather() > 0) {
+            // synced below
+        }
+        for (auto &producer : producers_) {
+            Producer &p = *producer;
+            for (; p.spillHead_ < p.spillTail_; p.spillHead_++) {
+                write(p.spill_[p.spillHead_ % p.spill_.size()]);
+                p.taken_++;
+            }
+        }
+        file_.sync();
+        for (auto &producer : producers_) {
+            producer->durable_.store(producer->taken_, std::memory_order_release);
+        }
+    }
+
+    // records found in the file on opening
+    size_t recovered() const noexcept { return recovered_; }
+
+    JournalStats stats() const { return stats_.load(); }
+
+    // errno of the failure that stopped the writer, 0 if none
+    int error() const noexcept { return error_.load(std::memory_order_acquire); }
+
+   private:
+    void run() {
+        if (config_.core_ >= 0) {
+            pinCurrentThread(config_.core_);
+        }
+        JournalStats stats;
+        try {
+            // pairs with stop(), the last look sees what was queued before
+            while (running_.load(std::memory_order_acquire)) {
+                size_t group = gather();
+                if (group == 0) {
+                    std::this_thread::sleep_for(config_.idle_);
+                    continue;
+                }
+                commit(group, stats);
+            }
+            // appended right before stop()
+            while (size_t group = gather()) {
+                commit(group, stats);
+            }
+        } catch (const std::system_error &e) {
+            error_.store(e.code().value(), std::memory_order_release);
+        }
+    }
+
+    // moves up to a group of queued records into the file
+    size_t gather() {
+        size_t group = 0;
+        for (auto &producer : producers_) {
+            size_t n = producer->ring_.consume_n(
+                config_.groupRecords_ - group, [this](OrderEvent &event) { write(event); });
+            producer->taken_ += n;
+            group += n;
+        }
+        return group;
+    }
+
+    void write(OrderEvent &event) {
+        event.checksum_ = event.computeChecksum();
+        file_.append(&event, sizeof(OrderEvent));
+    }
+
+    void commit(size_t group, JournalStats &stats) {
+        file_.sync();
+        for (auto &producer : producers_) {
+            producer->durable_.store(producer->taken_, std::memory_order_release);
+        }
+        stats.records_ += group;
+        stats.commits_++;
+        stats.maxGroup_ = std::max<uint64_t>(stats.maxGroup_, group);
+        stats_.store(stats);
+    }
+
+    JournalConfig config_;
+    size_t recovered_;
+    MappedAppendFile file_;
+    std::vector<std::unique_ptr<Producer>> producers_;
+    std::thread writer_;
+    std::atomic<bool> running_{false};
+    std::atomic<int> error_{0};
+    SeqLock<JournalStats> stats_;
+};
+
+// Handler of an EngineRunner journaling every command right after its book
+// handled it, then passing it on to Next. Books are added before the runner
+// starts, each with its symbol and the Producer of the shard driving it;
+// copies share the books. While a book has no command, idle(book) pushes on
+// the records its producer spilled.
+template <typename Book, typename Journal, typename Next = IgnoreResults>
+class JournalingHandler {
+   public:
+    explicit JournalingHandler(Next next = Next{})
+        : books_{std::make_shared<Books>()}, next_{std::move(next)} {}
+
+    // sequence is the book's last one journaled before, e.g. after recovery
+    void add(const Book &book, std::string_view symbol, typename Journal::Producer &producer,
+             uint64_t sequence = 0) {
+        books_->insert_or_assign(&book, Entry{std::string{symbol}, &producer, sequence});
+    }
+
+    // true once no record of the book's producer is left spilled
+    bool idle(const Book &book) { return books_->at(&book).producer_->flush(); }
+
+    // of the last command of book journaled
+    uint64_t sequence(const Book &book) const { return books_->at(&book).sequence_; }
+
+    void operator()(Book &book, const BookCommand &command, Trades &trades) {
+        Entry &entry = books_->at(&book);
+        const Order &order = *command.order_;
+        OrderEvent event;
+        switch (command.type_) {
+            case CommandType::Add:
+                event = OrderEvent::add(entry.symbol_, order);
+                break;
+            case CommandType::Cancel:
+                event = OrderEvent::cancel(entry.symbol_, order.getOrderId());
+                break;
+            case CommandType::Modify:
+                event = OrderEvent::modify(entry.symbol_, order.getOrderId(), command.getModify());
+                break;
+        }
+        event.sequence_ = ++entry.sequence_;
+        entry.producer_->append(event);
+        next_(book, command, trades);
+    }
+
+   private:
+    struct Entry {
+        std::string symbol_;
+        typename Journal::Producer *producer_;
+        uint64_t sequence_;
+    };
+
+    using Books = std::unordered_map<const Book *, Entry>;
+
+    // written by the thread of each book only, once the runner started
+    std::shared_ptr<Books> books_;
+    Next next_;
+};
+
+#endif  // _COMMAND_JOURNAL_HPP
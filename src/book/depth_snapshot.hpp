@@ -0,0 +1,118 @@
+#ifndef _DEPTH_SNAPSHOT_HPP
+#define _DEPTH_SNAPSHOT_HPP
+
+#include <algorithm>
+#include <limits>
+
+#include "concurrency/seqlock.hpp"
+#include "level_info.h"
+#include "side.h"
+
+// top N levels of both sides, best level first
+template <size_t N = 10>
+struct DepthSnapshot {
+    uint64_t sequence_{0};  // bumped on every published change
+    uint32_t bidDepth_{0};
+    uint32_t askDepth_{0};
+    L2LevelInfo bids_[N];
+    L2LevelInfo asks_[N];
+};
+
+// keeps a DepthSnapshot in sync with an L2 book from its level updates
+// updates below the top N are dropped without touching the shared snapshot
+template <size_t N = 10>
+class DepthSnapshotPublisher {
+   public:
+    using Snapshot = DepthSnapshot<N>;
+
+    // safe from any thread
+    Snapshot read() const noexcept { return snapshot_.load(); }
+    bool tryRead(Snapshot& snapshot) const noexcept { return snapshot_.tryLoad(snapshot); }
+
+    // level added or its quantity changed
+    void onLevelUpdated(Side side, const L2LevelInfo& info) {
+        const Snapshot& current = snapshot_.unsafeGet();
+        const L2LevelInfo* levels = side == Side::Buy ? current.bids_ : current.asks_;
+        uint32_t depth = side == Side::Buy ? current.bidDepth_ : current.askDepth_;
+
+        uint32_t pos = lowerBound(side, levels, depth, info.price_);
+        if (pos == N) {
+            // below the top N
+            return;
+        }
+
+        snapshot_.update([&](Snapshot& snapshot) {
+            L2LevelInfo* levels = side == Side::Buy ? snapshot.bids_ : snapshot.asks_;
+            uint32_t& depth = side == Side::Buy ? snapshot.bidDepth_ : snapshot.askDepth_;
+            if (pos == depth || levels[pos].price_ != info.price_) {
+                // new level, the last one falls out when full
+                std::copy_backward(levels + pos, levels + std::min<uint32_t>(depth, N - 1),
+                                   levels + std::min<uint32_t>(depth + 1, N));
+                depth = std::min<uint32_t>(depth + 1, N);
+            }
+            levels[pos] = info;
+            snapshot.sequence_++;
+        });
+    }
+
+    // level removed, refill the last slot from the book if the top N was full
+    template <typename Book>
+    void onLevelRemoved(Book& book, Side side, Price price) {
+        const Snapshot& current = snapshot_.unsafeGet();
+        const L2LevelInfo* levels = side == Side::Buy ? current.bids_ : current.asks_;
+        uint32_t depth = side == Side::Buy ? current.bidDepth_ : current.askDepth_;
+
+        uint32_t pos = lowerBound(side, levels, depth, price);
+        if (pos == depth || levels[pos].price_ != price) {
+            return;
+        }
+
+        // find the next level in the book before publishing
+        L2LevelInfo next{};
+        bool hasNext = false;
+        if (depth == N) {
+            Price last = levels[N - 1].price_;
+            auto cb = [&](const L2LevelInfo& info) {
+                if (info.price_ == last || isBetter(side, info.price_, last)) return true;
+                next = info;
+                hasNext = true;
+                return false;
+            };
+            if (side == Side::Buy) {
+                book.forEachBidLevel(std::numeric_limits<Price>::lowest(), last, cb);
+            } else {
+                book.forEachAskLevel(last, std::numeric_limits<Price>::max(), cb);
+            }
+        }
+
+        snapshot_.update([&](Snapshot& snapshot) {
+            L2LevelInfo* levels = side == Side::Buy ? snapshot.bids_ : snapshot.asks_;
+            uint32_t& depth = side == Side::Buy ? snapshot.bidDepth_ : snapshot.askDepth_;
+            std::copy(levels + pos + 1, levels + depth, levels + pos);
+            depth--;
+            if (hasNext) {
+                levels[depth++] = next;
+            }
+            snapshot.sequence_++;
+        });
+    }
+
+   private:
+    static bool isBetter(Side side, Price a, Price b) {
+        return side == Side::Buy ? a > b : a < b;
+    }
+
+    // first position whose price is not better than price, N if beyond the top N
+    static uint32_t lowerBound(Side side, const L2LevelInfo* levels, uint32_t depth,
+                               Price price) {
+        uint32_t pos = 0;
+        while (pos < depth && isBetter(side, levels[pos].price_, price)) {
+            pos++;
+        }
+        return pos;
+    }
+
+    SeqLock<Snapshot> snapshot_;
+};
+
+#endif  // _DEPTH_SNAPSHOT_HPP
\ No newline at end of file
@@ -0,0 +1,310 @@
+#ifndef _ENGINE_RUNNER_HPP
+#define _ENGINE_RUNNER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "book_command.h"
+#include "concurrency/seqlock.hpp"
+#include "concurrency/spscqueue.hpp"
+#include "concurrency/waitstrategy.hpp"
+#include "trade.h"
+#include "util/pageprovider.h"
+#include "util/threadtuning.h"
+
+// what a matching thread does after polls finding no command: spins_ polls
+// with a pause, then yields_ polls yielding the core, then sleeps sleep_
+// between polls; a zero sleep_ keeps yielding
+struct IdleBackoff {
+    uint32_t spins_{1024};
+    uint32_t yields_{64};
+    std::chrono::microseconds sleep_{50};
+};
+
+struct RunnerConfig {
+    // one matching thread per entry, pinned to that cpu, -1 leaves it unpinned
+    std::vector<int> cores_;
+    // SCHED_FIFO priority of the matching threads, 0 keeps the default policy
+    int realtimePriority_{0};
+    // prefault and lock the pages of memory_ before starting, mapped now or
+    // later, and the input queues, so none faults on first touch; see
+    // PageProvider::lockMappings. Book nodes are covered only with
+    // ArenaBookAllocator over one of memory_, DefaultBookAllocator takes
+    // them from the heap
+    bool lockMemory_{false};
+    // providers the books draw from, the process one if empty
+    std::vector<PageProvider *> memory_;
+    // stack of each matching thread faulted in before it polls
+    size_t stackPrefaultBytes_{256 << 10};
+    IdleBackoff idle_;
+};
+
+// counters of one matching thread, published every STATS_INTERVAL iterations
+// and when it stops
+struct RunnerStats {
+    uint64_t iterations_{0};
+    uint64_t idleIterations_{0};  // iterations finding no command
+    uint64_t commands_{0};
+    uint64_t maxBatch_{0};  // most commands handled in one iteration
+    uint64_t yields_{0};
+    uint64_t sleeps_{0};
+};
+
+// what the setup of a matching thread achieved, see RunnerConfig
+struct ShardSetup {
+    bool pinned_{false};
+    bool realtime_{false};
+};
+
+// results are dropped
+struct IgnoreResults {
+    template <typename Book>
+    void operator()(Book &, const BookCommand &, Trades &) const noexcept {}
+};
+
+// sets up the calling matching thread as config says, core -1 leaves it
+// unpinned
+inline ShardSetup prepareMatchingThread(const RunnerConfig &config, int core) {
+    ShardSetup setup;
+    if (core >= 0) {
+        setup.pinned_ = pinCurrentThread(core);
+    }
+    if (config.realtimePriority_ > 0) {
+        setup.realtime_ = setCurrentThreadRealtime(config.realtimePriority_);
+    }
+    if (config.stackPrefaultBytes_ > 0) {
+        prefaultStack(config.stackPrefaultBytes_);
+    }
+    return setup;
+}
+
+// locks the memory config names, true if the kernel refused none of it
+inline bool lockEngineMemory(const RunnerConfig &config) {
+    if (config.memory_.empty()) {
+        return PageProvider::process().lockMappings();
+    }
+    bool locked = true;
+    for (PageProvider *provider : config.memory_) {
+        locked &= provider->lockMappings();
+    }
+    return locked;
+}
+
+// prefaults and locks memory of the engine outside the providers, e.g. the
+// storage of its queues; true if the kernel refused none of it
+inline bool lockEngineRange(const RunnerConfig &config, void *addr, size_t bytes) {
+    PageProvider &provider =
+        config.memory_.empty() ? PageProvider::process() : *config.memory_.front();
+    size_t failures = provider.lock_failures();
+    provider.prefault(addr, bytes);
+    provider.lock(addr, bytes);
+    return provider.lock_failures() == failures;
+}
+
+// waits once after idle polls in a row found no command
+inline void idleBackoff(const IdleBackoff &policy, uint32_t idle, RunnerStats &stats) {
+    if (idle < policy.spins_) {
+        cpuRelax();
+    } else if (idle < policy.spins_ + policy.yields_ || policy.sleep_.count() == 0) {
+        std::this_thread::yield();
+        stats.yields_++;
+    } else {
+        std::this_thread::sleep_for(policy.sleep_);
+        stats.sleeps_++;
+    }
+}
+
+// lets handler finish work it deferred for book, e.g. push on buffered
+// records, once the thread driving book finds no command for it; true if
+// none is left. A handler without idle(Book &) defers nothing.
+template <typename Handler, typename Book>
+bool handlerIdle(Handler &handler, Book &book) {
+    if constexpr (requires { handler.idle(book); }) {
+        return handler.idle(book);
+    } else {
+        return true;
+    }
+}
+
+// applies command to book, returns its trades
+template <typename Book>
+Trades executeCommand(Book &book, const BookCommand &command) {
+    Trades trades;
+    switch (command.type_) {
+        case CommandType::Add:
+            trades = book.addOrder(command.order_);
+            break;
+        case CommandType::Cancel:
+            book.cancelOrder(command.order_->getOrderId());
+            break;
+        case CommandType::Modify:
+            trades = book.modifyOrder(command.order_->getOrderId(), command.getModify());
+            break;
+    }
+    return trades;
+}
+
+// Owns the matching threads of an engine.
+//
+// Each thread is a shard: it runs on its configured core and busy-polls the
+// input queues of the books attached to it, one SPSCQueue per book fed by one
+// producer thread. The thread is pinned, made real-time if permitted and its
+// stack faulted in before start() returns, so the first command sees no setup
+// cost. Handler is called on the shard's thread with the book, the command and
+// its trades after every command, by every shard, and idle(book) on the books
+// of a shard whenever its poll finds nothing, see handlerIdle.
+template <typename Book, typename Handler = IgnoreResults, size_t QueueCapacity = 4096>
+class EngineRunner {
+   public:
+    using InputQueue = SPSCQueue<BookCommand, QueueCapacity>;
+
+    static constexpr uint64_t STATS_INTERVAL = 1024;
+
+    explicit EngineRunner(RunnerConfig config, Handler handler = Handler{})
+        : config_{std::move(config)}, handler_{std::move(handler)} {
+        shards_.reserve(config_.cores_.size());
+        for (size_t i = 0; i < config_.cores_.size(); i++) {
+            shards_.push_back(std::make_unique<Shard>());
+        }
+    }
+
+    ~EngineRunner() { stop(); }
+
+    EngineRunner(const EngineRunner &) = delete;
+    EngineRunner &operator=(const EngineRunner &) = delete;
+
+    // book is driven by shard from now on, push its commands to the queue
+    // returned; only before start(), throws std::logic_error otherwise
+    InputQueue &attach(size_t shard, Book &book) {
+        if (running_.load(std::memory_order_relaxed)) {
+            throw std::logic_error("books are attached before the runner starts");
+        }
+        auto &inputs = shards_.at(shard)->inputs_;
+        inputs.push_back(std::make_unique<Input>(&book));
+        return inputs.back()->queue_;
+    }
+
+    // starts the matching threads, returns once all of them are set up
+    void start() {
+        if (running_.exchange(true)) {
+            return;
+        }
+        if (config_.lockMemory_) {
+            memoryLocked_ = lockEngineMemory(config_);
+            for (auto &shard : shards_) {
+                for (auto &input : shard->inputs_) {
+                    memoryLocked_ &= lockEngineRange(config_, input->queue_.storage(),
+                                                     InputQueue::storage_bytes());
+                }
+            }
+        }
+
+        std::atomic<size_t> ready{0};
+        for (size_t i = 0; i < shards_.size(); i++) {
+            shards_[i]->thread_ = std::thread([this, i, &ready] {
+                shards_[i]->setup_ = prepareMatchingThread(config_, config_.cores_[i]);
+                ready.fetch_add(1, std::memory_order_release);
+                run(*shards_[i]);
+            });
+        }
+        while (ready.load(std::memory_order_acquire) < shards_.size()) {
+            std::this_thread::yield();
+        }
+    }
+
+    // commands queued before are still handled
+    void stop() {
+        if (!running_.exchange(false)) {
+            return;
+        }
+        for (auto &shard : shards_) {
+            shard->thread_.join();
+        }
+    }
+
+    bool running() const { return running_.load(std::memory_order_relaxed); }
+
+    size_t shard_count() const { return shards_.size(); }
+
+    RunnerStats stats(size_t shard) const { return shards_.at(shard)->stats_.load(); }
+
+    // valid once start() returned
+    const ShardSetup &setup(size_t shard) const { return shards_.at(shard)->setup_; }
+
+    bool memoryLocked() const { return memoryLocked_; }
+
+   private:
+    struct Input {
+        explicit Input(Book *book) : book_{book} {}
+
+        Book *book_;
+        InputQueue queue_;
+    };
+
+    struct Shard {
+        std::vector<std::unique_ptr<Input>> inputs_;
+        std::thread thread_;
+        ShardSetup setup_;
+        SeqLock<RunnerStats> stats_;
+    };
+
+    void run(Shard &shard) {
+        RunnerStats stats;
+        uint32_t idle = 0;
+        // pairs with stop(), the drain below sees what was pushed before
+        while (running_.load(std::memory_order_acquire)) [[likely]] {
+            size_t handled = poll(shard);
+            stats.iterations_++;
+            if (handled > 0) {
+                stats.commands_ += handled;
+                stats.maxBatch_ = std::max<uint64_t>(stats.maxBatch_, handled);
+                idle = 0;
+            } else {
+                stats.idleIterations_++;
+                for (auto &input : shard.inputs_) {
+                    handlerIdle(handler_, *input->book_);
+                }
+                idleBackoff(config_.idle_, idle++, stats);
+            }
+            if (stats.iterations_ % STATS_INTERVAL == 0) [[unlikely]] {
+                shard.stats_.store(stats);
+            }
+        }
+
+        // the producers may have pushed right before stop()
+        while (size_t handled = poll(shard)) {
+            stats.commands_ += handled;
+            stats.maxBatch_ = std::max<uint64_t>(stats.maxBatch_, handled);
+        }
+        shard.stats_.store(stats);
+    }
+
+    size_t poll(Shard &shard) {
+        size_t handled = 0;
+        for (auto &input : shard.inputs_) {
+            Book &book = *input->book_;
+            handled += input->queue_.consume_all(
+                [this, &book](const BookCommand &command) { execute(book, command); });
+        }
+        return handled;
+    }
+
+    void execute(Book &book, const BookCommand &command) {
+        Trades trades = executeCommand(book, command);
+        handler_(book, command, trades);
+    }
+
+    RunnerConfig config_;
+    Handler handler_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<bool> running_{false};
+    bool memoryLocked_{false};
+};
+
+#endif  // _ENGINE_RUNNER_HPP
@@ -0,0 +1,109 @@
+#ifndef _EVENT_LOG_HPP
+#define _EVENT_LOG_HPP
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "order_event.h"
+
+// A log of order events is a file of raw OrderEvent records, nothing else.
+// Both ends throw std::system_error on I/O errors.
+
+// appends records, buffered until flush() or destruction
+class EventLogWriter {
+   public:
+    static constexpr size_t BUFFER_EVENTS = 1024;
+
+    explicit EventLogWriter(const std::string &path)
+        : fd_{::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644)} {
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "open " + path);
+        }
+        buffer_.reserve(BUFFER_EVENTS);
+    }
+
+    ~EventLogWriter() {
+        try {
+            flush();
+        } catch (const std::system_error &) {
+            // nothing to report it to
+        }
+        ::close(fd_);
+    }
+
+    EventLogWriter(const EventLogWriter &) = delete;
+    EventLogWriter &operator=(const EventLogWriter &) = delete;
+
+    void append(const OrderEvent &event) {
+        buffer_.push_back(event);
+        if (buffer_.size() == BUFFER_EVENTS) [[unlikely]] {
+            flush();
+        }
+    }
+
+    void flush() {
+        const char *data = reinterpret_cast<const char *>(buffer_.data());
+        size_t left = buffer_.size() * sizeof(OrderEvent);
+        while (left > 0) {
+            ssize_t written = ::write(fd_, data, left);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                throw std::system_error(errno, std::generic_category(), "write");
+            }
+            data += written;
+            left -= written;
+        }
+        buffer_.clear();
+    }
+
+   private:
+    int fd_;
+    std::vector<OrderEvent> buffer_;
+};
+
+// reads records in the order they were appended
+class EventLogReader {
+   public:
+    explicit EventLogReader(const std::string &path)
+        : fd_{::open(path.c_str(), O_RDONLY | O_CLOEXEC)} {
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "open " + path);
+        }
+    }
+
+    ~EventLogReader() { ::close(fd_); }
+
+    EventLogReader(const EventLogReader &) = delete;
+    EventLogReader &operator=(const EventLogReader &) = delete;
+
+    // up to n records into out, 0 at the end of the log; a record cut short
+    // by a crash while appending is not returned
+    size_t read(OrderEvent *out, size_t n) {
+        char *data = reinterpret_cast<char *>(out);
+        size_t want = n * sizeof(OrderEvent);
+        size_t got = 0;
+        while (got < want) {
+            ssize_t bytes = ::read(fd_, data + got, want - got);
+            if (bytes < 0) {
+                if (errno == EINTR) continue;
+                throw std::system_error(errno, std::generic_category(), "read");
+            }
+            if (bytes == 0) {
+                break;
+            }
+            got += bytes;
+        }
+        return got / sizeof(OrderEvent);
+    }
+
+   private:
+    int fd_;
+};
+
+#endif  // _EVENT_LOG_HPP
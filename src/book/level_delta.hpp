@@ -0,0 +1,137 @@
+#ifndef _LEVEL_DELTA_HPP
+#define _LEVEL_DELTA_HPP
+
+#include <vector>
+
+#include "concurrency/spscqueue.hpp"
+#include "side.h"
+#include "usings.h"
+
+enum class LevelAction : uint8_t { New, Change, Delete };
+
+// fixed-size binary record of one price level change
+// quantity_ and count_ are the values after the change, 0 on Delete
+struct LevelDelta {
+    uint64_t sequence_;  // consecutive per stream, a gap means records were dropped
+    Price price_;
+    Quantity quantity_;
+    uint32_t count_;
+    Side side_;
+    LevelAction action_;
+};
+
+static_assert(sizeof(LevelDelta) == 32);
+static_assert(std::is_trivially_copyable_v<LevelDelta>);
+
+// single-producer single-consumer stream of level deltas
+// updates made inside a batch are coalesced per level and published on commit
+template <size_t Capacity = 65536>
+class LevelDeltaStream {
+   public:
+    LevelDeltaStream() {
+        batch_.reserve(64);
+        deltas_.reserve(64);
+    }
+
+    // batches nest, only the outermost commit publishes
+    void beginBatch() { batchDepth_++; }
+
+    void commitBatch() {
+        if (--batchDepth_ > 0) {
+            return;
+        }
+
+        for (const auto& pending : batch_) {
+            LevelAction action;
+            if (pending.existedBefore_) {
+                action = pending.exists_ ? LevelAction::Change : LevelAction::Delete;
+            } else if (pending.exists_) {
+                action = LevelAction::New;
+            } else {
+                // created and removed within the batch
+                continue;
+            }
+            deltas_.push_back(LevelDelta{sequence_++, pending.price_, pending.quantity_,
+                                         pending.count_, pending.side_, action});
+        }
+        batch_.clear();
+
+        // the consumer sees the whole batch at once
+        size_t pushed = ring_.push_n(deltas_.begin(), deltas_.size());
+        if (pushed < deltas_.size()) [[unlikely]] {
+            dropped_.fetch_add(deltas_.size() - pushed, std::memory_order_relaxed);
+        }
+        deltas_.clear();
+    }
+
+    void onLevel(Side side, Price price, Quantity quantity, uint32_t count,
+                 LevelAction action) {
+        if (batchDepth_ == 0) {
+            publish(side, price, quantity, count, action);
+            return;
+        }
+
+        // a batch touches few levels, a linear scan beats hashing here
+        for (auto& pending : batch_) {
+            if (pending.price_ == price && pending.side_ == side) {
+                pending.quantity_ = quantity;
+                pending.count_ = count;
+                pending.exists_ = action != LevelAction::Delete;
+                return;
+            }
+        }
+        batch_.push_back(Pending{price, quantity, count, side,
+                                 action != LevelAction::New,
+                                 action != LevelAction::Delete});
+    }
+
+    // consumer side
+    bool pop(LevelDelta& delta) noexcept { return ring_.pop(delta); }
+    bool empty() const noexcept { return ring_.empty(); }
+
+    // records lost because the consumer fell behind
+    uint64_t getDroppedCount() const noexcept {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+   private:
+    struct Pending {
+        Price price_;
+        Quantity quantity_;
+        uint32_t count_;
+        Side side_;
+        bool existedBefore_;
+        bool exists_;
+    };
+
+    void publish(Side side, Price price, Quantity quantity, uint32_t count,
+                 LevelAction action) {
+        LevelDelta delta{sequence_++, price, quantity, count, side, action};
+        if (!ring_.emplace(delta)) [[unlikely]] {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    SPSCQueue<LevelDelta, Capacity> ring_;
+    std::vector<Pending> batch_;
+    std::vector<LevelDelta> deltas_;  // records of the batch being committed
+    uint32_t batchDepth_{0};
+    uint64_t sequence_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
+
+// scoped delta batch of a book, e.g. one command
+template <typename Book>
+class DeltaBatch {
+   public:
+    explicit DeltaBatch(Book& book) : book_(book) { book_.beginDeltaBatch(); }
+    ~DeltaBatch() { book_.endDeltaBatch(); }
+
+    DeltaBatch(const DeltaBatch&) = delete;
+    DeltaBatch& operator=(const DeltaBatch&) = delete;
+
+   private:
+    Book& book_;
+};
+
+#endif  // _LEVEL_DELTA_HPP
\ No newline at end of file
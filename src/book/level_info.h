@@ -6,6 +6,7 @@ struct L2LevelInfo {
     Price price_;
     Quantity quantity_;
     Volume volume_;
+    uint32_t count_{0};  // number of orders
 };
 
 template <typename LevelContainer>
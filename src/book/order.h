@@ -75,5 +75,8 @@ struct Order {
 };
 
 using OrderPool = ObjectPool<Order>;
+// owned by one shard thread, orders of its books only
+using LocalOrderPool =
+    ObjectPool<Order, (1 << 12), PoolMapDefault, DefaultPoolTracking, SingleOwnerMutex>;
 
 #endif  // _ORDER_H
\ No newline at end of file
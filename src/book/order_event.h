@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+#include "book_command.h"
+#include "order.h"
+#include "order_modify.h"
+
+// Fixed-layout binary record of one command accepted by a book, as logged
+// for replay. Strings are inline and zero padded, no field points anywhere,
+// so records can be written and read back as raw bytes.
+struct OrderEvent {
+    static constexpr size_t SYMBOL_SIZE = 16;
+    static constexpr size_t ORDER_ID_SIZE = 32;
+
+    static OrderEvent add(std::string_view symbol, const Order &order) {
+        OrderEvent event{CommandType::Add, symbol, order.getOrderId()};
+        event.side_ = order.getSide();
+        event.orderType_ = static_cast<uint8_t>(order.getOrderType());
+        event.price_ = order.getPrice();
+        event.quantity_ = order.getInitialQuantity();
+        return event;
+    }
+
+    static OrderEvent cancel(std::string_view symbol, std::string_view orderId) {
+        return OrderEvent{CommandType::Cancel, symbol, orderId};
+    }
+
+    static OrderEvent modify(std::string_view symbol, std::string_view orderId,
+                             const OrderModify &modify) {
+        OrderEvent event{CommandType::Modify, symbol, orderId};
+        event.side_ = modify.getSide();
+        event.price_ = modify.getPrice();
+        event.quantity_ = modify.getQuantity();
+        return event;
+    }
+
+    OrderEvent() = default;
+
+    std::string_view symbol() const { return {symbol_, strnlen(symbol_, SYMBOL_SIZE)}; }
+    std::string_view orderId() const { return {orderId_, strnlen(orderId_, ORDER_ID_SIZE)}; }
+    OrderType orderType() const { return static_cast<OrderType>(orderType_); }
+    OrderModify getModify() const { return OrderModify{side_, price_, quantity_}; }
+
+    // FNV-1a of the fields before checksum_, the padding left out
+    uint32_t computeChecksum() const {
+        const auto *bytes = reinterpret_cast<const unsigned char *>(this);
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < offsetof(OrderEvent, orderType_) + sizeof(orderType_); i++) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+        return hash;
+    }
+
+    // a zeroed or torn record is not
+    bool intact() const { return checksum_ == computeChecksum(); }
+
+    uint64_t sequence_{0};  // of the book, set by whoever logs the event
+    Price price_{0};
+    Quantity quantity_{0};
+    char symbol_[SYMBOL_SIZE]{};  // longer ones are cut
+    char orderId_[ORDER_ID_SIZE]{};
+    CommandType type_{CommandType::Add};
+    Side side_{Side::Buy};
+    uint8_t orderType_{0};
+    uint32_t checksum_{0};  // set by whoever journals the event, see intact()
+
+   private:
+    OrderEvent(CommandType type, std::string_view symbol, std::string_view orderId)
+        : type_{type} {
+        std::memcpy(symbol_, symbol.data(), std::min(symbol.size(), SYMBOL_SIZE));
+        std::memcpy(orderId_, orderId.data(), std::min(orderId.size(), ORDER_ID_SIZE));
+    }
+};
+
+static_assert(sizeof(OrderEvent) == 80);
+static_assert(std::is_trivially_copyable_v<OrderEvent>);
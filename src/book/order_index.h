@@ -0,0 +1,13 @@
+#pragma once
+
+#include <functional>
+#include <unordered_map>
+
+#include "book_memory.hpp"
+#include "usings.h"
+
+// order id -> position of the order in its level container
+template <typename Iterator, typename Allocator = DefaultBookAllocator>
+using OrderIndex =
+    std::unordered_map<OrderId, Iterator, std::hash<OrderId>, std::equal_to<OrderId>,
+                       BookRebind<Allocator, std::pair<const OrderId, Iterator>>>;
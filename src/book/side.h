@@ -1,3 +1,5 @@
 #pragma once
 
-enum class Side { Buy, Sell };
\ No newline at end of file
+#include <cstdint>
+
+enum class Side : uint8_t { Buy, Sell };
\ No newline at end of file
@@ -0,0 +1,246 @@
+#ifndef _STEALING_ENGINE_HPP
+#define _STEALING_ENGINE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "book_command.h"
+#include "concurrency/mpmcqueue.hpp"
+#include "concurrency/seqlock.hpp"
+#include "concurrency/spscqueue.hpp"
+#include "concurrency/workstealingqueue.hpp"
+#include "engine_runner.hpp"
+
+// counters of one worker, see RunnerStats
+struct StealingStats : RunnerStats {
+    uint64_t runs_{0};    // books taken and run
+    uint64_t steals_{0};  // of them taken from another worker
+};
+
+// Matching threads sharing the books by work stealing.
+//
+// Unlike with EngineRunner no book is tied to a thread. A book is a serial
+// task queue: its input SPSCQueue and a scheduled flag. A command pushed to an
+// idle book schedules it on a shared injection queue, a worker takes it,
+// handles up to BOOK_BUDGET commands and queues it again at the tail of its
+// own run queue if more are waiting. Workers finding nothing to run steal
+// whole books from the head of the others' run queues, so while a few hot
+// books keep their workers busy, the rest go to whoever is free.
+//
+// A scheduled book is in one queue or on one worker, never in two places, so
+// its commands are handled in order by one thread at a time; the queue
+// handing it over orders what the threads do to it. Handler is called like
+// for EngineRunner, by any worker; a book whose handler still has deferred
+// work once its commands ran out stays scheduled until idle(book) finished.
+template <typename Book, typename Handler = IgnoreResults, size_t QueueCapacity = 4096,
+          size_t MAX_BOOKS = 1024>
+class StealingEngine {
+   public:
+    using InputQueue = SPSCQueue<BookCommand, QueueCapacity>;
+
+    static constexpr uint64_t STATS_INTERVAL = 1024;
+    // commands of a book handled before the worker moves on to the next
+    static constexpr size_t BOOK_BUDGET = 64;
+    // a worker with books of its own still looks at the injection queue
+    // every INJECT_INTERVAL runs, books scheduled meanwhile do not starve
+    static constexpr uint64_t INJECT_INTERVAL = 32;
+
+    // the producer end of a book, used by one producer thread
+    class BookQueue {
+       public:
+        BookQueue(const BookQueue &) = delete;
+        BookQueue &operator=(const BookQueue &) = delete;
+
+        // false if the book's queue is full
+        bool push(const BookCommand &command) {
+            if (!queue_.emplace(command)) {
+                return false;
+            }
+            // pairs with the fence of the worker leaving the book idle:
+            // either it sees the command or this sees the book idle
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!scheduled_.load(std::memory_order_relaxed) &&
+                !scheduled_.exchange(true, std::memory_order_acq_rel)) {
+                engine_.injected_.emplace(this);
+            }
+            return true;
+        }
+
+        size_t size() const noexcept { return queue_.size(); }
+
+       private:
+        friend class StealingEngine;
+
+        BookQueue(StealingEngine &engine, Book &book) : engine_{engine}, book_{book} {}
+
+        StealingEngine &engine_;
+        Book &book_;
+        InputQueue queue_;
+        std::atomic<bool> scheduled_{false};
+    };
+
+    // one worker per entry of config.cores_
+    explicit StealingEngine(RunnerConfig config, Handler handler = Handler{})
+        : config_{std::move(config)}, handler_{std::move(handler)} {
+        workers_.reserve(config_.cores_.size());
+        for (size_t i = 0; i < config_.cores_.size(); i++) {
+            workers_.push_back(std::make_unique<Worker>());
+        }
+    }
+
+    ~StealingEngine() { stop(); }
+
+    StealingEngine(const StealingEngine &) = delete;
+    StealingEngine &operator=(const StealingEngine &) = delete;
+
+    // push the commands of book to the queue returned; only before start(),
+    // throws std::logic_error otherwise, std::length_error past MAX_BOOKS
+    BookQueue &attach(Book &book) {
+        if (running_.load(std::memory_order_relaxed)) {
+            throw std::logic_error("books are attached before the engine starts");
+        }
+        if (books_.size() == MAX_BOOKS) {
+            throw std::length_error("too many books");
+        }
+        books_.push_back(std::unique_ptr<BookQueue>(new BookQueue{*this, book}));
+        return *books_.back();
+    }
+
+    // starts the workers, returns once all of them are set up
+    void start() {
+        if (running_.exchange(true)) {
+            return;
+        }
+        if (config_.lockMemory_) {
+            memoryLocked_ = lockEngineMemory(config_);
+            for (auto &book : books_) {
+                memoryLocked_ &= lockEngineRange(config_, book->queue_.storage(),
+                                                 InputQueue::storage_bytes());
+            }
+        }
+
+        std::atomic<size_t> ready{0};
+        for (size_t i = 0; i < workers_.size(); i++) {
+            workers_[i]->thread_ = std::thread([this, i, &ready] {
+                workers_[i]->setup_ = prepareMatchingThread(config_, config_.cores_[i]);
+                ready.fetch_add(1, std::memory_order_release);
+                run(i);
+            });
+        }
+        while (ready.load(std::memory_order_acquire) < workers_.size()) {
+            std::this_thread::yield();
+        }
+    }
+
+    // commands queued before are still handled
+    void stop() {
+        if (!running_.exchange(false)) {
+            return;
+        }
+        for (auto &worker : workers_) {
+            worker->thread_.join();
+        }
+    }
+
+    bool running() const { return running_.load(std::memory_order_relaxed); }
+
+    size_t worker_count() const { return workers_.size(); }
+
+    StealingStats stats(size_t worker) const { return workers_.at(worker)->stats_.load(); }
+
+    // valid once start() returned
+    const ShardSetup &setup(size_t worker) const { return workers_.at(worker)->setup_; }
+
+    bool memoryLocked() const { return memoryLocked_; }
+
+   private:
+    struct Worker {
+        WorkStealingQueue<BookQueue *, MAX_BOOKS> runQueue_;
+        std::thread thread_;
+        ShardSetup setup_;
+        SeqLock<StealingStats> stats_;
+    };
+
+    void run(size_t index) {
+        Worker &worker = *workers_[index];
+        StealingStats stats;
+        uint32_t idle = 0;
+        BookQueue *book;
+        // pairs with stop(), the drain below sees the books scheduled before
+        while (running_.load(std::memory_order_acquire)) [[likely]] {
+            stats.iterations_++;
+            if (next(index, book, stats)) {
+                size_t handled = runBook(worker, *book);
+                stats.commands_ += handled;
+                stats.maxBatch_ = std::max<uint64_t>(stats.maxBatch_, handled);
+                idle = 0;
+            } else {
+                stats.idleIterations_++;
+                idleBackoff(config_.idle_, idle++, stats);
+            }
+            if (stats.iterations_ % STATS_INTERVAL == 0) [[unlikely]] {
+                worker.stats_.store(stats);
+            }
+        }
+
+        // the producers may have pushed right before stop(); a book queued
+        // again goes to this worker's run queue, drained here
+        while (next(index, book, stats)) {
+            size_t handled = runBook(worker, *book);
+            stats.commands_ += handled;
+            stats.maxBatch_ = std::max<uint64_t>(stats.maxBatch_, handled);
+        }
+        worker.stats_.store(stats);
+    }
+
+    // own run queue, injection queue, then the others' run queues
+    bool next(size_t index, BookQueue *&book, StealingStats &stats) {
+        Worker &worker = *workers_[index];
+        bool found = (stats.runs_ % INJECT_INTERVAL == INJECT_INTERVAL - 1 &&
+                      injected_.try_pop(book)) ||
+                     worker.runQueue_.pop(book) || injected_.try_pop(book);
+        for (size_t i = 1; !found && i < workers_.size(); i++) {
+            if (workers_[(index + i) % workers_.size()]->runQueue_.steal(book)) {
+                stats.steals_++;
+                found = true;
+            }
+        }
+        stats.runs_ += found;
+        return found;
+    }
+
+    size_t runBook(Worker &worker, BookQueue &book) {
+        size_t handled = book.queue_.consume_n(
+            BOOK_BUDGET, [this, &book](const BookCommand &command) {
+                Trades trades = executeCommand(book.book_, command);
+                handler_(book.book_, command, trades);
+            });
+
+        if (book.queue_.empty() && handlerIdle(handler_, book.book_)) {
+            book.scheduled_.store(false, std::memory_order_release);
+            // pairs with the fence of push()
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (book.queue_.empty() || book.scheduled_.exchange(true, std::memory_order_acq_rel)) {
+                return handled;
+            }
+        }
+        // never full, a book is queued once and at most MAX_BOOKS exist
+        worker.runQueue_.push(&book);
+        return handled;
+    }
+
+    RunnerConfig config_;
+    Handler handler_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::unique_ptr<BookQueue>> books_;
+    // books scheduled by their producers
+    MPMCQueue<BookQueue *, MAX_BOOKS> injected_;
+    std::atomic<bool> running_{false};
+    bool memoryLocked_{false};
+};
+
+#endif  // _STEALING_ENGINE_HPP
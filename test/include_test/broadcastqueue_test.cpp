@@ -0,0 +1,139 @@
+#include "concurrency/broadcastqueue.hpp"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST(BroadcastQueueTest, EveryConsumerSeesEverything) {
+    BroadcastQueue<int, 8, 4> queue;
+    auto first = queue.subscribe();
+    auto second = queue.subscribe();
+    EXPECT_EQ(queue.consumer_count(), 2);
+
+    for (int i = 0; i < 5; i++) {
+        EXPECT_TRUE(queue.try_publish(i));
+    }
+
+    int value;
+    for (int i = 0; i < 5; i++) {
+        EXPECT_TRUE(first.poll(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(first.poll(value));
+
+    std::vector<int> seen;
+    EXPECT_EQ(second.consume_all([&seen](const int &v) { seen.push_back(v); }), 5);
+    EXPECT_EQ(seen, (std::vector<int>{0, 1, 2, 3, 4}));
+    EXPECT_EQ(second.backlog(), 0);
+}
+
+TEST(BroadcastQueueTest, SlowestConsumerGates) {
+    BroadcastQueue<int, 4, 4> queue;
+    auto fast = queue.subscribe();
+    auto slow = queue.subscribe();
+
+    int values[] = {0, 1, 2, 3, 4, 5};
+    EXPECT_EQ(queue.publish_n(values, 6), 4);
+    EXPECT_FALSE(queue.try_publish(4));
+
+    int value;
+    EXPECT_EQ(fast.consume_all([](const int &) {}), 4);
+    // still full for the slow one
+    EXPECT_FALSE(queue.try_publish(4));
+
+    EXPECT_TRUE(slow.poll(value));
+    EXPECT_EQ(value, 0);
+    EXPECT_TRUE(queue.try_publish(4));
+    EXPECT_FALSE(queue.try_publish(5));
+    EXPECT_EQ(slow.backlog(), 4);
+}
+
+TEST(BroadcastQueueTest, UnsubscribeReleasesGating) {
+    BroadcastQueue<int, 4, 2> queue;
+    auto consumer = queue.subscribe();
+    {
+        auto stalled = queue.subscribe();
+        EXPECT_THROW(queue.subscribe(), std::length_error);
+        for (int i = 0; i < 4; i++) {
+            EXPECT_TRUE(queue.try_publish(i));
+        }
+        EXPECT_EQ(consumer.consume_all([](const int &) {}), 4);
+        EXPECT_FALSE(queue.try_publish(4));
+    }
+    EXPECT_EQ(queue.consumer_count(), 1);
+    EXPECT_TRUE(queue.try_publish(4));
+
+    // the entry is free again, moved-from consumers do not release it
+    auto again = queue.subscribe();
+    auto moved = std::move(again);
+    EXPECT_EQ(queue.consumer_count(), 2);
+    int value;
+    EXPECT_FALSE(moved.poll(value));
+}
+
+TEST(BroadcastQueueTest, Lapping) {
+    BroadcastQueue<int, 4, 2, BroadcastMode::Lapping> queue;
+    auto consumer = queue.subscribe();
+
+    // the producer never waits
+    for (int i = 0; i < 10; i++) {
+        EXPECT_TRUE(queue.try_publish(i));
+    }
+    EXPECT_EQ(queue.published(), 10);
+
+    // resumes at the oldest element one slot away from the producer
+    std::vector<int> seen;
+    EXPECT_EQ(consumer.consume_all([&seen](const int &v) { seen.push_back(v); }), 3);
+    EXPECT_EQ(seen, (std::vector<int>{7, 8, 9}));
+    EXPECT_EQ(consumer.lapped(), 7);
+
+    queue.publish(10);
+    int value;
+    EXPECT_TRUE(consumer.poll(value));
+    EXPECT_EQ(value, 10);
+    EXPECT_EQ(consumer.lapped(), 7);
+}
+
+TEST(BroadcastQueueTest, Concurrent) {
+    constexpr int COUNT = 20000;
+    constexpr int CONSUMERS = 3;
+    BroadcastQueue<int, 64, 4> queue;
+
+    std::vector<BroadcastQueue<int, 64, 4>::Consumer> consumers;
+    for (int i = 0; i < CONSUMERS; i++) {
+        consumers.push_back(queue.subscribe());
+    }
+
+    std::vector<long> sums(CONSUMERS, 0);
+    std::vector<char> ordered(CONSUMERS, true);
+    std::vector<std::thread> threads;
+    for (int c = 0; c < CONSUMERS; c++) {
+        threads.emplace_back([&, c] {
+            int expected = 0;
+            while (expected < COUNT) {
+                if (consumers[c].consume_all([&](const int &value) {
+                        ordered[c] = ordered[c] && value == expected++;
+                        sums[c] += value;
+                    }) == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for (int i = 0; i < COUNT; i++) {
+        while (!queue.try_publish(i)) {
+            std::this_thread::yield();
+        }
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    for (int c = 0; c < CONSUMERS; c++) {
+        EXPECT_TRUE(ordered[c]);
+        EXPECT_EQ(sums[c], long{COUNT} * (COUNT - 1) / 2);
+    }
+}
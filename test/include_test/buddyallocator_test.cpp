@@ -0,0 +1,106 @@
+#include "util/buddyallocator.hpp"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "util/slaballocator.hpp"
+
+// 16 pages of 4KB
+using SmallBuddy = BuddyAllocator<12, 16>;
+
+TEST(BuddyAllocatorTest, SplitAndMerge) {
+    auto &buddy = SmallBuddy::GetInst();
+    ASSERT_EQ(buddy.free_bytes(), SmallBuddy::REGION_SIZE);
+
+    // rounded up to a page, then to a power of 2
+    void *a = buddy.allocate(100);
+    void *b = buddy.allocate(3 * 4096);
+    void *c = buddy.allocate(4096);
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+    ASSERT_NE(c, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % (4 * 4096), 0);
+    EXPECT_EQ(buddy.free_bytes(), SmallBuddy::REGION_SIZE - 6 * 4096);
+    EXPECT_TRUE(buddy.owns(a));
+    EXPECT_TRUE(buddy.owns(b));
+
+    // a and c are buddies of the first split
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(a) ^ reinterpret_cast<uintptr_t>(c), 4096);
+
+    buddy.deallocate(a, 100);
+    buddy.deallocate(c, 4096);
+    buddy.deallocate(b, 3 * 4096);
+    EXPECT_EQ(buddy.free_bytes(), SmallBuddy::REGION_SIZE);
+
+    // everything merged back into one block
+    void *all = buddy.allocate(SmallBuddy::REGION_SIZE);
+    ASSERT_NE(all, nullptr);
+    buddy.deallocate(all, SmallBuddy::REGION_SIZE);
+}
+
+TEST(BuddyAllocatorTest, Exhaustion) {
+    auto &buddy = SmallBuddy::GetInst();
+
+    std::vector<void *> pages;
+    for (int i = 0; i < 16; i++) {
+        void *page = buddy.allocate(4096);
+        ASSERT_NE(page, nullptr);
+        pages.push_back(page);
+    }
+    EXPECT_EQ(buddy.allocate(4096), nullptr);
+    EXPECT_EQ(buddy.allocate(SmallBuddy::REGION_SIZE * 2), nullptr);
+
+    // freed in an order where merges cascade late
+    for (int i = 0; i < 16; i += 2) {
+        buddy.deallocate(pages[i], 4096);
+    }
+    EXPECT_EQ(buddy.allocate(2 * 4096), nullptr);
+    for (int i = 1; i < 16; i += 2) {
+        buddy.deallocate(pages[i], 4096);
+    }
+    EXPECT_EQ(buddy.free_bytes(), SmallBuddy::REGION_SIZE);
+    void *all = buddy.allocate(SmallBuddy::REGION_SIZE);
+    EXPECT_NE(all, nullptr);
+    buddy.deallocate(all, SmallBuddy::REGION_SIZE);
+}
+
+TEST(BuddyAllocatorTest, SharedBySlabs) {
+    struct Small {
+        int64_t data;
+    };
+    struct Large {
+        char data[1000];
+    };
+
+    using Buddy = BuddyAllocator<12, 24>;
+    using PageAllocator = BuddyPageAllocator<12, 24>;
+    auto &small = SlabAllocator<Small, 64, FullTracking, PageAllocator>::GetInst();
+    auto &large = SlabAllocator<Large, 64, FullTracking, PageAllocator>::GetInst();
+    auto &buddy = Buddy::GetInst();
+
+    std::vector<Small *> smalls;
+    std::vector<Large *> larges;
+    for (int i = 0; i < 1000; i++) {
+        smalls.push_back(small.allocate());
+        larges.push_back(large.allocate());
+        ASSERT_TRUE(buddy.owns(smalls.back()));
+        ASSERT_TRUE(buddy.owns(larges.back()));
+    }
+    size_t used = Buddy::REGION_SIZE - buddy.free_bytes();
+
+    for (int i = 0; i < 1000; i++) {
+        small.deallocate(smalls[i]);
+        large.deallocate(larges[i]);
+    }
+    // free slabs keep their pages, nothing new is taken on reuse
+    for (int i = 0; i < 1000; i++) {
+        smalls[i] = small.allocate();
+        larges[i] = large.allocate();
+    }
+    EXPECT_EQ(Buddy::REGION_SIZE - buddy.free_bytes(), used);
+    for (int i = 0; i < 1000; i++) {
+        small.deallocate(smalls[i]);
+        large.deallocate(larges[i]);
+    }
+}
@@ -0,0 +1,155 @@
+#include "concurrency/epoch.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory_resource>
+#include <stdexcept>
+#include <vector>
+
+#include "util/objectpool.hpp"
+
+namespace {
+
+struct Node {
+    int value_{0};
+};
+
+using NodePool = ObjectPool<Node, 64, PoolMapDefault, DefaultPoolTracking, NullMutex>;
+
+// counts what reaches the upstream
+class CountingResource : public std::pmr::memory_resource {
+   public:
+    size_t live_{0};
+
+   private:
+    void *do_allocate(size_t bytes, size_t alignment) override {
+        live_++;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+        live_--;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+};
+
+}  // namespace
+
+TEST(EpochTest, RetiredWaitsForReaders) {
+    NodePool pool;
+    EpochDomain domain;
+    auto reader = domain.registerReader();
+    size_t available = pool.size();
+
+    Node *node = pool.allocate(1);
+    {
+        EpochDomain::Guard guard{reader};
+        {
+            EpochDomain::WriteScope write{&domain};
+            domain.retire(pool, node);
+        }
+        // the reader may still hold it
+        EXPECT_EQ(domain.reclaim(), 0);
+        EXPECT_EQ(domain.retired_count(), 1);
+        EXPECT_EQ(pool.size(), available - 1);
+    }
+    EXPECT_EQ(domain.reclaim(), 1);
+    EXPECT_EQ(pool.size(), available);
+
+    // a reader entering after the retirement does not hold it back
+    node = pool.allocate(2);
+    {
+        EpochDomain::WriteScope write{&domain};
+        domain.retire(pool, node);
+    }
+    EpochDomain::Guard guard{reader};
+    EXPECT_EQ(domain.reclaim(), 1);
+}
+
+TEST(EpochTest, Validate) {
+    EpochDomain domain;
+    auto reader = domain.registerReader();
+
+    {
+        EpochDomain::Guard guard{reader};
+        EXPECT_TRUE(guard.validate());
+        // nested scopes are one modification
+        EpochDomain::WriteScope outer{&domain};
+        EXPECT_FALSE(guard.validate());
+        {
+            EpochDomain::WriteScope inner{&domain};
+        }
+        EXPECT_EQ(domain.epoch() % 2, 1);
+    }
+    EXPECT_EQ(domain.epoch(), 2);
+
+    {
+        EpochDomain::WriteScope write{&domain};
+        // entered while the writer is inside
+        EpochDomain::Guard guard{reader};
+        EXPECT_FALSE(guard.validate());
+    }
+    EpochDomain::Guard guard{reader};
+    EXPECT_TRUE(guard.validate());
+
+    // no domain, no epoch
+    EpochDomain::WriteScope detached{nullptr};
+}
+
+TEST(EpochTest, ReclaimThreshold) {
+    NodePool pool;
+    EpochDomain domain{4};
+    for (int i = 0; i < 3; i++) {
+        EpochDomain::WriteScope write{&domain};
+        domain.retire(pool, pool.allocate(i));
+    }
+    EXPECT_EQ(domain.retired_count(), 3);
+    {
+        EpochDomain::WriteScope write{&domain};
+        domain.retire(pool, pool.allocate(3));
+    }
+    // ending the scope reclaimed everything
+    EXPECT_EQ(domain.retired_count(), 0);
+}
+
+TEST(EpochTest, ReaderLimit) {
+    EpochDomain domain;
+    std::vector<EpochDomain::Reader> readers;
+    for (size_t i = 0; i < EpochDomain::MAX_READERS; i++) {
+        readers.push_back(domain.registerReader());
+    }
+    EXPECT_THROW(domain.registerReader(), std::length_error);
+    readers.pop_back();
+    EXPECT_NO_THROW(domain.registerReader());
+}
+
+TEST(EpochTest, Resource) {
+    CountingResource upstream;
+    EpochDomain domain;
+    auto reader = domain.registerReader();
+    {
+        EpochResource resource{domain, &upstream};
+        std::pmr::vector<int> values{&resource};
+        values.reserve(4);
+        EXPECT_EQ(upstream.live_, 1);
+
+        {
+            EpochDomain::Guard guard{reader};
+            EpochDomain::WriteScope write{&domain};
+            // the old buffer is retired, not freed
+            values.reserve(64);
+            EXPECT_EQ(upstream.live_, 2);
+            EXPECT_EQ(domain.reclaim(), 0);
+        }
+        EXPECT_EQ(domain.reclaim(), 1);
+        EXPECT_EQ(upstream.live_, 1);
+
+        values = std::pmr::vector<int>{&resource};
+        EXPECT_EQ(domain.retired_count(), 1);
+    }
+    // the resource drained the domain
+    EXPECT_EQ(domain.retired_count(), 0);
+    EXPECT_EQ(upstream.live_, 0);
+}
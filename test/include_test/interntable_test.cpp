@@ -0,0 +1,117 @@
+#include "util/interntable.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+TEST(InternTableTest, Basic) {
+    InternTable table{16};
+    EXPECT_EQ(table.find("AAPL"), InternTable::InvalidHandle);
+
+    auto aapl = table.intern("AAPL");
+    auto msft = table.intern(std::string{"MSFT"});
+    EXPECT_EQ(aapl, 0);
+    EXPECT_EQ(msft, 1);
+    EXPECT_EQ(table.intern("AAPL"), aapl);
+    EXPECT_EQ(table.find("MSFT"), msft);
+    EXPECT_EQ(table.str(aapl), "AAPL");
+    EXPECT_EQ(table.str(msft), "MSFT");
+    EXPECT_EQ(table.size(), 2);
+
+    // longer than the small string buffer
+    std::string longName(100, 'x');
+    EXPECT_EQ(table.str(table.intern(longName)), longName);
+    EXPECT_EQ(table.intern(""), 3);
+    EXPECT_EQ(table.find(""), 3);
+}
+
+TEST(InternTableTest, Full) {
+    InternTable table{4};
+    for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(table.intern(std::to_string(i)), i);
+    }
+    EXPECT_THROW(table.intern("4"), std::length_error);
+    // existing strings are still found
+    EXPECT_EQ(table.intern("3"), 3);
+    EXPECT_EQ(table.size(), 4);
+}
+
+TEST(InternTableTest, Concurrent) {
+    static constexpr int THREADS = 4;
+    static constexpr int COUNT = 10000;
+
+    InternTable table{COUNT};
+    std::vector<std::vector<InternTable::Handle>> handles(THREADS);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++) {
+        threads.emplace_back([&table, &handles, t] {
+            // every thread interns the same strings in a different order
+            for (int i = 0; i < COUNT; i++) {
+                int n = (i * (t + 1) * 7919) % COUNT;
+                handles[t].push_back(table.intern("SYM" + std::to_string(n)));
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(table.size(), COUNT);
+    // all threads got the same handle for a string
+    std::unordered_set<InternTable::Handle> distinct;
+    for (int t = 0; t < THREADS; t++) {
+        for (int i = 0; i < COUNT; i++) {
+            int n = (i * (t + 1) * 7919) % COUNT;
+            ASSERT_EQ(table.str(handles[t][i]), "SYM" + std::to_string(n));
+            ASSERT_EQ(handles[t][i], table.find("SYM" + std::to_string(n)));
+            distinct.insert(handles[t][i]);
+        }
+    }
+    EXPECT_EQ(distinct.size(), COUNT);
+}
+
+TEST(SymbolTest, Basic) {
+    Symbol ibm{"IBM"};
+    Symbol ibm2{std::string{"IBM"}};
+    Symbol amzn{"AMZN"};
+    static_assert(sizeof(Symbol) == 4);
+
+    EXPECT_EQ(ibm, ibm2);
+    EXPECT_NE(ibm, amzn);
+    EXPECT_EQ(ibm.str(), "IBM");
+    EXPECT_EQ(std::hash<Symbol>{}(ibm), std::hash<Symbol>{}(ibm2));
+
+    // ordered by the strings
+    EXPECT_LT(amzn, ibm);
+    std::map<Symbol, int> bySymbol{{ibm, 1}, {amzn, 2}};
+    EXPECT_EQ(bySymbol.begin()->first.str(), "AMZN");
+
+    EXPECT_FALSE(Symbol::find("NOT INTERNED").valid());
+    EXPECT_EQ(Symbol::find("IBM"), ibm);
+    EXPECT_FALSE(Symbol{}.valid());
+}
+
+TEST(SymbolTest, Invalid) {
+    Symbol invalid;
+    Symbol empty{""};
+    Symbol ibm{"IBM"};
+
+    EXPECT_EQ(invalid.str(), "");
+    std::ostringstream out;
+    out << invalid;
+    EXPECT_EQ(out.str(), "");
+
+    // before every valid symbol, the empty string included
+    EXPECT_EQ(invalid, Symbol{});
+    EXPECT_LT(invalid, ibm);
+    EXPECT_LT(invalid, empty);
+    EXPECT_GT(empty, invalid);
+    EXPECT_NE(invalid, empty);
+    std::map<Symbol, int> bySymbol{{ibm, 1}, {invalid, 2}, {empty, 3}};
+    EXPECT_EQ(bySymbol.begin()->second, 2);
+}
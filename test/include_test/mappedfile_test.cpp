@@ -0,0 +1,59 @@
+#include "util/mappedfile.h"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string tempPath(const char *name) {
+    return "/tmp/" + std::string{name} + "_" + std::to_string(getpid());
+}
+
+std::vector<char> readFile(const std::string &path) {
+    std::ifstream in{path, std::ios::binary};
+    return {std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+}
+
+}  // namespace
+
+TEST(MappedAppendFileTest, AppendsAcrossWindows) {
+    std::string path = tempPath("mappedfile_test");
+    std::vector<char> expected;
+    {
+        // a one page window, records straddle the windows
+        MappedAppendFile file{path, 0, 1};
+        for (int i = 0; i < 1000; i++) {
+            char record[24];
+            std::snprintf(record, sizeof(record), "record %015d", i);
+            file.append(record, sizeof(record));
+            expected.insert(expected.end(), record, record + sizeof(record));
+        }
+        EXPECT_EQ(file.size(), expected.size());
+        file.sync();
+        EXPECT_EQ(file.synced(), expected.size());
+        // allocated a window ahead
+        EXPECT_GT(std::filesystem::file_size(path), expected.size());
+    }
+    // cut to what was appended
+    EXPECT_EQ(readFile(path), expected);
+
+    {
+        // appends after the first 240 bytes, the rest is dropped
+        MappedAppendFile file{path, 240};
+        file.append("tail", 4);
+    }
+    std::vector<char> contents = readFile(path);
+    ASSERT_EQ(contents.size(), 244);
+    EXPECT_TRUE(std::equal(contents.begin(), contents.begin() + 240, expected.begin()));
+    EXPECT_EQ(std::string(contents.begin() + 240, contents.end()), "tail");
+    std::remove(path.c_str());
+
+    EXPECT_THROW(MappedAppendFile("/nonexistent/dir/file", 0), std::system_error);
+}
@@ -0,0 +1,107 @@
+#include "concurrency/mpmcqueue.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+template <typename T>
+class MPMCQueueTest : public ::testing::Test {};
+
+using WaitStrategies = ::testing::Types<BusySpinWait, SpinYieldWait<>, FutexWait<>>;
+TYPED_TEST_SUITE(MPMCQueueTest, WaitStrategies);
+
+TYPED_TEST(MPMCQueueTest, TryOperations) {
+    MPMCQueue<int, 4, TypeParam> queue;
+    int value;
+    EXPECT_FALSE(queue.try_pop(value));
+
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.try_emplace(i));
+    }
+    // full, the producer gets backpressure instead of spinning
+    EXPECT_FALSE(queue.try_emplace(4));
+    EXPECT_EQ(queue.size(), 4);
+
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.try_pop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(queue.try_pop(value));
+    EXPECT_TRUE(queue.empty());
+
+    // next turn of the slots
+    queue.emplace(5);
+    queue.pop(value);
+    EXPECT_EQ(value, 5);
+}
+
+TYPED_TEST(MPMCQueueTest, Concurrent) {
+    static constexpr int PRODUCERS = 2;
+    static constexpr int CONSUMERS = 2;
+    static constexpr int64_t COUNT = 2000;
+
+    MPMCQueue<int64_t, 64, TypeParam> queue;
+    std::atomic<int64_t> sum{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < PRODUCERS; p++) {
+        threads.emplace_back([&queue, p] {
+            for (int64_t i = 1; i <= COUNT; i++) {
+                // every other element through the non-blocking call
+                if (i % 2 == 0 || !queue.try_emplace(i)) {
+                    queue.emplace(i);
+                }
+            }
+        });
+    }
+    for (int c = 0; c < CONSUMERS; c++) {
+        threads.emplace_back([&queue, &sum] {
+            int64_t local = 0;
+            for (int64_t i = 0; i < COUNT * PRODUCERS / CONSUMERS; i++) {
+                int64_t value;
+                queue.pop(value);
+                local += value;
+            }
+            sum += local;
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(sum.load(), PRODUCERS * COUNT * (COUNT + 1) / 2);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(MPMCQueueFutexTest, IdleConsumerSleeps) {
+    MPMCQueue<int, 16, FutexWait<16>> queue;
+
+    int value = 0;
+    std::thread consumer([&queue, &value] { queue.pop(value); });
+
+    // the consumer parks in the kernel
+    while (queue.wait_strategy().sleepers() == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    queue.emplace(42);
+    consumer.join();
+    EXPECT_EQ(value, 42);
+    EXPECT_EQ(queue.wait_strategy().sleepers(), 0);
+}
+
+TEST(MPMCQueueFutexTest, Destruction) {
+    auto counter = std::make_shared<int>(0);
+    {
+        MPMCQueue<std::shared_ptr<int>, 4, FutexWait<>> queue;
+        queue.emplace(counter);
+        queue.emplace(counter);
+        std::shared_ptr<int> out;
+        queue.pop(out);
+        EXPECT_EQ(counter.use_count(), 3);
+    }
+    // the element left in the queue is destroyed
+    EXPECT_EQ(counter.use_count(), 1);
+}
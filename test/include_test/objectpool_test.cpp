@@ -3,6 +3,7 @@
 #include <gtest/gtest.h>
 
 #include <iostream>
+#include <thread>
 
 static int createCount;
 static int destroyCount;
@@ -60,20 +61,16 @@ TEST(ObjectPoolTest, Mixed) {
         objs.push_back(p1);
     }
 
+    // grows by one chunk instead of falling back to new
     for (int i = INITIAL_SIZE; i < INITIAL_SIZE * 2; i++) {
         auto p1 = pool.allocate(i);
-        EXPECT_EQ(pool.size(), 0);
+        EXPECT_EQ(pool.size(), INITIAL_SIZE * 2 - i - 1);
         EXPECT_EQ(p1->getData(), i);
         objs.push_back(p1);
     }
+    EXPECT_EQ(pool.chunk_count(), 2);
 
-    for (int i = 0; i < INITIAL_SIZE; i++) {
-        pool.deallocate(objs.back());
-        objs.pop_back();
-        EXPECT_EQ(pool.size(), 0);
-    }
-
-    for (int i = 0; i < INITIAL_SIZE; i++) {
+    for (size_t i = 0; i < INITIAL_SIZE * 2; i++) {
         pool.deallocate(objs.back());
         objs.pop_back();
         EXPECT_EQ(pool.size(), i + 1);
@@ -81,4 +78,115 @@ TEST(ObjectPoolTest, Mixed) {
 
     EXPECT_EQ(createCount, INITIAL_SIZE * 2);
     EXPECT_EQ(destroyCount, INITIAL_SIZE * 2);
-};
\ No newline at end of file
+};
+TEST(ObjectPoolTest, Growth) {
+    createCount = 0;
+    destroyCount = 0;
+
+    static constexpr size_t BLOCK_SIZE = 1000;
+    static constexpr size_t COUNT = 100000;
+    using Pool = ObjectPool<TestObject, BLOCK_SIZE, PoolMapTransparentHuge | PoolMapPopulate>;
+    auto &pool = Pool::GetInst();
+
+    // huge pages, a chunk fills its 2MB region
+    static constexpr size_t SLOTS = Pool::CHUNK_SLOTS;
+    static constexpr size_t CHUNKS = (COUNT + SLOTS - 1) / SLOTS;
+    EXPECT_GT(SLOTS, BLOCK_SIZE);
+    EXPECT_EQ(pool.size(), SLOTS);
+
+    std::vector<TestObject *> objs;
+    for (size_t i = 0; i < COUNT; i++) {
+        objs.push_back(pool.allocate(static_cast<int>(i)));
+    }
+    EXPECT_EQ(pool.chunk_count(), CHUNKS);
+    EXPECT_EQ(pool.size(), CHUNKS * SLOTS - COUNT);
+    for (size_t i = 0; i < COUNT; i++) {
+        ASSERT_EQ(objs[i]->getData(), static_cast<int>(i));
+    }
+
+    for (auto obj : objs) {
+        pool.deallocate(obj);
+    }
+    EXPECT_EQ(pool.size(), CHUNKS * SLOTS);
+
+    // freed slots are reused before growing again
+    objs.clear();
+    for (size_t i = 0; i < COUNT; i++) {
+        objs.push_back(pool.allocate(static_cast<int>(i)));
+    }
+    EXPECT_EQ(pool.chunk_count(), CHUNKS);
+    for (auto obj : objs) {
+        pool.deallocate(obj);
+    }
+
+    EXPECT_EQ(createCount, COUNT * 2);
+    EXPECT_EQ(destroyCount, COUNT * 2);
+}
+
+#ifndef NDEBUG
+// checked builds look the pointer up before touching the header in front of it
+TEST(ObjectPoolTest, ForeignPointer) {
+    using HeaderPool = ObjectPool<TestObject, 32, PoolMapDefault, HeaderTracking>;
+    HeaderPool pool;
+    TestObject *inside = pool.allocate(1);
+    EXPECT_EQ(pool.size(), 31);
+
+    TestObject outside;
+    EXPECT_TRUE(pool.owns(inside));
+    EXPECT_FALSE(pool.owns(&outside));
+    pool.deallocate(&outside);
+    EXPECT_EQ(pool.size(), 31);
+
+    pool.deallocate(inside);
+    EXPECT_EQ(pool.size(), 32);
+}
+#endif
+
+TEST(ObjectPoolTest, OwnedInstances) {
+    createCount = 0;
+    destroyCount = 0;
+
+    using OwnedPool = ObjectPool<TestObject, 32, PoolMapDefault, DefaultPoolTracking,
+                                 SingleOwnerMutex>;
+    PageProvider provider;
+    {
+        OwnedPool pool1{provider};
+        OwnedPool pool2{provider};
+        EXPECT_NE(&pool1, &OwnedPool::GetInst());
+        EXPECT_EQ(&pool1.provider(), &provider);
+        EXPECT_EQ(provider.mapped_bytes(), 2 * pool1.chunk_count() * (size_t{2} << 20));
+
+        // the instances share nothing
+        TestObject *a = pool1.allocate(1);
+        TestObject *b = pool2.allocate(2);
+        EXPECT_TRUE(pool1.owns(a));
+        EXPECT_FALSE(pool1.owns(b));
+        EXPECT_EQ(pool1.size(), 31);
+        EXPECT_EQ(pool2.size(), 31);
+        pool1.deallocate(a);
+        EXPECT_EQ(pool1.size(), 32);
+        EXPECT_EQ(pool2.size(), 31);
+
+        // threads owning a pool each
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([] {
+                OwnedPool pool;
+                std::vector<TestObject *> objs;
+                for (int i = 0; i < 100; i++) {
+                    objs.push_back(pool.allocate(i));
+                }
+                for (auto obj : objs) {
+                    pool.deallocate(obj);
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }
+    // b was not returned, destructed with pool2
+    EXPECT_EQ(provider.mapped_bytes(), 0);
+    EXPECT_EQ(createCount, 402);
+    EXPECT_EQ(destroyCount, 402);
+}
@@ -0,0 +1,183 @@
+#include "util/pageprovider.h"
+
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+// pages of a range in memory
+size_t residentPages(void *addr, size_t bytes) {
+    size_t page = sysconf(_SC_PAGESIZE);
+    std::vector<unsigned char> pages((bytes + page - 1) / page);
+    if (mincore(addr, bytes, pages.data()) != 0) {
+        return 0;
+    }
+    size_t resident = 0;
+    for (unsigned char p : pages) {
+        resident += p & 1;
+    }
+    return resident;
+}
+
+// two nodes, cpus split in halves, records the bindings instead of making them
+class FakeNumaTopology : public NumaTopology {
+   public:
+    struct Binding {
+        void *addr_;
+        size_t bytes_;
+        int node_;
+    };
+
+    int nodeCount() const override { return 2; }
+    int nodeOfCpu(int cpu) const override { return cpu < 4 ? 0 : 1; }
+
+    bool bindMemory(void *addr, size_t bytes, int node) override {
+        bindings_.push_back({addr, bytes, node});
+        return !refuse_;
+    }
+
+    bool preferNode(int node) override {
+        preferred_ = node;
+        return true;
+    }
+
+    std::vector<Binding> bindings_;
+    int preferred_{-1};
+    bool refuse_{false};
+};
+}  // namespace
+
+TEST(PageProviderTest, BindsToNode) {
+    FakeNumaTopology topology;
+    PageProvider provider{1, topology};
+
+    void *addr = provider.map(10000, size_t{1} << 16, PoolMapPopulate);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(addr) % (size_t{1} << 16), 0);
+    EXPECT_EQ(provider.mapped_bytes(), 12288);
+
+    ASSERT_EQ(topology.bindings_.size(), 1);
+    EXPECT_EQ(topology.bindings_[0].addr_, addr);
+    EXPECT_EQ(topology.bindings_[0].bytes_, 12288);
+    EXPECT_EQ(topology.bindings_[0].node_, 1);
+
+    // writable
+    static_cast<char *>(addr)[9999] = 1;
+    provider.unmap(addr, 10000);
+    EXPECT_EQ(provider.mapped_bytes(), 0);
+
+    EXPECT_TRUE(provider.bindThread());
+    EXPECT_EQ(topology.preferred_, 1);
+
+    // the pages are still mapped, on any node
+    EXPECT_EQ(provider.bind_failures(), 0);
+    topology.refuse_ = true;
+    addr = provider.map(4096);
+    static_cast<char *>(addr)[0] = 1;
+    EXPECT_EQ(provider.bind_failures(), 1);
+    provider.unmap(addr, 4096);
+}
+
+TEST(PageProviderTest, AnyNode) {
+    FakeNumaTopology topology;
+    PageProvider provider{PageProvider::AnyNode, topology};
+
+    void *addr = provider.map(4096);
+    EXPECT_TRUE(topology.bindings_.empty());
+    EXPECT_TRUE(provider.bindThread());
+    EXPECT_EQ(topology.preferred_, -1);
+    provider.unmap(addr, 4096);
+
+    EXPECT_THROW(PageProvider(2, topology), std::invalid_argument);
+}
+
+TEST(PageProviderTest, Flags) {
+    FakeNumaTopology topology;
+    PageProvider provider{0, topology};
+
+    // huge pages fall back to normal ones when none are reserved
+    constexpr size_t BYTES = size_t{4} << 20;
+    void *addr = provider.map(BYTES, size_t{2} << 20,
+                              PoolMapHugeTlb | PoolMapTransparentHuge | PoolMapPopulate |
+                                  PoolMapLock);
+    ASSERT_NE(addr, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(addr) % (size_t{2} << 20), 0);
+    auto *bytes = static_cast<char *>(addr);
+    bytes[0] = 1;
+    bytes[BYTES - 1] = 1;
+    EXPECT_EQ(provider.mapped_bytes(), BYTES);
+    provider.unmap(addr, BYTES);
+
+    // huge pages raise the default alignment
+    addr = provider.map(BYTES, 0, PoolMapHugeTlb);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(addr) % (size_t{2} << 20), 0);
+    static_cast<char *>(addr)[0] = 1;
+    provider.unmap(addr, BYTES);
+}
+
+TEST(PageProviderTest, LockMappings) {
+    FakeNumaTopology topology;
+    PageProvider provider{0, topology};
+
+    constexpr size_t BYTES = size_t{64} << 10;
+    constexpr size_t PAGES = BYTES / 4096;
+    void *before = provider.map(BYTES);
+    void *reserved = provider.map(size_t{1} << 30, 0, PoolMapNoReserve);
+    EXPECT_EQ(residentPages(before, BYTES), 0);
+
+    EXPECT_TRUE(provider.lockMappings());
+    EXPECT_EQ(provider.lock_failures(), 0);
+    EXPECT_EQ(residentPages(before, BYTES), PAGES);
+    // a reservation stays untouched
+    EXPECT_EQ(residentPages(reserved, BYTES), 0);
+
+    // so are later mappings
+    void *after = provider.map(BYTES);
+    EXPECT_EQ(residentPages(after, BYTES), PAGES);
+    void *later = provider.map(size_t{1} << 30, 0, PoolMapNoReserve);
+    EXPECT_EQ(residentPages(later, BYTES), 0);
+
+    provider.unmap(before, BYTES);
+    provider.unmap(reserved, size_t{1} << 30);
+    provider.unmap(after, BYTES);
+    provider.unmap(later, size_t{1} << 30);
+    EXPECT_EQ(provider.mapped_bytes(), 0);
+}
+
+TEST(PageProviderTest, SystemTopology) {
+    auto &topology = SystemNumaTopology::instance();
+    EXPECT_GE(topology.nodeCount(), 1);
+    EXPECT_GE(topology.nodeOfCpu(0), 0);
+    EXPECT_LT(topology.nodeOfCpu(0), topology.nodeCount());
+
+    // node 0 always exists
+    PageProvider provider{0};
+    void *addr = provider.map(4096, 0, PoolMapPopulate);
+    static_cast<char *>(addr)[0] = 1;
+    provider.unmap(addr, 4096);
+}
+
+TEST(PageProviderTest, Allocator) {
+    FakeNumaTopology topology;
+    PageProvider provider{1, topology};
+
+    {
+        PageProvider::Scope scope{provider};
+        EXPECT_EQ(&PageProvider::current(), &provider);
+
+        // small blocks come from the heap
+        std::vector<int64_t, ProviderAllocator<int64_t>> small(16);
+        EXPECT_EQ(provider.mapped_bytes(), 0);
+
+        std::vector<int64_t, ProviderAllocator<int64_t>> large;
+        large.reserve(1 << 16);
+        EXPECT_GE(provider.mapped_bytes(), sizeof(int64_t) << 16);
+        EXPECT_EQ(topology.bindings_.size(), 1);
+        large.resize(1 << 16, 7);
+        EXPECT_EQ(large.back(), 7);
+    }
+    EXPECT_EQ(provider.mapped_bytes(), 0);
+    EXPECT_EQ(&PageProvider::current(), &PageProvider::process());
+}
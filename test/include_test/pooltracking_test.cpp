@@ -0,0 +1,100 @@
+#include "util/pooltracking.hpp"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "util/objectpool.hpp"
+#include "util/slaballocator.hpp"
+
+TEST(PoolTrackingTest, Header) {
+    alignas(uint64_t) char slot[16]{};
+    HeaderTracking tracker;
+
+    EXPECT_FALSE(tracker.isLive(slot));
+    EXPECT_FALSE(tracker.onDeallocate(slot));
+
+    tracker.onAllocate(slot);
+    EXPECT_TRUE(tracker.isLive(slot));
+    EXPECT_TRUE(tracker.onDeallocate(slot));
+    EXPECT_FALSE(tracker.isLive(slot));
+
+    // double free
+    EXPECT_FALSE(tracker.onDeallocate(slot));
+}
+
+TEST(PoolTrackingTest, Full) {
+    int a;
+    int b;
+    FullTracking tracker;
+
+    tracker.onAllocate(&a);
+    tracker.onAllocate(&b);
+    EXPECT_EQ(tracker.live_count(), 2);
+    EXPECT_TRUE(tracker.onDeallocate(&a));
+    EXPECT_FALSE(tracker.onDeallocate(&a));
+    EXPECT_TRUE(tracker.isLive(&b));
+
+    testing::internal::CaptureStderr();
+    tracker.reportLeaks("Pool");
+    std::string report = testing::internal::GetCapturedStderr();
+    EXPECT_NE(report.find("Pool: 1 objects not returned"), std::string::npos);
+
+    EXPECT_TRUE(tracker.onDeallocate(&b));
+    testing::internal::CaptureStderr();
+    tracker.reportLeaks("Pool");
+    EXPECT_TRUE(testing::internal::GetCapturedStderr().empty());
+}
+
+namespace {
+struct TrackedObject {
+    int64_t data{0};
+};
+}  // namespace
+
+template <typename T>
+class TrackedPoolTest : public ::testing::Test {};
+
+using TrackedPools =
+    ::testing::Types<ObjectPool<TrackedObject, 32, PoolMapDefault, HeaderTracking>,
+                     ObjectPool<TrackedObject, 32, PoolMapDefault, FullTracking>,
+                     SlabAllocator<TrackedObject, 32, HeaderTracking>,
+                     SlabAllocator<TrackedObject, 32, FullTracking>>;
+
+TYPED_TEST_SUITE(TrackedPoolTest, TrackedPools);
+
+TYPED_TEST(TrackedPoolTest, DoubleFree) {
+    auto &pool = TypeParam::GetInst();
+
+    TrackedObject *a = pool.allocate(1);
+    TrackedObject *b = pool.allocate(2);
+    pool.deallocate(a);
+    // ignored, a must not be handed out twice
+    pool.deallocate(a);
+
+    TrackedObject *c = pool.allocate(3);
+    TrackedObject *d = pool.allocate(4);
+    EXPECT_NE(c, d);
+    EXPECT_EQ(b->data, 2);
+
+    pool.deallocate(b);
+    pool.deallocate(c);
+    pool.deallocate(d);
+}
+
+template <typename Pool>
+void allocateAndFree(Pool &pool) {
+    std::vector<TrackedObject *> objs;
+    for (int i = 0; i < 100; i++) {
+        objs.push_back(pool.allocate(i));
+    }
+    for (int i = 0; i < 100; i++) {
+        ASSERT_EQ(objs[i]->data, i);
+        pool.deallocate(objs[i]);
+    }
+}
+
+TEST(PoolTrackingTest, Untracked) {
+    allocateAndFree(ObjectPool<TrackedObject, 32, PoolMapDefault, NoTracking>::GetInst());
+    allocateAndFree(SlabAllocator<TrackedObject, 32, NoTracking>::GetInst());
+}
@@ -0,0 +1,48 @@
+#include "concurrency/seqlock.hpp"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+struct Pair {
+    int64_t a;
+    int64_t b;
+};
+
+TEST(SeqLockTest, Basic) {
+    SeqLock<Pair> lock;
+    EXPECT_EQ(lock.load().a, 0);
+
+    lock.store(Pair{1, 2});
+    Pair p = lock.load();
+    EXPECT_EQ(p.a, 1);
+    EXPECT_EQ(p.b, 2);
+
+    lock.update([](Pair &data) { data.b = 3; });
+    EXPECT_TRUE(lock.tryLoad(p));
+    EXPECT_EQ(p.a, 1);
+    EXPECT_EQ(p.b, 3);
+}
+
+TEST(SeqLockTest, Concurrent) {
+    static constexpr int64_t COUNT = 200000;
+    SeqLock<Pair> lock;
+
+    std::thread reader([&lock]() {
+        int64_t last = 0;
+        while (last < COUNT) {
+            Pair p = lock.load();
+            ASSERT_EQ(p.b, -p.a);  // never torn
+            ASSERT_GE(p.a, last);  // never goes back
+            last = p.a;
+        }
+    });
+
+    for (int64_t i = 1; i <= COUNT; i++) {
+        lock.update([i](Pair &data) {
+            data.a = i;
+            data.b = -i;
+        });
+    }
+    reader.join();
+}
\ No newline at end of file
@@ -0,0 +1,192 @@
+#include "concurrency/shmspscqueue.hpp"
+
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <thread>
+
+namespace {
+
+struct Message {
+    uint64_t sequence_;
+    double price_;
+    char symbol_[16];
+};
+
+using Ring = ShmSPSCQueue<Message, 256>;
+
+std::string segmentName(const char *test) {
+    return "/order_book_" + std::string{test} + "_" + std::to_string(getpid());
+}
+
+}  // namespace
+
+TEST(ShmSPSCQueueTest, NamedSegment) {
+    std::string name = segmentName("named");
+    ShmSegment created = ShmSegment::openOrCreate(name, Ring::segmentSize());
+    ASSERT_TRUE(created.created());
+    Ring producer{created, Ring::Role::Producer};
+
+    // a second mapping, as another process would see it
+    ShmSegment attached = ShmSegment::open(name);
+    EXPECT_FALSE(attached.created());
+    EXPECT_NE(attached.data(), created.data());
+    Ring consumer{attached, Ring::Role::Consumer};
+
+    Message burst[300];
+    for (uint64_t i = 0; i < 300; i++) {
+        burst[i] = Message{i, 100.0 + i, "AAPL"};
+    }
+    EXPECT_EQ(producer.push_n(burst, 300), 256);
+    EXPECT_FALSE(producer.push(burst[0]));
+    EXPECT_EQ(consumer.size(), 256);
+
+    Message out[100];
+    EXPECT_EQ(consumer.pop_n(out, 100), 100);
+    EXPECT_EQ(out[99].sequence_, 99);
+    EXPECT_STREQ(out[99].symbol_, "AAPL");
+
+    uint64_t next = 100;
+    EXPECT_EQ(consumer.consume_all([&next](const Message &m) { EXPECT_EQ(m.sequence_, next++); }),
+              156);
+    EXPECT_TRUE(consumer.empty());
+
+    ShmSegment::unlink(name);
+}
+
+TEST(ShmSPSCQueueTest, UnsizedSegment) {
+    std::string name = segmentName("unsized");
+    // created by a process that has not sized it yet
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    ASSERT_GE(fd, 0);
+    std::thread creator([fd] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ASSERT_EQ(ftruncate(fd, Ring::segmentSize()), 0);
+    });
+    ShmSegment attached = ShmSegment::open(name);
+    creator.join();
+    EXPECT_EQ(attached.size(), Ring::segmentSize());
+    ShmSegment::unlink(name);
+    close(fd);
+
+    // the creator died before sizing it
+    name = segmentName("unsized_dead");
+    fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    ASSERT_GE(fd, 0);
+    EXPECT_THROW(ShmSegment::open(name, std::chrono::milliseconds(10)), std::system_error);
+    ShmSegment segment =
+        ShmSegment::openOrCreate(name, Ring::segmentSize(), std::chrono::milliseconds(10));
+    EXPECT_EQ(segment.size(), Ring::segmentSize());
+    Ring producer{segment, Ring::Role::Producer};
+    EXPECT_TRUE(producer.push(Message{1, 1.0, "IBM"}));
+    ShmSegment::unlink(name);
+    close(fd);
+}
+
+TEST(ShmSPSCQueueTest, DeadCreator) {
+    ShmSegment segment = ShmSegment::anonymous(Ring::segmentSize());
+
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        // claims the ring as its creator and dies before initializing it,
+        // the header starts with the magic and the creator's pid
+        auto *header = static_cast<char *>(segment.data());
+        int32_t pid = getpid();
+        std::memcpy(header + sizeof(uint64_t), &pid, sizeof(pid));
+        _exit(0);
+    }
+    int status;
+    waitpid(child, &status, 0);
+
+    // taken over and initialized again
+    Ring consumer{segment, Ring::Role::Consumer};
+    Ring producer{segment, Ring::Role::Producer};
+    EXPECT_TRUE(producer.push(Message{7, 1.0, "IBM"}));
+    Message m;
+    EXPECT_TRUE(consumer.pop(m));
+    EXPECT_EQ(m.sequence_, 7);
+}
+
+TEST(ShmSPSCQueueTest, RoleClaims) {
+    ShmSegment segment = ShmSegment::anonymous(Ring::segmentSize());
+    ShmSegment other = ShmSegment::fromFd(dup(segment.fd()));
+    Ring producer{segment, Ring::Role::Producer};
+
+    // the role is held by a live process
+    EXPECT_THROW((Ring{other, Ring::Role::Producer}), std::runtime_error);
+
+    // another layout
+    ShmSegment again = ShmSegment::fromFd(dup(segment.fd()));
+    EXPECT_THROW((ShmSPSCQueue<Message, 128>{again, ShmSPSCQueue<Message, 128>::Role::Consumer}),
+                 std::runtime_error);
+
+    producer.detach();
+    Ring next{other, Ring::Role::Producer};
+    EXPECT_TRUE(next.push(Message{1, 1.0, "IBM"}));
+}
+
+TEST(ShmSPSCQueueTest, CrossProcess) {
+    static constexpr uint64_t COUNT = 100000;
+    ShmSegment segment = ShmSegment::anonymous(Ring::segmentSize());
+    Ring consumer{segment, Ring::Role::Consumer};
+
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        // producer process, crashes without detaching
+        ShmSegment mine = ShmSegment::fromFd(dup(segment.fd()));
+        Ring producer{mine, Ring::Role::Producer};
+        for (uint64_t i = 0; i < COUNT;) {
+            Message m{i, 0.0, "MSFT"};
+            if (producer.push(m)) {
+                i++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        _exit(0);
+    }
+
+    uint64_t next = 0;
+    bool ordered = true;
+    while (next < COUNT) {
+        if (consumer.consume_all([&](const Message &m) { ordered &= m.sequence_ == next++; }) ==
+            0) {
+            std::this_thread::yield();
+        }
+    }
+    EXPECT_TRUE(ordered);
+
+    int status;
+    waitpid(child, &status, 0);
+    EXPECT_FALSE(consumer.producerAlive(std::chrono::seconds(10)));
+
+    // the dead producer's role is taken over
+    Ring producer{segment, Ring::Role::Producer};
+    EXPECT_TRUE(producer.push(Message{COUNT, 0.0, "MSFT"}));
+    Message m;
+    EXPECT_TRUE(consumer.pop(m));
+    EXPECT_EQ(m.sequence_, COUNT);
+}
+
+TEST(ShmSPSCQueueTest, Heartbeat) {
+    ShmSegment segment = ShmSegment::anonymous(Ring::segmentSize());
+    Ring consumer{segment, Ring::Role::Consumer};
+    EXPECT_FALSE(consumer.producerAlive(std::chrono::seconds(1)));
+
+    Ring producer{segment, Ring::Role::Producer};
+    EXPECT_TRUE(consumer.producerAlive(std::chrono::seconds(1)));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(consumer.producerAlive(std::chrono::milliseconds(10)));
+    producer.heartbeat();
+    EXPECT_TRUE(consumer.producerAlive(std::chrono::milliseconds(10)));
+}
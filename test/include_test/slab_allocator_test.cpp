@@ -49,4 +49,64 @@ TEST(SlabAllocatorTest, Basic) {
 
     ASSERT_EQ(createCount, SLAB_SIZE * SLAB_COUNT);
     ASSERT_EQ(destroyCount, SLAB_SIZE * SLAB_COUNT);
-};
\ No newline at end of file
+};
+TEST(SlabAllocatorTest, Reuse) {
+    struct TestObject {
+        explicit TestObject(int v) : data{v} {}
+
+        int data;
+        char payload[100];
+    };
+
+    static constexpr int SLAB_SIZE = 8;
+    auto &pool = SlabAllocator<TestObject, SLAB_SIZE>::GetInst();
+
+    // a returned slot is handed out again first
+    TestObject *a = pool.allocate(1);
+    pool.deallocate(a);
+    TestObject *b = pool.allocate(2);
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(b->data, 2);
+
+    std::vector<TestObject *> objs{b};
+    for (int i = 1; i < SLAB_SIZE * 3; i++) {
+        objs.push_back(pool.allocate(i));
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(objs.back()) % alignof(TestObject), 0);
+    }
+    EXPECT_EQ(pool.full_list_size(), 3);
+
+    for (auto obj : objs) {
+        pool.deallocate(obj);
+    }
+    EXPECT_EQ(pool.free_list_size(), 3);
+    EXPECT_EQ(pool.full_list_size(), 0);
+    EXPECT_EQ(pool.partial_list_size(), 0);
+}
+
+TEST(SlabAllocatorTest, OwnedInstance) {
+    struct TestObject {
+        int data;
+    };
+
+    PageProvider provider;
+    {
+        using OwnedSlabs = SlabAllocator<TestObject, 16, DefaultPoolTracking, MMapAllocator,
+                                         SingleOwnerMutex>;
+        OwnedSlabs pool{MMapAllocator{&provider}};
+        EXPECT_EQ(pool.free_list_size(), 1);
+        EXPECT_GT(provider.mapped_bytes(), 0);
+
+        std::vector<TestObject *> objs;
+        for (int i = 0; i < 40; i++) {
+            objs.push_back(pool.allocate(i));
+        }
+        EXPECT_EQ(pool.full_list_size(), 2);
+        EXPECT_EQ(pool.partial_list_size(), 1);
+        EXPECT_EQ(OwnedSlabs::GetInst().full_list_size(), 0);
+        for (auto obj : objs) {
+            pool.deallocate(obj);
+        }
+        EXPECT_EQ(pool.free_list_size(), 3);
+    }
+    EXPECT_EQ(provider.mapped_bytes(), 0);
+}
@@ -0,0 +1,100 @@
+#include "concurrency/spscqueue.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+TEST(SPSCQueueTest, Basic) {
+    SPSCQueue<int, 4> queue;
+    EXPECT_TRUE(queue.empty());
+
+    // every slot is usable
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.emplace(i));
+    }
+    EXPECT_FALSE(queue.emplace(4));
+    EXPECT_EQ(queue.size(), 4);
+
+    int value;
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.pop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(queue.pop(value));
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(SPSCQueueTest, Bulk) {
+    SPSCQueue<int, 8> queue;
+    std::vector<int> in{0, 1, 2, 3, 4, 5};
+
+    EXPECT_EQ(queue.push_n(in.begin(), in.size()), 6);
+    // only two slots left, wraps around below
+    EXPECT_EQ(queue.push_n(in.begin(), in.size()), 2);
+    EXPECT_EQ(queue.size(), 8);
+
+    std::vector<int> out;
+    EXPECT_EQ(queue.pop_n(std::back_inserter(out), 4), 4);
+    EXPECT_EQ(out, (std::vector<int>{0, 1, 2, 3}));
+
+    EXPECT_EQ(queue.push_n(in.begin(), 3), 3);
+    out.clear();
+    EXPECT_EQ(queue.pop_n(std::back_inserter(out), 100), 7);
+    EXPECT_EQ(out, (std::vector<int>{4, 5, 0, 1, 0, 1, 2}));
+    EXPECT_EQ(queue.pop_n(std::back_inserter(out), 1), 0);
+
+    EXPECT_EQ(queue.push_n(in.begin(), 5), 5);
+    int sum = 0;
+    EXPECT_EQ(queue.consume_all([&sum](int &value) { sum += value; }), 5);
+    EXPECT_EQ(sum, 10);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(SPSCQueueTest, Destruction) {
+    auto counter = std::make_shared<int>(0);
+    {
+        SPSCQueue<std::shared_ptr<int>, 4> queue;
+        queue.emplace(counter);
+        queue.emplace(counter);
+        std::shared_ptr<int> out;
+        queue.pop(out);
+        queue.emplace(counter);
+        EXPECT_EQ(counter.use_count(), 4);
+    }
+    // elements left in the queue are destroyed
+    EXPECT_EQ(counter.use_count(), 1);
+}
+
+TEST(SPSCQueueTest, Concurrent) {
+    static constexpr uint64_t COUNT = 1000000;
+    SPSCQueue<uint64_t, 1024> queue;
+
+    std::thread producer([&queue] {
+        uint64_t burst[32];
+        for (uint64_t next = 0; next < COUNT;) {
+            size_t n = std::min<uint64_t>(1 + next % 32, COUNT - next);
+            for (size_t i = 0; i < n; i++) {
+                burst[i] = next + i;
+            }
+            size_t pushed = queue.push_n(burst, n);
+            next += pushed;
+            if (pushed == 0) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint64_t expected = 0;
+    bool ordered = true;
+    while (expected < COUNT) {
+        size_t n = queue.consume_all([&](uint64_t value) { ordered &= value == expected++; });
+        if (n == 0) {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    EXPECT_TRUE(ordered);
+    EXPECT_TRUE(queue.empty());
+}
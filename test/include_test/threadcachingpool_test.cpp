@@ -0,0 +1,127 @@
+#include "util/threadcachingpool.hpp"
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <thread>
+#include <vector>
+
+static std::atomic<int> createCount;
+static std::atomic<int> destroyCount;
+
+struct PooledObject {
+    PooledObject() { createCount++; }
+    explicit PooledObject(int v) : PooledObject() { data = v; }
+    ~PooledObject() { destroyCount++; }
+
+    int data{0};
+};
+
+TEST(ThreadCachingObjectPoolTest, Basic) {
+    createCount = 0;
+    destroyCount = 0;
+
+    auto &pool = ThreadCachingObjectPool<PooledObject>::GetInst();
+
+    std::vector<PooledObject *> objs;
+    std::set<PooledObject *> unique;
+    for (int i = 0; i < 10000; i++) {
+        auto obj = pool.allocate(i);
+        EXPECT_EQ(obj->data, i);
+        objs.push_back(obj);
+        unique.insert(obj);
+    }
+    EXPECT_EQ(unique.size(), objs.size());
+    EXPECT_GE(pool.chunk_count(), 1);
+
+    for (auto obj : objs) {
+        pool.deallocate(obj);
+    }
+
+    // freed slots are reused before new chunks are mapped
+    size_t chunks = pool.chunk_count();
+    objs.clear();
+    for (int i = 0; i < 10000; i++) {
+        objs.push_back(pool.allocate());
+    }
+    EXPECT_EQ(pool.chunk_count(), chunks);
+    for (auto obj : objs) {
+        pool.deallocate(obj);
+    }
+
+    EXPECT_EQ(createCount, 20000);
+    EXPECT_EQ(destroyCount, 20000);
+}
+
+TEST(ThreadCachingObjectPoolTest, RemoteFreeReturnsToOwner) {
+    using Pool = ThreadCachingObjectPool<PooledObject, (1 << 16), 8>;
+    auto &pool = Pool::GetInst();
+
+    PooledObject *obj = nullptr;
+    std::atomic<int> step{0};
+
+    std::thread owner([&]() {
+        obj = pool.allocate(1);
+        step = 1;
+        while (step != 2);
+        // the magazine is empty, the remote free is picked up first
+        PooledObject *again = pool.allocate(2);
+        EXPECT_EQ(again, obj);
+        pool.deallocate(again);
+    });
+
+    std::thread other([&]() {
+        while (step != 1);
+        pool.deallocate(obj);
+        step = 2;
+    });
+
+    owner.join();
+    other.join();
+}
+
+TEST(ThreadCachingObjectPoolTest, MultiThread) {
+    createCount = 0;
+    destroyCount = 0;
+
+    static constexpr int THREADS = 4;
+    static constexpr int ROUNDS = 200;
+    static constexpr int BATCH = 100;
+    auto &pool = ThreadCachingObjectPool<PooledObject>::GetInst();
+
+    // every thread frees what its neighbour allocated
+    std::vector<PooledObject *> slots[THREADS];
+    std::atomic<int> arrived{0};
+    auto barrier = [&arrived](int phase) {
+        arrived++;
+        while (arrived < phase * THREADS);
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++) {
+        threads.emplace_back([&, t]() {
+            for (int round = 0; round < ROUNDS; round++) {
+                for (int i = 0; i < BATCH; i++) {
+                    slots[t].push_back(pool.allocate(t));
+                }
+                for (auto obj : slots[t]) {
+                    EXPECT_EQ(obj->data, t);
+                }
+                barrier(round * 2 + 1);
+
+                auto &neighbour = slots[(t + 1) % THREADS];
+                for (auto obj : neighbour) {
+                    pool.deallocate(obj);
+                }
+                neighbour.clear();
+                barrier(round * 2 + 2);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(createCount, THREADS * ROUNDS * BATCH);
+    EXPECT_EQ(destroyCount, THREADS * ROUNDS * BATCH);
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include "concurrency/workstealingqueue.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST(WorkStealingQueueTest, Basic) {
+    WorkStealingQueue<int, 4> queue;
+    EXPECT_TRUE(queue.empty());
+
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.push(i));
+    }
+    EXPECT_FALSE(queue.push(4));
+    EXPECT_EQ(queue.size(), 4);
+
+    // owner and thieves both take the oldest
+    int value;
+    EXPECT_TRUE(queue.pop(value));
+    EXPECT_EQ(value, 0);
+    EXPECT_TRUE(queue.steal(value));
+    EXPECT_EQ(value, 1);
+
+    // wraps around
+    EXPECT_TRUE(queue.push(4));
+    EXPECT_TRUE(queue.push(5));
+    for (int i = 2; i < 6; i++) {
+        EXPECT_TRUE(queue.pop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(queue.pop(value));
+    EXPECT_FALSE(queue.steal(value));
+}
+
+// the owner pushes and pops while thieves steal, every element is taken once
+TEST(WorkStealingQueueTest, Concurrent) {
+    constexpr int COUNT = 200000;
+    constexpr int THIEVES = 3;
+    WorkStealingQueue<int, 64> queue;
+    std::vector<std::atomic<int>> taken(COUNT);
+    std::atomic<bool> done{false};
+
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < THIEVES; t++) {
+        thieves.emplace_back([&] {
+            int value;
+            while (!done.load(std::memory_order_acquire)) {
+                if (queue.steal(value)) {
+                    taken[value].fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    int value;
+    for (int i = 0; i < COUNT; i++) {
+        while (!queue.push(i)) {
+            std::this_thread::yield();
+        }
+        if (i % 3 == 0 && queue.pop(value)) {
+            taken[value].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    while (queue.pop(value)) {
+        taken[value].fetch_add(1, std::memory_order_relaxed);
+    }
+    done.store(true, std::memory_order_release);
+    for (auto &thief : thieves) {
+        thief.join();
+    }
+
+    for (int i = 0; i < COUNT; i++) {
+        ASSERT_EQ(taken[i].load(), 1) << i;
+    }
+}
@@ -0,0 +1,194 @@
+#include "book/allocation_policy.hpp"
+
+#include <gtest/gtest.h>
+
+#include "book/book_l3_map.hpp"
+#include "book/book_l3_vector.hpp"
+
+TEST(AllocationPolicyTest, PriceTime) {
+    Quantity resting[] = {100, 200, 300};
+    Quantity out[3];
+
+    EXPECT_EQ(PriceTimeAllocation::allocate(250, resting, out, 3), 250);
+    EXPECT_EQ(out[0], 100);
+    EXPECT_EQ(out[1], 150);
+    EXPECT_EQ(out[2], 0);
+}
+
+TEST(AllocationPolicyTest, ProRata) {
+    Quantity resting[] = {100, 200, 300};
+    Quantity out[3];
+
+    EXPECT_EQ(ProRataAllocation::allocate(300, resting, out, 3), 300);
+    EXPECT_EQ(out[0], 50);
+    EXPECT_EQ(out[1], 100);
+    EXPECT_EQ(out[2], 150);
+
+    // fully consumes the level
+    EXPECT_EQ(ProRataAllocation::allocate(1000, resting, out, 3), 600);
+    EXPECT_EQ(out[0], 100);
+    EXPECT_EQ(out[1], 200);
+    EXPECT_EQ(out[2], 300);
+}
+
+TEST(AllocationPolicyTest, ProRataRounding) {
+    // rounding leftovers go to the oldest orders
+    Quantity resting[] = {1, 1, 1};
+    Quantity out[3];
+
+    EXPECT_EQ(ProRataAllocation::allocate(2, resting, out, 3), 2);
+    EXPECT_EQ(out[0], 1);
+    EXPECT_EQ(out[1], 1);
+    EXPECT_EQ(out[2], 0);
+
+    Quantity resting2[] = {3, 3, 4};
+    EXPECT_EQ(ProRataAllocation::allocate(5, resting2, out, 3), 5);
+    EXPECT_EQ(out[0], 2);
+    EXPECT_EQ(out[1], 1);
+    EXPECT_EQ(out[2], 2);
+}
+
+TEST(AllocationPolicyTest, ProRataLargeQuantity) {
+    Quantity resting[] = {Quantity{1} << 40, Quantity{1} << 40};
+    Quantity out[2];
+
+    EXPECT_EQ(ProRataAllocation::allocate(Quantity{1} << 40, resting, out, 2),
+              Quantity{1} << 40);
+    EXPECT_EQ(out[0], Quantity{1} << 39);
+    EXPECT_EQ(out[1], Quantity{1} << 39);
+}
+
+TEST(AllocationPolicyTest, FifoProRata) {
+    Quantity resting[] = {100, 100, 200};
+    Quantity out[3];
+
+    // 40 by FIFO to the first order, 60 pro-rata over {60, 100, 200}
+    EXPECT_EQ(FifoProRataAllocation<40>::allocate(100, resting, out, 3), 100);
+    EXPECT_EQ(out[0], 40 + 10 + 1);
+    EXPECT_EQ(out[1], 16);
+    EXPECT_EQ(out[2], 33);
+
+    EXPECT_EQ(FifoProRataAllocation<40>::allocate(500, resting, out, 3), 400);
+    EXPECT_EQ(out[0], 100);
+    EXPECT_EQ(out[1], 100);
+    EXPECT_EQ(out[2], 200);
+}
+
+// the price-time default carries no allocation scratch buffers
+TEST(AllocationPolicyTest, PriceTimeBookSize) {
+    using PriceTimeBook = MapBasedL3OrderBook<std::list<Order *>>;
+    using ProRataBook =
+        MapBasedL3OrderBook<std::list<Order *>, MapBasedL2OrderBook, ProRataAllocation>;
+    EXPECT_GE(sizeof(ProRataBook) - sizeof(PriceTimeBook), 2 * sizeof(std::vector<Quantity>));
+}
+
+template <typename T>
+class ProRataL3OrderBookTest : public ::testing::Test {};
+
+using ProRataTypes = ::testing::Types<
+    MapBasedL3OrderBook<std::list<Order *>, MapBasedL2OrderBook, ProRataAllocation>,
+    MapBasedL3OrderBook<std::set<Order *, OrderCompare>, MapBasedL2OrderBook,
+                        ProRataAllocation>,
+    VectorBasedL3OrderBook<std::list<Order *>, BinaryLevelSearcher, MapBasedL2OrderBook,
+                           65536, ProRataAllocation>>;
+
+TYPED_TEST_SUITE(ProRataL3OrderBookTest, ProRataTypes);
+
+TYPED_TEST(ProRataL3OrderBookTest, Match) {
+    TypeParam orderBook;
+
+    Order ask1{"1", OrderType::GoodTillCancel, Side::Sell, 10.0, 100};
+    Order ask2{"2", OrderType::GoodTillCancel, Side::Sell, 10.0, 200};
+    Order ask3{"3", OrderType::GoodTillCancel, Side::Sell, 10.0, 300};
+    Order ask4{"4", OrderType::GoodTillCancel, Side::Sell, 11.0, 100};
+
+    ASSERT_TRUE(orderBook.addOrder(&ask1).empty());
+    ASSERT_TRUE(orderBook.addOrder(&ask2).empty());
+    ASSERT_TRUE(orderBook.addOrder(&ask3).empty());
+    ASSERT_TRUE(orderBook.addOrder(&ask4).empty());
+
+    Order bid1{"5", OrderType::GoodTillCancel, Side::Buy, 10.0, 300};
+    Trades trades = orderBook.addOrder(&bid1);
+    ASSERT_EQ(trades.size(), 3);
+    EXPECT_EQ(trades[0].askTrade_.orderId_, "1");
+    EXPECT_EQ(trades[0].askTrade_.quantity_, 50);
+    EXPECT_EQ(trades[1].askTrade_.orderId_, "2");
+    EXPECT_EQ(trades[1].askTrade_.quantity_, 100);
+    EXPECT_EQ(trades[2].askTrade_.orderId_, "3");
+    EXPECT_EQ(trades[2].askTrade_.quantity_, 150);
+    for (const auto &trade : trades) {
+        EXPECT_EQ(trade.bidTrade_.orderId_, "5");
+        EXPECT_EQ(trade.bidTrade_.price_, 10.0);
+    }
+    EXPECT_TRUE(orderBook.isBidEmpty());
+
+    // sweeps the 10.0 level and takes part of 11.0
+    Order bid2{"6", OrderType::GoodTillCancel, Side::Buy, 11.0, 350};
+    trades = orderBook.addOrder(&bid2);
+    ASSERT_EQ(trades.size(), 4);
+    EXPECT_EQ(trades[0].askTrade_.quantity_, 50);
+    EXPECT_EQ(trades[1].askTrade_.quantity_, 100);
+    EXPECT_EQ(trades[2].askTrade_.quantity_, 150);
+    EXPECT_EQ(trades[3].askTrade_.orderId_, "4");
+    EXPECT_EQ(trades[3].askTrade_.price_, 11.0);
+    EXPECT_EQ(trades[3].askTrade_.quantity_, 50);
+
+    EXPECT_TRUE(orderBook.isBidEmpty());
+    ASSERT_FALSE(orderBook.isAskEmpty());
+    EXPECT_EQ(orderBook.getBestAsk()->getOrderId(), "4");
+    EXPECT_EQ(orderBook.getBestAsk()->getRemainingQuantity(), 50);
+}
+
+TYPED_TEST(ProRataL3OrderBookTest, SellAggressor) {
+    TypeParam orderBook;
+
+    Order bid1{"1", OrderType::GoodTillCancel, Side::Buy, 10.0, 1};
+    Order bid2{"2", OrderType::GoodTillCancel, Side::Buy, 10.0, 1};
+    Order bid3{"3", OrderType::GoodTillCancel, Side::Buy, 10.0, 1};
+    orderBook.addOrder(&bid1);
+    orderBook.addOrder(&bid2);
+    orderBook.addOrder(&bid3);
+
+    Order ask{"4", OrderType::GoodTillCancel, Side::Sell, 9.0, 2};
+    Trades trades = orderBook.addOrder(&ask);
+    ASSERT_EQ(trades.size(), 2);
+    EXPECT_EQ(trades[0].bidTrade_.orderId_, "1");
+    EXPECT_EQ(trades[1].bidTrade_.orderId_, "2");
+    EXPECT_EQ(trades[0].askTrade_.price_, 9.0);
+
+    EXPECT_TRUE(orderBook.isAskEmpty());
+    ASSERT_FALSE(orderBook.isBidEmpty());
+    EXPECT_EQ(orderBook.getBestBid()->getOrderId(), "3");
+}
+
+// several aggressors in a row against the same resting level, each split
+// over what the previous ones left
+TYPED_TEST(ProRataL3OrderBookTest, SuccessiveAggressors) {
+    TypeParam orderBook;
+    orderBook.startAuction();
+
+    Order ask1{"1", OrderType::GoodTillCancel, Side::Sell, 10.0, 100};
+    Order ask2{"2", OrderType::GoodTillCancel, Side::Sell, 10.0, 200};
+    Order ask3{"3", OrderType::GoodTillCancel, Side::Sell, 10.0, 300};
+    Order bid1{"4", OrderType::GoodTillCancel, Side::Buy, 10.0, 150};
+    Order bid2{"5", OrderType::GoodTillCancel, Side::Buy, 10.0, 150};
+    orderBook.addOrder(&ask1);
+    orderBook.addOrder(&ask2);
+    orderBook.addOrder(&ask3);
+    orderBook.addOrder(&bid1);
+    orderBook.addOrder(&bid2);
+
+    Trades trades = orderBook.uncross();
+    ASSERT_EQ(trades.size(), 6);
+    const Quantity expected[] = {25, 50, 75, 25, 50, 75};
+    for (size_t i = 0; i < trades.size(); i++) {
+        EXPECT_EQ(trades[i].bidTrade_.orderId_, i < 3 ? "4" : "5");
+        EXPECT_EQ(trades[i].askTrade_.quantity_, expected[i]);
+    }
+
+    EXPECT_TRUE(orderBook.isBidEmpty());
+    EXPECT_EQ(ask1.getRemainingQuantity(), 50);
+    EXPECT_EQ(ask2.getRemainingQuantity(), 100);
+    EXPECT_EQ(ask3.getRemainingQuantity(), 150);
+    EXPECT_EQ(orderBook.getOrderCount(), 3);
+}
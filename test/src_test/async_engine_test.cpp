@@ -0,0 +1,142 @@
+#include "book/async_engine.hpp"
+
+#include <gtest/gtest.h>
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "book/book_l3_map.hpp"
+
+namespace {
+
+using Book = MapBasedL3OrderBook<std::list<Order *>>;
+using Engine = AsyncEngine<Book, 1024, 256>;
+
+RunnerConfig testConfig() {
+    RunnerConfig config;
+    config.cores_ = {-1};
+    config.idle_.spins_ = 16;
+    config.idle_.yields_ = 1 << 20;
+    config.stackPrefaultBytes_ = 0;
+    return config;
+}
+
+// a client resting a bid, then taking it back
+DetachedTask session(Engine &engine, size_t book, Order &order, int &done,
+                     std::vector<ExecutionResult> &results) {
+    results.push_back(co_await engine.submit(book, &order));
+    results.push_back(co_await engine.modify(book, &order, OrderModify{Side::Buy, 90.0, 5}));
+    results.push_back(co_await engine.cancel(book, &order));
+    done++;
+}
+
+DetachedTask taker(Engine &engine, size_t book, Order &order, ExecutionResult &result) {
+    result = co_await engine.submit(book, &order);
+}
+
+template <typename Pred>
+void pollUntil(Engine &engine, Pred pred) {
+    while (!pred()) {
+        if (engine.poll() == 0) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+}  // namespace
+
+TEST(AsyncEngineTest, Sessions) {
+    constexpr int SESSIONS = 100;
+    Engine engine{testConfig()};
+    Book book;
+    size_t handle = engine.attach(0, book);
+    engine.start();
+
+    std::vector<Order> orders;
+    orders.reserve(SESSIONS);
+    std::vector<std::vector<ExecutionResult>> results(SESSIONS);
+    int done = 0;
+    for (int i = 0; i < SESSIONS; i++) {
+        orders.emplace_back(std::to_string(i), OrderType::GoodTillCancel, Side::Buy, 100.0, 10);
+        session(engine, handle, orders[i], done, results[i]);
+    }
+    // every session waits for its first command
+    EXPECT_EQ(engine.in_flight(), SESSIONS);
+    pollUntil(engine, [&] { return done == SESSIONS; });
+    EXPECT_EQ(engine.in_flight(), 0);
+
+    for (const auto &result : results) {
+        ASSERT_EQ(result.size(), 3);
+        EXPECT_TRUE(result[0].accepted_);
+        EXPECT_EQ(result[0].remaining_, 10);
+        EXPECT_EQ(result[1].remaining_, 5);
+        EXPECT_TRUE(result[2].accepted_);
+    }
+    EXPECT_EQ(book.getOrderCount(), 0);
+    engine.stop();
+    EXPECT_EQ(engine.runner().stats(0).commands_, 3 * SESSIONS);
+}
+
+TEST(AsyncEngineTest, Trades) {
+    Engine engine{testConfig()};
+    Book book;
+    size_t handle = engine.attach(0, book);
+    engine.start();
+
+    Order bid{"bid", OrderType::GoodTillCancel, Side::Buy, 100.0, 10};
+    Order ask{"ask", OrderType::GoodTillCancel, Side::Sell, 100.0, 4};
+    ExecutionResult resting;
+    ExecutionResult taken;
+    taker(engine, handle, bid, resting);
+    taker(engine, handle, ask, taken);
+    pollUntil(engine, [&] { return engine.in_flight() == 0; });
+
+    EXPECT_EQ(resting.trades_, 0);
+    EXPECT_EQ(taken.trades_, 1);
+    EXPECT_EQ(taken.filled_, 4);
+    EXPECT_EQ(taken.remaining_, 0);
+}
+
+TEST(AsyncEngineTest, InFlightLimit) {
+    // not started, nothing completes
+    AsyncEngine<Book, 1024, 2> engine{testConfig()};
+    Book book;
+    size_t handle = engine.attach(0, book);
+
+    std::vector<Order> orders;
+    orders.reserve(3);
+    std::vector<ExecutionResult> results(3);
+    for (int i = 0; i < 3; i++) {
+        orders.emplace_back(std::to_string(i), OrderType::GoodTillCancel, Side::Buy, 100.0, 10);
+        [](auto &engine, size_t handle, Order &order, ExecutionResult &result) -> DetachedTask {
+            result = co_await engine.submit(handle, &order);
+        }(engine, handle, orders[i], results[i]);
+    }
+    EXPECT_EQ(engine.in_flight(), 2);
+    // the third returned at once
+    EXPECT_FALSE(results[2].accepted_);
+
+    engine.start();
+    while (engine.in_flight() > 0) {
+        engine.poll();
+    }
+    EXPECT_TRUE(results[0].accepted_);
+    EXPECT_TRUE(results[1].accepted_);
+}
+
+TEST(AsyncEngineTest, PooledFrames) {
+    Engine engine{testConfig()};
+    Book book;
+    size_t handle = engine.attach(0, book);
+    engine.start();
+
+    size_t used = FramePool::used_bytes();
+    Order order{"1", OrderType::GoodTillCancel, Side::Buy, 100.0, 10};
+    ExecutionResult result;
+    taker(engine, handle, order, result);
+    // the suspended frame is a pool block
+    EXPECT_GT(FramePool::used_bytes(), used);
+    pollUntil(engine, [&] { return engine.in_flight() == 0; });
+    EXPECT_EQ(FramePool::used_bytes(), used);
+}
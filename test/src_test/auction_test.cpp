@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include "book/book_l2_vector.hpp"
+#include "book/book_l3_map.hpp"
+#include "book/book_l3_vector.hpp"
+
+template <typename T>
+class AuctionTest : public ::testing::Test {};
+
+using AuctionTypes = ::testing::Types<
+    MapBasedL3OrderBook<std::list<Order *>>,
+    MapBasedL3OrderBook<std::set<Order *, OrderCompare>>,
+    MapBasedL3OrderBook<std::list<Order *>, VectorBasedL2OrderBook<>>,
+    VectorBasedL3OrderBook<std::list<Order *>>,
+    VectorBasedL3OrderBook<std::multiset<Order *, OrderCompare>, LinearLevelSearcher>,
+    MapBasedL3OrderBook<std::list<Order *>, MapBasedL2OrderBook, ProRataAllocation>>;
+
+TYPED_TEST_SUITE(AuctionTest, AuctionTypes);
+
+TYPED_TEST(AuctionTest, Uncross) {
+    TypeParam orderBook;
+    orderBook.startAuction();
+    EXPECT_EQ(orderBook.getTradingMode(), TradingMode::Auction);
+
+    Order bid1{"1", OrderType::GoodTillCancel, Side::Buy, 10.2, 100};
+    Order bid2{"2", OrderType::GoodTillCancel, Side::Buy, 10.1, 200};
+    Order bid3{"3", OrderType::GoodTillCancel, Side::Buy, 10.0, 300};
+    Order ask1{"4", OrderType::GoodTillCancel, Side::Sell, 9.9, 150};
+    Order ask2{"5", OrderType::GoodTillCancel, Side::Sell, 10.0, 150};
+    Order ask3{"6", OrderType::GoodTillCancel, Side::Sell, 10.1, 200};
+
+    // no continuous matching while the book is crossed
+    EXPECT_TRUE(orderBook.addOrder(&bid1).empty());
+    EXPECT_TRUE(orderBook.addOrder(&bid2).empty());
+    EXPECT_TRUE(orderBook.addOrder(&bid3).empty());
+    EXPECT_TRUE(orderBook.addOrder(&ask1).empty());
+    EXPECT_TRUE(orderBook.addOrder(&ask2).empty());
+    EXPECT_TRUE(orderBook.addOrder(&ask3).empty());
+    EXPECT_EQ(orderBook.getBestBid()->getOrderId(), "1");
+    EXPECT_EQ(orderBook.getBestAsk()->getOrderId(), "4");
+
+    // 10.0 and 10.1 both execute 300, 10.1 has the smaller imbalance
+    UncrossInfo info = orderBook.getIndicativeUncross();
+    EXPECT_EQ(info.price_, 10.1);
+    EXPECT_EQ(info.volume_, 300);
+    EXPECT_EQ(info.imbalance_, -200);
+
+    Trades trades = orderBook.uncross();
+    EXPECT_EQ(orderBook.getTradingMode(), TradingMode::Continuous);
+
+    Quantity volume = 0;
+    for (const auto &trade : trades) {
+        EXPECT_EQ(trade.bidTrade_.price_, 10.1);
+        EXPECT_EQ(trade.askTrade_.price_, 10.1);
+        volume += trade.bidTrade_.quantity_;
+    }
+    EXPECT_EQ(volume, 300);
+
+    ASSERT_FALSE(orderBook.isBidEmpty());
+    ASSERT_FALSE(orderBook.isAskEmpty());
+    EXPECT_EQ(orderBook.getBestBid()->getOrderId(), "3");
+    EXPECT_EQ(orderBook.getBestBid()->getRemainingQuantity(), 300);
+    EXPECT_EQ(orderBook.getBestAsk()->getOrderId(), "6");
+    EXPECT_EQ(orderBook.getBestAsk()->getRemainingQuantity(), 200);
+
+    // continuous matching resumes
+    Order bid4{"7", OrderType::GoodTillCancel, Side::Buy, 10.1, 50};
+    trades = orderBook.addOrder(&bid4);
+    ASSERT_EQ(trades.size(), 1);
+    EXPECT_EQ(trades[0].askTrade_.orderId_, "6");
+}
+
+TYPED_TEST(AuctionTest, NoCross) {
+    TypeParam orderBook;
+    orderBook.startAuction();
+
+    Order bid{"1", OrderType::GoodTillCancel, Side::Buy, 10.0, 100};
+    Order ask{"2", OrderType::GoodTillCancel, Side::Sell, 10.5, 100};
+    Order fak{"3", OrderType::FillAndKill, Side::Sell, 9.0, 100};
+    orderBook.addOrder(&bid);
+    orderBook.addOrder(&ask);
+
+    // immediate orders are rejected during the auction
+    EXPECT_TRUE(orderBook.addOrder(&fak).empty());
+    EXPECT_EQ(orderBook.getBestAsk()->getOrderId(), "2");
+
+    UncrossInfo info = orderBook.getIndicativeUncross();
+    EXPECT_EQ(info.volume_, 0);
+
+    EXPECT_TRUE(orderBook.uncross().empty());
+    EXPECT_EQ(orderBook.getTradingMode(), TradingMode::Continuous);
+    EXPECT_EQ(orderBook.getBestBid()->getOrderId(), "1");
+    EXPECT_EQ(orderBook.getBestAsk()->getOrderId(), "2");
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "book/bbo.h"
+
+#include <gtest/gtest.h>
+
+#include "book/book_l2_map.hpp"
+#include "book/book_l2_vector.hpp"
+#include "book/book_l3_map.hpp"
+#include "book/book_l3_vector.hpp"
+
+template <typename T>
+class BestBidOfferTest : public ::testing::Test {};
+
+using L2BookTypes = ::testing::Types<MapBasedL2OrderBook, VectorBasedL2OrderBook<>,
+                                     VectorBasedL2OrderBook<BranchlessBinaryLevelSearcher>>;
+
+TYPED_TEST_SUITE(BestBidOfferTest, L2BookTypes);
+
+TYPED_TEST(BestBidOfferTest, TopOfBook) {
+    TypeParam book;
+    BestBidOffer bbo = book.getBestBidOffer();
+    EXPECT_FALSE(bbo.hasBid());
+    EXPECT_FALSE(bbo.hasAsk());
+
+    Order bid1{"1", OrderType::GoodTillCancel, Side::Buy, 100.0, 10};
+    Order bid2{"2", OrderType::GoodTillCancel, Side::Buy, 100.0, 20};
+    Order bid3{"3", OrderType::GoodTillCancel, Side::Buy, 99.0, 30};
+    Order ask1{"4", OrderType::GoodTillCancel, Side::Sell, 101.0, 40};
+
+    book.addOrder(&bid1);
+    book.addOrder(&bid2);
+    book.addOrder(&ask1);
+    bbo = book.getBestBidOffer();
+    EXPECT_EQ(bbo.bidPrice_, 100.0);
+    EXPECT_EQ(bbo.bidQuantity_, 30);
+    EXPECT_EQ(bbo.bidCount_, 2);
+    EXPECT_EQ(bbo.askPrice_, 101.0);
+    EXPECT_EQ(bbo.askQuantity_, 40);
+    EXPECT_EQ(bbo.askCount_, 1);
+    EXPECT_EQ(bbo.sequence_, book.getTopOfBookSequence());
+
+    // deep book event does not touch the top of book
+    uint64_t sequence = book.getTopOfBookSequence();
+    book.addOrder(&bid3);
+    EXPECT_EQ(book.getTopOfBookSequence(), sequence);
+
+    book.cancelOrder(&bid1);
+    EXPECT_NE(book.getTopOfBookSequence(), sequence);
+    bbo = book.getBestBidOffer();
+    EXPECT_EQ(bbo.bidQuantity_, 20);
+    EXPECT_EQ(bbo.bidCount_, 1);
+
+    // the next level becomes the best
+    book.cancelOrder(&bid2);
+    bbo = book.getBestBidOffer();
+    EXPECT_EQ(bbo.bidPrice_, 99.0);
+    EXPECT_EQ(bbo.bidQuantity_, 30);
+    EXPECT_EQ(bbo.bidCount_, 1);
+
+    book.cancelOrder(&bid3);
+    book.cancelOrder(&ask1);
+    bbo = book.getBestBidOffer();
+    EXPECT_FALSE(bbo.hasBid());
+    EXPECT_FALSE(bbo.hasAsk());
+}
+
+TEST(BestBidOfferTest, L3Book) {
+    VectorBasedL3OrderBook<std::list<Order *>> orderBook;
+
+    Order bid1{"1", OrderType::GoodTillCancel, Side::Buy, 10.0, 100};
+    Order bid2{"2", OrderType::GoodTillCancel, Side::Buy, 10.0, 100};
+    Order ask1{"3", OrderType::GoodTillCancel, Side::Sell, 10.0, 150};
+    orderBook.addOrder(&bid1);
+    orderBook.addOrder(&bid2);
+    orderBook.addOrder(&ask1);
+
+    // the first bid is filled and leaves the level
+    BestBidOffer bbo = orderBook.getL2Book().getBestBidOffer();
+    EXPECT_EQ(bbo.bidPrice_, 10.0);
+    EXPECT_EQ(bbo.bidQuantity_, 50);
+    EXPECT_EQ(bbo.bidCount_, 1);
+    EXPECT_FALSE(bbo.hasAsk());
+}
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <list>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "book/book_l3_map.hpp"
+#include "concurrency/epoch.hpp"
+
+namespace {
+
+using ArenaL2Book = BasicMapBasedL2OrderBook<ArenaBookAllocator>;
+using Book = MapBasedL3OrderBook<std::pmr::list<Order *>, ArenaL2Book, PriceTimeAllocation,
+                                 ArenaBookAllocator>;
+
+// the matching thread's memory, in destruction order from the bottom
+struct ReadableBook {
+    BookArena arena_;
+    LocalOrderPool pool_;
+    EpochDomain domain_;
+    EpochResource resource_{domain_, arena_.resource()};
+    Book book_{ArenaBookAllocator{&resource_}};
+
+    ReadableBook() { book_.setEpochDomain(&resource_); }
+
+    void add(int id, Side side, Price price) {
+        Order *order = pool_.allocate(std::to_string(id), OrderType::GoodTillCancel, side,
+                                      price, Quantity{10});
+        ASSERT_TRUE(book_.addOrder(order).empty());
+        orders_[id] = order;
+    }
+
+    // the order goes back to the pool once no reader can see it
+    void cancel(int id) {
+        Order *order = orders_.extract(id).mapped();
+        book_.cancelOrder(order->getOrderId());
+        domain_.retire(pool_, order);
+    }
+
+    std::unordered_map<int, Order *> orders_;
+
+    EpochDomain::Reader reader_{domain_.registerReader()};
+};
+
+}  // namespace
+
+TEST(BookConcurrentReadTest, ReadOrders) {
+    ReadableBook readable;
+    readable.add(0, Side::Buy, 99.0);
+    readable.add(1, Side::Buy, 100.0);
+    readable.add(2, Side::Buy, 100.0);
+    readable.add(3, Side::Sell, 101.0);
+
+    std::vector<std::string> ids;
+    EpochDomain::Guard guard{readable.reader_};
+    EXPECT_TRUE(readable.book_.readOrders(guard, Side::Buy, [&](Price price, const Order &o) {
+        EXPECT_EQ(price, o.getPrice());
+        ids.push_back(o.getOrderId());
+        return true;
+    }));
+    // best level first, time priority within
+    EXPECT_EQ(ids, (std::vector<std::string>{"1", "2", "0"}));
+
+    // stopping early
+    ids.clear();
+    EXPECT_TRUE(readable.book_.readOrders(guard, Side::Sell, [&](Price, const Order &o) {
+        ids.push_back(o.getOrderId());
+        return false;
+    }));
+    EXPECT_EQ(ids, (std::vector<std::string>{"3"}));
+}
+
+TEST(BookConcurrentReadTest, BookResourceOnly) {
+    // nodes of its own arena are freed at once, readers cannot follow
+    EpochDomain domain;
+    BookArena arena;
+    EpochResource resource{domain, arena.resource()};
+    Book book;
+    EXPECT_THROW(book.setEpochDomain(&resource), std::invalid_argument);
+    EXPECT_NO_THROW(book.setEpochDomain(nullptr));
+}
+
+TEST(BookConcurrentReadTest, ModifiedWhileReading) {
+    ReadableBook readable;
+    readable.add(0, Side::Buy, 100.0);
+
+    auto reader = readable.domain_.registerReader();
+    EpochDomain::Guard guard{reader};
+    readable.add(1, Side::Buy, 99.0);
+    EXPECT_FALSE(readable.book_.readOrders(guard, Side::Buy, [](Price, const Order &) {
+        return true;
+    }));
+
+    // the removed order and its nodes stay valid for the guard
+    readable.cancel(0);
+    EXPECT_EQ(readable.domain_.reclaim(), 0);
+    EXPECT_GT(readable.domain_.retired_count(), 0);
+}
+
+TEST(BookConcurrentReadTest, ConcurrentReader) {
+    constexpr int LIVE = 32;
+    constexpr int CYCLES = 5000;
+    ReadableBook readable;
+    for (int i = 0; i < LIVE; i++) {
+        readable.add(i, Side::Buy, 100.0 - i % 8);
+    }
+
+    std::atomic<bool> done{false};
+    int consistent = 0;
+    bool valid = true;
+    std::thread reader{[&] {
+        auto handle = readable.domain_.registerReader();
+        while (!done.load(std::memory_order_acquire)) {
+            EpochDomain::Guard guard{handle};
+            int count = 0;
+            bool pricesMatch = true;
+            bool read = readable.book_.readOrders(guard, Side::Buy,
+                                                  [&](Price price, const Order &o) {
+                                                      pricesMatch &= price == o.getPrice();
+                                                      count++;
+                                                      return true;
+                                                  });
+            if (read) {
+                // between two commands the book holds LIVE or LIVE + 1 orders
+                valid &= pricesMatch && (count == LIVE || count == LIVE + 1);
+                consistent++;
+            }
+            std::this_thread::yield();
+        }
+    }};
+
+    // add one, cancel the oldest
+    for (int i = LIVE; i < LIVE + CYCLES; i++) {
+        readable.add(i, Side::Buy, 100.0 - i % 8);
+        readable.cancel(i - LIVE);
+        if (i % 64 == 0) {
+            std::this_thread::yield();
+        }
+    }
+    done.store(true, std::memory_order_release);
+    reader.join();
+
+    EXPECT_TRUE(valid);
+    EXPECT_GT(consistent, 0);
+    for (int i = CYCLES; i < LIVE + CYCLES; i++) {
+        readable.cancel(i);
+    }
+    EXPECT_TRUE(readable.book_.isBidEmpty());
+}
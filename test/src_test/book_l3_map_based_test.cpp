@@ -397,4 +397,28 @@ TEST(MapBasedL3OrderBookTest, MultiSetLevelMatch) {
     ASSERT_EQ(bid->getFilledQuantity(), 50);
     ASSERT_EQ(bid->getInitialQuantity(), 100);
     ASSERT_EQ(bid->getOrderId(), "3");
+}
+
+TEST(MapBasedL3OrderBookTest, FillOrKill) {
+    MapBasedL3OrderBook<std::list<Order *>> orderBook;
+
+    Order order1{"1", OrderType::GoodTillCancel, Side::Sell, 10.0, 100};
+    Order order2{"2", OrderType::GoodTillCancel, Side::Sell, 11.0, 100};
+    Order order3{"3", OrderType::GoodTillCancel, Side::Sell, 12.0, 100};
+    orderBook.addOrder(&order1);
+    orderBook.addOrder(&order2);
+    orderBook.addOrder(&order3);
+
+    // only 200 available at or below 11.0
+    Order order4{"4", OrderType::FillOrKill, Side::Buy, 11.0, 250};
+    ASSERT_TRUE(orderBook.addOrder(&order4).empty());
+    ASSERT_EQ(orderBook.getBestAsk()->getOrderId(), "1");
+
+    Order order5{"5", OrderType::FillOrKill, Side::Buy, 11.0, 150};
+    Trades trades = orderBook.addOrder(&order5);
+    ASSERT_EQ(trades.size(), 2);
+    ASSERT_EQ(trades[0].askTrade_.orderId_, "1");
+    ASSERT_EQ(trades[1].askTrade_.orderId_, "2");
+    ASSERT_EQ(trades[1].askTrade_.quantity_, 50);
+    ASSERT_TRUE(orderBook.isBidEmpty());
 }
\ No newline at end of file
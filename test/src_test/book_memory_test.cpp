@@ -0,0 +1,185 @@
+#include "book/book_memory.hpp"
+
+#include <gtest/gtest.h>
+
+#include <list>
+#include <memory_resource>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "book/book_l3_map.hpp"
+#include "book/book_l3_vector.hpp"
+
+using ArenaL2Book = BasicMapBasedL2OrderBook<ArenaBookAllocator>;
+
+template <typename T>
+class ArenaL3OrderBookTest : public ::testing::Test {};
+
+using ArenaTypes = ::testing::Types<
+    MapBasedL3OrderBook<std::pmr::list<Order *>, ArenaL2Book, PriceTimeAllocation,
+                        ArenaBookAllocator>,
+    MapBasedL3OrderBook<std::pmr::set<Order *, OrderCompare>, ArenaL2Book,
+                        PriceTimeAllocation, ArenaBookAllocator>,
+    VectorBasedL3OrderBook<std::pmr::list<Order *>, BinaryLevelSearcher,
+                           VectorBasedL2OrderBook<BinaryLevelSearcher, 1024, ArenaBookAllocator>,
+                           1024, PriceTimeAllocation, ArenaBookAllocator>>;
+
+TYPED_TEST_SUITE(ArenaL3OrderBookTest, ArenaTypes);
+
+TYPED_TEST(ArenaL3OrderBookTest, NodesFromArena) {
+    PageProvider provider;
+    PageProvider::Scope scope{provider};
+
+    {
+        TypeParam orderBook;
+        size_t initial = provider.mapped_bytes();
+
+        std::vector<Order> orders;
+        orders.reserve(200);
+        for (int i = 0; i < 100; i++) {
+            orders.emplace_back(std::to_string(i), OrderType::GoodTillCancel, Side::Buy,
+                                100.0 - i % 10, 10);
+        }
+        for (int i = 100; i < 200; i++) {
+            orders.emplace_back(std::to_string(i), OrderType::GoodTillCancel, Side::Sell,
+                                101.0 + i % 10, 10);
+        }
+        for (auto &order : orders) {
+            ASSERT_TRUE(orderBook.addOrder(&order).empty());
+        }
+        // levels, index and level containers grew the arena
+        EXPECT_GT(provider.mapped_bytes(), initial);
+        EXPECT_EQ(orderBook.getOrderCount(), 200);
+        EXPECT_EQ(orderBook.getBestBid()->getOrderId(), "0");
+        EXPECT_EQ(orderBook.getL2Book().getBestBidOffer().bidQuantity_, 100);
+
+        Order taker{"taker", OrderType::GoodTillCancel, Side::Sell, 99.0, 250};
+        Trades trades = orderBook.addOrder(&taker);
+        ASSERT_EQ(trades.size(), 20);
+        EXPECT_EQ(orderBook.getOrderCount(), 180 + 1);
+
+        // the taker filled the 100.0 and 99.0 levels
+        for (int i = 0; i < 100; i++) {
+            if (i % 10 >= 2) {
+                orderBook.cancelOrder(std::to_string(i));
+            }
+        }
+        EXPECT_TRUE(orderBook.isBidEmpty());
+    }
+    // everything went back with the arena
+    EXPECT_EQ(provider.mapped_bytes(), 0);
+}
+
+TEST(BookMemoryTest, SharedArena) {
+    PageProvider provider;
+    BookArena arena{provider};
+    ArenaBookAllocator allocator{arena.resource()};
+
+    MapBasedL3OrderBook<std::pmr::list<Order *>, ArenaL2Book, PriceTimeAllocation,
+                        ArenaBookAllocator>
+        book1{allocator};
+    MapBasedL3OrderBook<std::pmr::list<Order *>, ArenaL2Book, PriceTimeAllocation,
+                        ArenaBookAllocator>
+        book2{allocator};
+    EXPECT_EQ(book1.get_allocator(), book2.get_allocator());
+    EXPECT_EQ(book1.getL2Book().get_allocator(), allocator);
+
+    Order bid{"1", OrderType::GoodTillCancel, Side::Buy, 10.0, 100};
+    Order ask{"2", OrderType::GoodTillCancel, Side::Sell, 11.0, 100};
+    book1.addOrder(&bid);
+    book2.addOrder(&ask);
+    EXPECT_GT(provider.mapped_bytes(), 0);
+    EXPECT_EQ(book1.getBestBid()->getOrderId(), "1");
+    EXPECT_EQ(book2.getBestAsk()->getOrderId(), "2");
+}
+
+TEST(BookMemoryTest, DefaultAllocator) {
+    PageProvider provider;
+    PageProvider::Scope scope{provider};
+
+    // level vectors are reserved in pages of the current provider
+    VectorBasedL2OrderBook<> book;
+    EXPECT_EQ(&book.get_allocator().provider(), &provider);
+    EXPECT_GE(provider.mapped_bytes(), 2 * 65536 * sizeof(L2LevelInfo));
+}
+
+TEST(BookMemoryTest, MemoryUsage) {
+    // the reserved levels count from the start
+    VectorBasedL2OrderBook<> vectorL2;
+    EXPECT_EQ(vectorL2.memoryUsage().levels_, 2 * 65536 * sizeof(L2LevelInfo));
+    EXPECT_EQ(vectorL2.memoryUsage().arena_, 0);
+
+    MapBasedL3OrderBook<std::list<Order *>> book;
+    BookMemoryUsage empty = book.memoryUsage();
+    EXPECT_EQ(empty.levels_, 0);
+    EXPECT_EQ(empty.levelContainers_, 0);
+
+    std::vector<Order> orders;
+    for (int i = 0; i < 100; i++) {
+        orders.emplace_back(std::to_string(i), OrderType::GoodTillCancel, Side::Buy,
+                            100.0 - i % 10, 10);
+    }
+    for (auto &order : orders) {
+        book.addOrder(&order);
+    }
+    using LevelMap = std::map<Price, std::list<Order *>>;
+    BookMemoryUsage full = book.memoryUsage();
+    EXPECT_EQ(full.levels_, 10 * nodeBytes<LevelMap>());
+    EXPECT_EQ(full.levelContainers_, 100 * nodeBytes<std::list<Order *>>());
+    EXPECT_GE(full.orderIndex_, 100 * sizeof(OrderId));
+    EXPECT_GT(full.priceIndex_, 0);
+    EXPECT_EQ(full.l2Mirror_, book.getL2Book().memoryUsage().total());
+    EXPECT_GT(full.l2Mirror_, 0);
+
+    for (auto &order : orders) {
+        book.cancelOrder(order.getOrderId());
+    }
+    // the index keeps its buckets after a busy session
+    BookMemoryUsage drained = book.memoryUsage();
+    EXPECT_EQ(drained.levels_, 0);
+    EXPECT_EQ(drained.levelContainers_, 0);
+    EXPECT_GE(drained.orderIndex_, empty.orderIndex_);
+}
+
+TEST(BookMemoryTest, MemoryReport) {
+    PageProvider provider;
+    PageProvider::Scope scope{provider};
+
+    MapBasedL3OrderBook<std::pmr::list<Order *>, ArenaL2Book, PriceTimeAllocation,
+                        ArenaBookAllocator>
+        small;
+    MapBasedL3OrderBook<std::list<Order *>, VectorBasedL2OrderBook<>> large;
+
+    Order bid{"1", OrderType::GoodTillCancel, Side::Buy, 10.0, 100};
+    small.addOrder(&bid);
+    EXPECT_GT(small.memoryUsage().arena_, 0);
+    EXPECT_EQ(large.memoryUsage().arena_, 0);
+
+    ObjectPool<Order, 64, PoolMapDefault, DefaultPoolTracking, SingleOwnerMutex> pool{provider};
+    Order *order = pool.allocate("2", OrderType::GoodTillCancel, Side::Sell, 11.0, 100);
+    EXPECT_GT(pool.used_bytes(), sizeof(Order) - 1);
+
+    MemoryReport report;
+    report.addBook("SMALL", small);
+    report.addBook("LARGE", large);
+    report.addPool("orders", pool);
+
+    EXPECT_EQ(report.bookTotal().total(),
+              small.memoryUsage().total() + large.memoryUsage().total());
+    EXPECT_EQ(report.poolMappedBytes(), pool.mapped_bytes());
+    EXPECT_EQ(report.total(), report.bookTotal().total() + pool.mapped_bytes());
+
+    auto largest = report.largestBooks(1);
+    ASSERT_EQ(largest.size(), 1);
+    EXPECT_EQ(largest[0].name_, "LARGE");
+
+    std::ostringstream os;
+    report.print(os);
+    EXPECT_NE(os.str().find("LARGE"), std::string::npos);
+    EXPECT_NE(os.str().find("pool orders"), std::string::npos);
+
+    pool.deallocate(order);
+    EXPECT_EQ(pool.used_bytes(), 0);
+}
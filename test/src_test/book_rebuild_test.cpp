@@ -0,0 +1,177 @@
+#include "book/book_rebuild.hpp"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <list>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "book/book_l3_map.hpp"
+
+namespace {
+
+using Book = MapBasedL3OrderBook<std::list<Order *>>;
+
+// a day of adds, cancels and modifies over symbols of skewed activity,
+// orders cross often enough to trade
+std::vector<OrderEvent> makeEvents(size_t count, size_t symbols) {
+    std::mt19937 rng{7};
+    std::vector<OrderEvent> events;
+    std::vector<std::vector<std::string>> resting(symbols);
+    int nextId = 0;
+    for (size_t i = 0; i < count; i++) {
+        // symbol k is picked about twice as often as symbol k + 1
+        size_t s = 0;
+        while (s + 1 < symbols && rng() % 2 == 0) {
+            s++;
+        }
+        std::string symbol = "SYM" + std::to_string(s);
+        auto &ids = resting[s];
+
+        unsigned action = rng() % 10;
+        if (action < 6 || ids.empty()) {
+            std::string id = std::to_string(nextId++);
+            Side side = rng() % 2 ? Side::Buy : Side::Sell;
+            Price price = 100.0 + static_cast<int>(rng() % 11) - 5;
+            Order order{id, OrderType::GoodTillCancel, side, price,
+                        static_cast<Quantity>(1 + rng() % 20)};
+            events.push_back(OrderEvent::add(symbol, order));
+            ids.push_back(id);
+        } else {
+            size_t pick = rng() % ids.size();
+            if (action < 9) {
+                events.push_back(OrderEvent::cancel(symbol, ids[pick]));
+                ids.erase(ids.begin() + pick);
+            } else {
+                Side side = rng() % 2 ? Side::Buy : Side::Sell;
+                events.push_back(OrderEvent::modify(
+                    symbol, ids[pick],
+                    OrderModify{side, 100.0 + static_cast<int>(rng() % 5) - 2, 5}));
+            }
+        }
+    }
+    return events;
+}
+
+// one thread, one book at a time, as before
+struct SequentialReplay {
+    std::vector<std::unique_ptr<Order>> orders_;
+    std::unordered_map<std::string, Book> books_;
+
+    explicit SequentialReplay(const std::vector<OrderEvent> &events) {
+        for (const OrderEvent &event : events) {
+            Book &book = books_[std::string{event.symbol()}];
+            OrderId id{event.orderId()};
+            if (event.type_ == CommandType::Add) {
+                orders_.push_back(std::make_unique<Order>(id, event.orderType(), event.side_,
+                                                          event.price_, event.quantity_));
+                book.addOrder(orders_.back().get());
+            } else if (event.type_ == CommandType::Cancel) {
+                book.cancelOrder(id);
+            } else {
+                book.modifyOrder(id, event.getModify());
+            }
+        }
+    }
+};
+
+void expectSameBook(Book &rebuilt, Book &expected) {
+    ASSERT_EQ(rebuilt.getOrderCount(), expected.getOrderCount());
+    ASSERT_EQ(rebuilt.isBidEmpty(), expected.isBidEmpty());
+    ASSERT_EQ(rebuilt.isAskEmpty(), expected.isAskEmpty());
+    if (!expected.isBidEmpty()) {
+        EXPECT_EQ(rebuilt.getBestBid()->getOrderId(), expected.getBestBid()->getOrderId());
+        EXPECT_EQ(rebuilt.getBestBid()->getRemainingQuantity(),
+                  expected.getBestBid()->getRemainingQuantity());
+    }
+    if (!expected.isAskEmpty()) {
+        EXPECT_EQ(rebuilt.getBestAsk()->getOrderId(), expected.getBestAsk()->getOrderId());
+    }
+    const BestBidOffer rebuiltBbo = rebuilt.getL2Book().getBestBidOffer();
+    const BestBidOffer expectedBbo = expected.getL2Book().getBestBidOffer();
+    EXPECT_EQ(rebuiltBbo.bidQuantity_, expectedBbo.bidQuantity_);
+    EXPECT_EQ(rebuiltBbo.askQuantity_, expectedBbo.askQuantity_);
+}
+
+}  // namespace
+
+TEST(BookRebuildTest, EventLayout) {
+    Order order{"order-1", OrderType::FillAndKill, Side::Sell, 101.5, 30};
+    OrderEvent add = OrderEvent::add("AAPL", order);
+    EXPECT_EQ(add.symbol(), "AAPL");
+    EXPECT_EQ(add.orderId(), "order-1");
+    EXPECT_EQ(add.orderType(), OrderType::FillAndKill);
+    EXPECT_EQ(add.side_, Side::Sell);
+    EXPECT_EQ(add.quantity_, 30);
+
+    // cut at the field size
+    OrderEvent cancel = OrderEvent::cancel("A_VERY_LONG_SYMBOL_NAME", "1");
+    EXPECT_EQ(cancel.symbol(), "A_VERY_LONG_SYMB");
+    EXPECT_EQ(cancel.type_, CommandType::Cancel);
+}
+
+TEST(BookRebuildTest, Assignment) {
+    BookRebuilder<Book> rebuilder{2};
+    StringViewMap<size_t> counts{{"A", 100}, {"B", 40}, {"C", 30}, {"D", 20}};
+    auto assignment = rebuilder.assign(counts);
+    // the busiest symbol alone, the others share the second worker
+    EXPECT_NE(assignment.find("A")->second, assignment.find("B")->second);
+    EXPECT_EQ(assignment.find("B")->second, assignment.find("C")->second);
+    EXPECT_EQ(assignment.find("C")->second, assignment.find("D")->second);
+}
+
+TEST(BookRebuildTest, MatchesSequentialReplay) {
+    std::vector<OrderEvent> events = makeEvents(20000, 8);
+    SequentialReplay expected{events};
+
+    BookRebuilder<Book, 256> rebuilder{3};
+    auto result = rebuilder.rebuild(events);
+    EXPECT_EQ(result.events_, events.size());
+    ASSERT_EQ(result.shards_.size(), 3);
+    EXPECT_EQ(result.book_count(), expected.books_.size());
+
+    size_t applied = 0;
+    for (const auto &shard : result.shards_) {
+        applied += shard->events_;
+        // only resting orders are kept
+        size_t resting = 0;
+        for (const auto &[symbol, book] : shard->books_) {
+            resting += book->getOrderCount();
+        }
+        EXPECT_EQ(shard->orders_.size(), resting);
+    }
+    EXPECT_EQ(applied, events.size());
+
+    for (auto &[symbol, book] : expected.books_) {
+        Book *rebuilt = result.find(symbol);
+        ASSERT_NE(rebuilt, nullptr);
+        expectSameBook(*rebuilt, book);
+    }
+}
+
+TEST(BookRebuildTest, FromLogFile) {
+    std::vector<OrderEvent> events = makeEvents(5000, 4);
+    std::string path = "/tmp/book_rebuild_test_" + std::to_string(getpid()) + ".log";
+    {
+        EventLogWriter writer{path};
+        for (const OrderEvent &event : events) {
+            writer.append(event);
+        }
+    }
+
+    SequentialReplay expected{events};
+    BookRebuilder<Book> rebuilder{2};
+    auto result = rebuilder.rebuild(path);
+    std::remove(path.c_str());
+
+    EXPECT_EQ(result.events_, events.size());
+    for (auto &[symbol, book] : expected.books_) {
+        Book *rebuilt = result.find(symbol);
+        ASSERT_NE(rebuilt, nullptr);
+        expectSameBook(*rebuilt, book);
+    }
+    EXPECT_THROW(rebuilder.rebuild(path), std::system_error);
+}
@@ -0,0 +1,285 @@
+#include "book/command_journal.hpp"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "book/book_l3_map.hpp"
+#include "book/book_rebuild.hpp"
+
+namespace {
+
+using Book = MapBasedL3OrderBook<std::list<Order *>>;
+using Journal = CommandJournal<64>;
+
+std::string tempPath() { return "/tmp/command_journal_test_" + std::to_string(getpid()); }
+
+std::vector<OrderEvent> readLog(const std::string &path) {
+    EventLogReader reader{path};
+    std::vector<OrderEvent> events(1 << 16);
+    events.resize(reader.read(events.data(), events.size()));
+    return events;
+}
+
+JournalConfig testConfig() {
+    JournalConfig config;
+    config.idle_ = std::chrono::microseconds{20};
+    config.window_ = 4096;
+    return config;
+}
+
+RunnerConfig runnerConfig(size_t shards) {
+    RunnerConfig config;
+    config.cores_.assign(shards, -1);
+    config.idle_.spins_ = 16;
+    config.idle_.yields_ = 16;
+    config.stackPrefaultBytes_ = 64 << 10;
+    return config;
+}
+
+}  // namespace
+
+TEST(CommandJournalTest, JournalsEngineCommands) {
+    std::string path = tempPath();
+    std::remove(path.c_str());
+
+    Book books[3];
+    const char *symbols[] = {"AAPL", "MSFT", "IBM"};
+    std::vector<Order> orders;
+    orders.reserve(600);
+    {
+        Journal journal{path, testConfig()};
+        Journal::Producer *producers[] = {&journal.addProducer(), &journal.addProducer()};
+        JournalingHandler<Book, Journal> handler;
+        EngineRunner<Book, JournalingHandler<Book, Journal>, 64> runner{runnerConfig(2), handler};
+        std::vector<EngineRunner<Book, JournalingHandler<Book, Journal>, 64>::InputQueue *> queues;
+        for (int b = 0; b < 3; b++) {
+            handler.add(books[b], symbols[b], *producers[b % 2]);
+            queues.push_back(&runner.attach(b % 2, books[b]));
+        }
+        journal.start();
+        runner.start();
+
+        auto push = [&](int b, const BookCommand &command) {
+            while (!queues[b]->emplace(command)) {
+                std::this_thread::yield();
+            }
+        };
+        for (int i = 0; i < 600; i++) {
+            Side side = i % 2 ? Side::Buy : Side::Sell;
+            orders.emplace_back(std::to_string(i), OrderType::GoodTillCancel, side,
+                                100.0 + i % 7 - 3, 1 + i % 10);
+            push(i % 3, BookCommand::add(&orders.back()));
+            if (i % 5 == 4) {
+                push((i - 3) % 3, BookCommand::cancel(&orders[i - 3]));
+            }
+            if (i % 11 == 10) {
+                push((i - 1) % 3, BookCommand::modify(&orders[i - 1],
+                                                      OrderModify{Side::Buy, 99.0, 5}));
+            }
+        }
+        runner.stop();
+        journal.stop();
+
+        EXPECT_EQ(producers[0]->durable(), producers[0]->appended());
+        EXPECT_EQ(producers[1]->durable(), producers[1]->appended());
+        EXPECT_EQ(producers[0]->appended() + producers[1]->appended(), 600 + 120 + 54);
+        EXPECT_EQ(handler.sequence(books[0]) + handler.sequence(books[1]) +
+                      handler.sequence(books[2]),
+                  600 + 120 + 54);
+        JournalStats stats = journal.stats();
+        EXPECT_LE(stats.records_, 600 + 120 + 54);
+        EXPECT_LE(stats.commits_, stats.records_);
+    }
+
+    // intact, consecutive per book
+    std::vector<OrderEvent> events = readLog(path);
+    ASSERT_EQ(events.size(), 600 + 120 + 54);
+    std::map<std::string, uint64_t> sequences;
+    for (const OrderEvent &event : events) {
+        EXPECT_TRUE(event.intact());
+        EXPECT_EQ(event.sequence_, ++sequences[std::string{event.symbol()}]);
+    }
+
+    // replays into the same books
+    BookRebuilder<Book> rebuilder{2};
+    auto result = rebuilder.rebuild(path);
+    for (int b = 0; b < 3; b++) {
+        Book *rebuilt = result.find(symbols[b]);
+        ASSERT_NE(rebuilt, nullptr);
+        EXPECT_EQ(rebuilt->getOrderCount(), books[b].getOrderCount());
+        if (!books[b].isBidEmpty()) {
+            EXPECT_EQ(rebuilt->getBestBid()->getOrderId(), books[b].getBestBid()->getOrderId());
+        }
+    }
+    std::remove(path.c_str());
+}
+
+TEST(CommandJournalTest, SpillsWithoutBlocking) {
+    std::string path = tempPath();
+    std::remove(path.c_str());
+    {
+        Journal journal{path, testConfig()};
+        Journal::Producer &producer = journal.addProducer();
+        Order order{"1", OrderType::GoodTillCancel, Side::Buy, 100.0, 10};
+        // no writer yet, the queue fills and the rest spills
+        for (int i = 0; i < 200; i++) {
+            OrderEvent event = OrderEvent::add("AAPL", order);
+            event.sequence_ = i + 1;
+            producer.append(event);
+        }
+        EXPECT_EQ(producer.appended(), 200);
+        EXPECT_EQ(producer.spilled(), 200 - 64);
+        EXPECT_EQ(producer.durable(), 0);
+
+        journal.start();
+        while (producer.durable() < 64) {
+            std::this_thread::yield();
+        }
+        // pushes some on, stop() writes the rest
+        EXPECT_FALSE(producer.flush());
+        journal.stop();
+        EXPECT_EQ(producer.durable(), 200);
+    }
+    std::vector<OrderEvent> events = readLog(path);
+    ASSERT_EQ(events.size(), 200);
+    for (size_t i = 0; i < events.size(); i++) {
+        EXPECT_EQ(events[i].sequence_, i + 1);
+    }
+    std::remove(path.c_str());
+}
+
+TEST(CommandJournalTest, DropsPastSpillBuffer) {
+    std::string path = tempPath();
+    std::remove(path.c_str());
+    {
+        JournalConfig config = testConfig();
+        config.spillRecords_ = 16;
+        Journal journal{path, config};
+        Journal::Producer &producer = journal.addProducer();
+        Order order{"1", OrderType::GoodTillCancel, Side::Buy, 100.0, 10};
+        // no writer yet, the queue and the spill buffer fill, the rest is
+        // refused
+        for (int i = 0; i < 100; i++) {
+            OrderEvent event = OrderEvent::add("AAPL", order);
+            event.sequence_ = i + 1;
+            EXPECT_EQ(producer.append(event), i < 64 + 16);
+        }
+        EXPECT_EQ(producer.appended(), 64 + 16);
+        EXPECT_EQ(producer.spilled(), 16);
+        EXPECT_EQ(producer.dropped(), 100 - 64 - 16);
+
+        journal.start();
+        journal.stop();
+        EXPECT_EQ(producer.durable(), 64 + 16);
+    }
+    std::vector<OrderEvent> events = readLog(path);
+    ASSERT_EQ(events.size(), 64 + 16);
+    for (size_t i = 0; i < events.size(); i++) {
+        EXPECT_EQ(events[i].sequence_, i + 1);
+    }
+    std::remove(path.c_str());
+}
+
+TEST(CommandJournalTest, FlushesWhenIdle) {
+    std::string path = tempPath();
+    std::remove(path.c_str());
+    using Runner = EngineRunner<Book, JournalingHandler<Book, Journal>, 256>;
+    {
+        Journal journal{path, testConfig()};
+        Journal::Producer &producer = journal.addProducer();
+        JournalingHandler<Book, Journal> handler;
+        Book book;
+        Runner runner{runnerConfig(1), handler};
+        handler.add(book, "AAPL", producer);
+        auto &queue = runner.attach(0, book);
+        runner.start();
+
+        // a burst while the writer is not running yet, most of it spills
+        std::vector<Order> orders;
+        orders.reserve(200);
+        for (int i = 0; i < 200; i++) {
+            orders.emplace_back(std::to_string(i), OrderType::GoodTillCancel, Side::Buy, 100.0,
+                                10);
+            while (!queue.emplace(BookCommand::add(&orders.back()))) {
+                std::this_thread::yield();
+            }
+        }
+
+        while (!queue.empty()) {
+            std::this_thread::yield();
+        }
+
+        // no further command, the idle matching thread pushes the rest on
+        journal.start();
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (producer.durable() < 200 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+        EXPECT_EQ(producer.durable(), 200);
+
+        runner.stop();
+        EXPECT_EQ(producer.appended(), 200);
+        EXPECT_EQ(producer.spilled(), 200 - 64);
+        journal.stop();
+    }
+    std::vector<OrderEvent> events = readLog(path);
+    ASSERT_EQ(events.size(), 200);
+    for (size_t i = 0; i < events.size(); i++) {
+        EXPECT_EQ(events[i].sequence_, i + 1);
+    }
+    std::remove(path.c_str());
+}
+
+TEST(CommandJournalTest, RecoversTornTail) {
+    std::string path = tempPath();
+    std::remove(path.c_str());
+    EXPECT_EQ(Journal::recover(path), 0);
+
+    Order order{"1", OrderType::GoodTillCancel, Side::Sell, 101.0, 10};
+    {
+        Journal journal{path, testConfig()};
+        Journal::Producer &producer = journal.addProducer();
+        journal.start();
+        for (int i = 0; i < 10; i++) {
+            OrderEvent event = OrderEvent::add("AAPL", order);
+            event.sequence_ = i + 1;
+            producer.append(event);
+        }
+        journal.stop();
+    }
+
+    // a record never synced and half of one
+    {
+        std::ofstream out{path, std::ios::binary | std::ios::app};
+        OrderEvent zeroed;
+        out.write(reinterpret_cast<const char *>(&zeroed), sizeof(zeroed));
+        OrderEvent torn = OrderEvent::cancel("AAPL", "1");
+        out.write(reinterpret_cast<const char *>(&torn), sizeof(torn) / 2);
+    }
+
+    {
+        Journal journal{path, testConfig()};
+        EXPECT_EQ(journal.recovered(), 10);
+        Journal::Producer &producer = journal.addProducer();
+        journal.start();
+        OrderEvent event = OrderEvent::cancel("AAPL", "1");
+        event.sequence_ = 11;
+        producer.append(event);
+        journal.stop();
+    }
+    std::vector<OrderEvent> events = readLog(path);
+    ASSERT_EQ(events.size(), 11);
+    for (size_t i = 0; i < events.size(); i++) {
+        EXPECT_TRUE(events[i].intact());
+        EXPECT_EQ(events[i].sequence_, i + 1);
+    }
+    EXPECT_EQ(events.back().type_, CommandType::Cancel);
+    std::remove(path.c_str());
+}
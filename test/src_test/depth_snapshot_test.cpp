@@ -0,0 +1,133 @@
+#include "book/depth_snapshot.hpp"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "book/book_l2_map.hpp"
+#include "book/book_l2_vector.hpp"
+#include "book/book_l3_map.hpp"
+
+template <typename T>
+class DepthSnapshotTest : public ::testing::Test {};
+
+using L2BookTypes = ::testing::Types<MapBasedL2OrderBook, VectorBasedL2OrderBook<>,
+                                     VectorBasedL2OrderBook<LinearLevelSearcher>>;
+
+TYPED_TEST_SUITE(DepthSnapshotTest, L2BookTypes);
+
+TYPED_TEST(DepthSnapshotTest, TopLevels) {
+    TypeParam book;
+    Order before{"0", OrderType::GoodTillCancel, Side::Buy, 50.0, 10};
+    book.addOrder(&before);
+    book.enableDepthSnapshot();
+    const auto *publisher = book.getDepthSnapshotPublisher();
+
+    auto snapshot = publisher->read();
+    ASSERT_EQ(snapshot.bidDepth_, 1);
+    EXPECT_EQ(snapshot.bids_[0].price_, 50.0);
+
+    // 15 bid levels 100..114 and 15 ask levels 200..214
+    std::vector<Order> orders;
+    orders.reserve(30);
+    for (int i = 0; i < 15; i++) {
+        orders.emplace_back(std::to_string(i), OrderType::GoodTillCancel, Side::Buy,
+                            100.0 + i, 10 + i);
+        orders.emplace_back(std::to_string(100 + i), OrderType::GoodTillCancel,
+                            Side::Sell, 200.0 + i, 10 + i);
+    }
+    for (auto &order : orders) {
+        book.addOrder(&order);
+    }
+
+    snapshot = publisher->read();
+    ASSERT_EQ(snapshot.bidDepth_, 10);
+    ASSERT_EQ(snapshot.askDepth_, 10);
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(snapshot.bids_[i].price_, 114.0 - i);
+        EXPECT_EQ(snapshot.bids_[i].quantity_, 24 - i);
+        EXPECT_EQ(snapshot.asks_[i].price_, 200.0 + i);
+        EXPECT_EQ(snapshot.asks_[i].quantity_, 10 + i);
+    }
+
+    // changes below the top 10 are not published
+    auto sequence = snapshot.sequence_;
+    book.cancelOrder(Side::Buy, 100.0, 5);
+    book.cancelOrder(Side::Sell, 214.0, 24);
+    EXPECT_EQ(publisher->read().sequence_, sequence);
+
+    // quantity change in the top 10
+    book.cancelOrder(Side::Buy, 110.0, 5);
+    snapshot = publisher->read();
+    EXPECT_GT(snapshot.sequence_, sequence);
+    EXPECT_EQ(snapshot.bids_[4].price_, 110.0);
+    EXPECT_EQ(snapshot.bids_[4].quantity_, 15);
+
+    // removing a top level pulls the next one in from the book
+    book.cancelOrder(Side::Sell, 200.0, 10);
+    snapshot = publisher->read();
+    ASSERT_EQ(snapshot.askDepth_, 10);
+    EXPECT_EQ(snapshot.asks_[0].price_, 201.0);
+    EXPECT_EQ(snapshot.asks_[9].price_, 210.0);
+
+    // a new best level pushes the last one out
+    Order better{"x", OrderType::GoodTillCancel, Side::Buy, 120.0, 7};
+    book.addOrder(&better);
+    snapshot = publisher->read();
+    ASSERT_EQ(snapshot.bidDepth_, 10);
+    EXPECT_EQ(snapshot.bids_[0].price_, 120.0);
+    EXPECT_EQ(snapshot.bids_[1].price_, 114.0);
+    EXPECT_EQ(snapshot.bids_[9].price_, 106.0);
+}
+
+TYPED_TEST(DepthSnapshotTest, ConcurrentReader) {
+    static constexpr int ROUNDS = 2000;
+    TypeParam book;
+    book.enableDepthSnapshot();
+    const auto *publisher = book.getDepthSnapshotPublisher();
+
+    std::atomic<bool> done{false};
+    std::thread reader([&]() {
+        uint64_t lastSequence = 0;
+        while (!done.load(std::memory_order_acquire)) {
+            auto snapshot = publisher->read();
+            ASSERT_GE(snapshot.sequence_, lastSequence);
+            lastSequence = snapshot.sequence_;
+            ASSERT_LE(snapshot.bidDepth_, 10);
+            for (uint32_t i = 0; i < snapshot.bidDepth_; i++) {
+                ASSERT_EQ(snapshot.bids_[i].volume_,
+                          snapshot.bids_[i].price_ * snapshot.bids_[i].quantity_);
+                if (i > 0) {
+                    ASSERT_GT(snapshot.bids_[i - 1].price_, snapshot.bids_[i].price_);
+                }
+            }
+        }
+    });
+
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int i = 0; i < 20; i++) {
+            book.cancelOrder(Side::Buy, 100.0 + i, 1);
+            Order order{"1", OrderType::GoodTillCancel, Side::Buy, 100.0 + (i + round) % 20,
+                        round % 7 + 1};
+            book.addOrder(&order);
+        }
+    }
+    done.store(true, std::memory_order_release);
+    reader.join();
+}
+
+TEST(DepthSnapshotTest, L3Book) {
+    MapBasedL3OrderBook<std::list<Order *>> orderBook;
+    orderBook.getL2Book().enableDepthSnapshot();
+    const auto *publisher = orderBook.getL2Book().getDepthSnapshotPublisher();
+
+    Order bid{"1", OrderType::GoodTillCancel, Side::Buy, 10.0, 100};
+    Order ask{"2", OrderType::GoodTillCancel, Side::Sell, 10.0, 40};
+    orderBook.addOrder(&bid);
+    orderBook.addOrder(&ask);
+
+    auto snapshot = publisher->read();
+    ASSERT_EQ(snapshot.bidDepth_, 1);
+    EXPECT_EQ(snapshot.bids_[0].quantity_, 60);
+    EXPECT_EQ(snapshot.askDepth_, 0);
+}
\ No newline at end of file
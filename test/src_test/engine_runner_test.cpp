@@ -0,0 +1,155 @@
+#include "book/engine_runner.hpp"
+
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "book/book_l3_map.hpp"
+
+namespace {
+
+using Book = MapBasedL3OrderBook<std::list<Order *>>;
+
+// counts commands and trades, from every shard
+struct CountingHandler {
+    std::atomic<size_t> *commands_;
+    std::atomic<size_t> *trades_;
+
+    void operator()(Book &, const BookCommand &, Trades &trades) const {
+        commands_->fetch_add(1, std::memory_order_relaxed);
+        trades_->fetch_add(trades.size(), std::memory_order_relaxed);
+    }
+};
+
+RunnerConfig testConfig(size_t shards) {
+    RunnerConfig config;
+    // a single cpu may be all there is
+    config.cores_.assign(shards, 0);
+    config.idle_.spins_ = 16;
+    config.idle_.yields_ = 16;
+    config.stackPrefaultBytes_ = 64 << 10;
+    return config;
+}
+
+void push(EngineRunner<Book, CountingHandler>::InputQueue &queue, const BookCommand &command) {
+    while (!queue.emplace(command)) {
+        std::this_thread::yield();
+    }
+}
+
+}  // namespace
+
+TEST(EngineRunnerTest, DrivesBooks) {
+    std::atomic<size_t> commands{0};
+    std::atomic<size_t> trades{0};
+    EngineRunner<Book, CountingHandler> runner{testConfig(2),
+                                               CountingHandler{&commands, &trades}};
+
+    Book books[3];
+    auto &first = runner.attach(0, books[0]);
+    auto &second = runner.attach(0, books[1]);
+    auto &third = runner.attach(1, books[2]);
+    EXPECT_EQ(runner.shard_count(), 2);
+
+    runner.start();
+    EXPECT_TRUE(runner.running());
+    EXPECT_TRUE(runner.setup(0).pinned_);
+    EXPECT_FALSE(runner.setup(0).realtime_);
+    EXPECT_THROW(runner.attach(0, books[0]), std::logic_error);
+
+    std::vector<Order> orders;
+    orders.reserve(8);
+    orders.emplace_back("1", OrderType::GoodTillCancel, Side::Buy, 100.0, 10);
+    orders.emplace_back("2", OrderType::GoodTillCancel, Side::Sell, 100.0, 4);
+    orders.emplace_back("3", OrderType::GoodTillCancel, Side::Buy, 99.0, 10);
+    orders.emplace_back("4", OrderType::GoodTillCancel, Side::Sell, 101.0, 10);
+    orders.emplace_back("5", OrderType::GoodTillCancel, Side::Buy, 50.0, 10);
+
+    push(first, BookCommand::add(&orders[0]));
+    push(first, BookCommand::add(&orders[1]));
+    push(second, BookCommand::add(&orders[2]));
+    push(second, BookCommand::modify(&orders[2], OrderModify{Side::Buy, 98.0, 20}));
+    push(third, BookCommand::add(&orders[3]));
+    push(third, BookCommand::add(&orders[4]));
+    push(third, BookCommand::cancel(&orders[4]));
+
+    runner.stop();
+    EXPECT_FALSE(runner.running());
+
+    EXPECT_EQ(commands.load(), 7);
+    EXPECT_EQ(trades.load(), 1);
+    EXPECT_EQ(orders[0].getRemainingQuantity(), 6);
+    EXPECT_EQ(books[0].getOrderCount(), 1);
+    EXPECT_EQ(books[1].getBestBid()->getPrice(), 98.0);
+    EXPECT_EQ(books[1].getBestBid()->getRemainingQuantity(), 20);
+    EXPECT_EQ(books[2].getOrderCount(), 1);
+
+    RunnerStats stats = runner.stats(0);
+    EXPECT_EQ(stats.commands_ + runner.stats(1).commands_, 7);
+    EXPECT_GE(stats.iterations_, stats.idleIterations_);
+    EXPECT_GE(stats.maxBatch_, 1);
+}
+
+TEST(EngineRunnerTest, IdleBackoff) {
+    std::atomic<size_t> commands{0};
+    std::atomic<size_t> trades{0};
+    RunnerConfig config = testConfig(1);
+    config.cores_ = {-1};
+    config.idle_.sleep_ = std::chrono::microseconds{100};
+    EngineRunner<Book, CountingHandler> runner{config, CountingHandler{&commands, &trades}};
+    runner.start();
+    EXPECT_FALSE(runner.setup(0).pinned_);
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    runner.stop();
+
+    // spun, yielded, then slept
+    RunnerStats stats = runner.stats(0);
+    EXPECT_EQ(stats.commands_, 0);
+    EXPECT_EQ(stats.iterations_, stats.idleIterations_);
+    EXPECT_EQ(stats.yields_, 16);
+    EXPECT_GT(stats.sleeps_, 0);
+    EXPECT_EQ(stats.idleIterations_, 32 + stats.sleeps_);
+}
+
+TEST(EngineRunnerTest, LockMemory) {
+    std::atomic<size_t> commands{0};
+    std::atomic<size_t> trades{0};
+    PageProvider provider;
+    constexpr size_t BYTES = size_t{64} << 10;
+    void *pages = provider.map(BYTES);
+    void *reserved = provider.map(size_t{1} << 30, 0, PoolMapNoReserve);
+
+    RunnerConfig config = testConfig(1);
+    config.lockMemory_ = true;
+    config.memory_ = {&provider};
+    {
+        using Runner = EngineRunner<Book, CountingHandler>;
+        Runner runner{config, CountingHandler{&commands, &trades}};
+        Book book;
+        auto &queue = runner.attach(0, book);
+        runner.start();
+        // the reservation is not made resident, nothing refused
+        EXPECT_TRUE(runner.memoryLocked());
+        EXPECT_EQ(provider.lock_failures(), 0);
+        static_cast<char *>(pages)[BYTES - 1] = 1;
+
+        // the queue's heap storage is resident too
+        size_t page = sysconf(_SC_PAGESIZE);
+        auto begin = reinterpret_cast<uintptr_t>(queue.storage()) & ~(page - 1);
+        size_t bytes = reinterpret_cast<uintptr_t>(queue.storage()) +
+                       Runner::InputQueue::storage_bytes() - begin;
+        std::vector<unsigned char> resident((bytes + page - 1) / page);
+        ASSERT_EQ(mincore(reinterpret_cast<void *>(begin), bytes, resident.data()), 0);
+        for (unsigned char r : resident) {
+            EXPECT_TRUE(r & 1);
+        }
+    }
+
+    provider.unmap(pages, BYTES);
+    provider.unmap(reserved, size_t{1} << 30);
+}
@@ -0,0 +1,126 @@
+#include "book/level_delta.hpp"
+
+#include <gtest/gtest.h>
+
+#include "book/book_l2_map.hpp"
+#include "book/book_l2_vector.hpp"
+#include "book/book_l3_map.hpp"
+
+template <typename T>
+class LevelDeltaTest : public ::testing::Test {};
+
+using L2BookTypes = ::testing::Types<MapBasedL2OrderBook, VectorBasedL2OrderBook<>>;
+
+TYPED_TEST_SUITE(LevelDeltaTest, L2BookTypes);
+
+TYPED_TEST(LevelDeltaTest, PerEvent) {
+    TypeParam book;
+    book.enableDeltaStream();
+    auto *stream = book.getDeltaStream();
+
+    Order bid1{"1", OrderType::GoodTillCancel, Side::Buy, 100.0, 10};
+    Order bid2{"2", OrderType::GoodTillCancel, Side::Buy, 100.0, 20};
+    book.addOrder(&bid1);
+    book.addOrder(&bid2);
+    book.cancelOrder(&bid1);
+    book.cancelOrder(&bid2);
+
+    LevelDelta delta;
+    ASSERT_TRUE(stream->pop(delta));
+    EXPECT_EQ(delta.sequence_, 0);
+    EXPECT_EQ(delta.side_, Side::Buy);
+    EXPECT_EQ(delta.action_, LevelAction::New);
+    EXPECT_EQ(delta.price_, 100.0);
+    EXPECT_EQ(delta.quantity_, 10);
+    EXPECT_EQ(delta.count_, 1);
+
+    ASSERT_TRUE(stream->pop(delta));
+    EXPECT_EQ(delta.sequence_, 1);
+    EXPECT_EQ(delta.action_, LevelAction::Change);
+    EXPECT_EQ(delta.quantity_, 30);
+    EXPECT_EQ(delta.count_, 2);
+
+    ASSERT_TRUE(stream->pop(delta));
+    EXPECT_EQ(delta.action_, LevelAction::Change);
+    EXPECT_EQ(delta.quantity_, 20);
+    EXPECT_EQ(delta.count_, 1);
+
+    ASSERT_TRUE(stream->pop(delta));
+    EXPECT_EQ(delta.sequence_, 3);
+    EXPECT_EQ(delta.action_, LevelAction::Delete);
+    EXPECT_EQ(delta.quantity_, 0);
+
+    EXPECT_FALSE(stream->pop(delta));
+}
+
+TYPED_TEST(LevelDeltaTest, Coalesce) {
+    TypeParam book;
+    Order bid1{"1", OrderType::GoodTillCancel, Side::Buy, 100.0, 10};
+    book.addOrder(&bid1);
+    book.enableDeltaStream();
+    auto *stream = book.getDeltaStream();
+
+    Order bid2{"2", OrderType::GoodTillCancel, Side::Buy, 100.0, 20};
+    Order bid3{"3", OrderType::GoodTillCancel, Side::Buy, 99.0, 30};
+    Order ask1{"4", OrderType::GoodTillCancel, Side::Sell, 101.0, 40};
+
+    book.beginDeltaBatch();
+    book.addOrder(&bid2);
+    book.cancelOrder(&bid1);
+    book.addOrder(&bid3);  // new and gone in the same batch
+    book.cancelOrder(&bid3);
+    book.addOrder(&ask1);
+    EXPECT_TRUE(stream->empty());
+    book.endDeltaBatch();
+
+    LevelDelta delta;
+    ASSERT_TRUE(stream->pop(delta));
+    EXPECT_EQ(delta.sequence_, 0);
+    EXPECT_EQ(delta.action_, LevelAction::Change);
+    EXPECT_EQ(delta.price_, 100.0);
+    EXPECT_EQ(delta.quantity_, 20);
+    EXPECT_EQ(delta.count_, 1);
+
+    ASSERT_TRUE(stream->pop(delta));
+    EXPECT_EQ(delta.sequence_, 1);
+    EXPECT_EQ(delta.side_, Side::Sell);
+    EXPECT_EQ(delta.action_, LevelAction::New);
+    EXPECT_EQ(delta.quantity_, 40);
+
+    EXPECT_FALSE(stream->pop(delta));
+
+    // deleted and recreated within a batch is a change
+    book.beginDeltaBatch();
+    book.cancelOrder(&ask1);
+    book.addOrder(&ask1);
+    book.endDeltaBatch();
+    ASSERT_TRUE(stream->pop(delta));
+    EXPECT_EQ(delta.action_, LevelAction::Change);
+    EXPECT_EQ(delta.quantity_, 40);
+    EXPECT_FALSE(stream->pop(delta));
+}
+
+TEST(LevelDeltaTest, L3Command) {
+    MapBasedL3OrderBook<std::list<Order *>> orderBook;
+    orderBook.getL2Book().enableDeltaStream();
+    auto *stream = orderBook.getL2Book().getDeltaStream();
+
+    Order ask1{"1", OrderType::GoodTillCancel, Side::Sell, 10.0, 100};
+    Order ask2{"2", OrderType::GoodTillCancel, Side::Sell, 10.0, 100};
+    orderBook.addOrder(&ask1);
+    orderBook.addOrder(&ask2);
+
+    LevelDelta delta;
+    while (stream->pop(delta));
+
+    // the aggressor level is added and removed in one command
+    Order bid{"3", OrderType::GoodTillCancel, Side::Buy, 10.0, 150};
+    orderBook.addOrder(&bid);
+
+    ASSERT_TRUE(stream->pop(delta));
+    EXPECT_EQ(delta.side_, Side::Sell);
+    EXPECT_EQ(delta.action_, LevelAction::Change);
+    EXPECT_EQ(delta.quantity_, 50);
+    EXPECT_EQ(delta.count_, 1);
+    EXPECT_FALSE(stream->pop(delta));
+}
\ No newline at end of file
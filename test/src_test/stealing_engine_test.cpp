@@ -0,0 +1,253 @@
+#include "book/stealing_engine.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "book/book_l3_map.hpp"
+
+namespace {
+
+using Book = MapBasedL3OrderBook<std::list<Order *>>;
+
+// what the workers did to a book
+struct BookLog {
+    std::atomic<int> inside_{0};
+    bool overlapped_{false};
+    // order ids of its commands, as handled
+    std::vector<int> ids_;
+};
+
+// records every command, logs are looked up only, they exist before start
+struct RecordingHandler {
+    std::unordered_map<const Book *, BookLog> *logs_;
+
+    void operator()(Book &book, const BookCommand &command, Trades &) const {
+        BookLog &log = logs_->find(&book)->second;
+        if (log.inside_.fetch_add(1, std::memory_order_relaxed) != 0) {
+            log.overlapped_ = true;
+        }
+        log.ids_.push_back(std::stoi(command.order_->getOrderId()));
+        log.inside_.fetch_sub(1, std::memory_order_relaxed);
+    }
+};
+
+// records like RecordingHandler, the commands of a gated book wait in the
+// handler until its gate opens
+struct GatedHandler {
+    RecordingHandler record_;
+    std::unordered_map<const Book *, std::atomic<bool>> *gates_;
+    // commands that reached a gate
+    std::atomic<int> *waiting_;
+
+    void operator()(Book &book, const BookCommand &command, Trades &trades) const {
+        auto gate = gates_->find(&book);
+        if (gate != gates_->end()) {
+            waiting_->fetch_add(1, std::memory_order_acq_rel);
+            while (!gate->second.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+        }
+        record_(book, command, trades);
+    }
+};
+
+template <typename Predicate>
+void waitFor(Predicate done) {
+    while (!done()) {
+        std::this_thread::yield();
+    }
+}
+
+RunnerConfig testConfig(size_t workers) {
+    RunnerConfig config;
+    // a single cpu may be all there is
+    config.cores_.assign(workers, -1);
+    config.idle_.spins_ = 16;
+    config.idle_.yields_ = 16;
+    config.stackPrefaultBytes_ = 64 << 10;
+    return config;
+}
+
+template <typename Queue>
+void push(Queue &queue, const BookCommand &command) {
+    while (!queue.push(command)) {
+        std::this_thread::yield();
+    }
+}
+
+}  // namespace
+
+TEST(StealingEngineTest, KeepsBookOrder) {
+    constexpr int BOOKS = 12;
+    constexpr int ORDERS = 6000;
+    std::unordered_map<const Book *, BookLog> logs;
+    std::vector<Book> books(BOOKS);
+    for (const Book &book : books) {
+        logs[&book];
+    }
+
+    StealingEngine<Book, RecordingHandler, 256> engine{testConfig(3), RecordingHandler{&logs}};
+    std::vector<decltype(engine)::BookQueue *> queues;
+    for (Book &book : books) {
+        queues.push_back(&engine.attach(book));
+    }
+    engine.start();
+    EXPECT_THROW(engine.attach(books[0]), std::logic_error);
+
+    // book 0 gets half of the orders, the others share the rest; orders
+    // never cross and are cancelled again right away
+    std::vector<Order> orders;
+    orders.reserve(ORDERS);
+    std::vector<int> bookOf(ORDERS);
+    for (int i = 0; i < ORDERS; i++) {
+        bookOf[i] = i % 2 == 0 ? 0 : 1 + (i / 2) % (BOOKS - 1);
+        Side side = i % 4 < 2 ? Side::Buy : Side::Sell;
+        Price price = side == Side::Buy ? 90.0 - i % 5 : 110.0 + i % 5;
+        orders.emplace_back(std::to_string(i), OrderType::GoodTillCancel, side, price, 10);
+    }
+    for (int i = 0; i < ORDERS; i++) {
+        push(*queues[bookOf[i]], BookCommand::add(&orders[i]));
+        if (i >= 8) {
+            push(*queues[bookOf[i - 8]], BookCommand::cancel(&orders[i - 8]));
+        }
+    }
+    for (int i = ORDERS - 8; i < ORDERS; i++) {
+        push(*queues[bookOf[i]], BookCommand::cancel(&orders[i]));
+    }
+    engine.stop();
+
+    // every book saw its commands in push order, on one worker at a time
+    for (int b = 0; b < BOOKS; b++) {
+        std::vector<int> expected;
+        for (int i = 0; i < ORDERS + 8; i++) {
+            if (i < ORDERS && bookOf[i] == b) {
+                expected.push_back(i);
+            }
+            if (i >= 8 && bookOf[i - 8] == b) {
+                expected.push_back(i - 8);
+            }
+        }
+        const BookLog &log = logs[&books[b]];
+        EXPECT_FALSE(log.overlapped_);
+        EXPECT_EQ(log.ids_, expected) << "book " << b;
+        EXPECT_EQ(books[b].getOrderCount(), 0);
+    }
+
+    uint64_t commands = 0;
+    uint64_t runs = 0;
+    for (size_t i = 0; i < engine.worker_count(); i++) {
+        StealingStats stats = engine.stats(i);
+        commands += stats.commands_;
+        runs += stats.runs_;
+        EXPECT_GE(stats.runs_, stats.steals_);
+    }
+    EXPECT_EQ(commands, 2 * ORDERS);
+    EXPECT_GE(runs, 1);
+}
+
+TEST(StealingEngineTest, StealsFromBlockedWorker) {
+    using Engine = StealingEngine<Book, GatedHandler>;
+    // one book each keeps the workers out of the way, hot blocks one of
+    // them while cold waits in its run queue
+    Book first;
+    Book second;
+    Book cold;
+    Book hot;
+    std::unordered_map<const Book *, BookLog> logs;
+    std::unordered_map<const Book *, std::atomic<bool>> gates;
+    for (const Book *book : {&first, &second, &cold, &hot}) {
+        logs[book];
+    }
+    for (const Book *book : {&first, &second, &hot}) {
+        gates[book];
+    }
+    std::atomic<int> waiting{0};
+
+    Engine engine{testConfig(2), GatedHandler{RecordingHandler{&logs}, &gates, &waiting}};
+    auto &firstQueue = engine.attach(first);
+    auto &secondQueue = engine.attach(second);
+    auto &coldQueue = engine.attach(cold);
+    auto &hotQueue = engine.attach(hot);
+    engine.start();
+
+    // cold takes the second worker's runs up to the one looking at the
+    // injection queue first, which then finds hot; one command is left
+    constexpr size_t COLD = (Engine::INJECT_INTERVAL - 2) * Engine::BOOK_BUDGET + 1;
+    std::vector<Order> orders;
+    orders.reserve(COLD + 3);
+    for (size_t i = 0; i < COLD + 3; i++) {
+        orders.emplace_back(std::to_string(i), OrderType::GoodTillCancel, Side::Buy, 90.0, 10);
+    }
+
+    // each worker blocks in a book of its own, both run queues are empty
+    push(firstQueue, BookCommand::add(&orders[COLD]));
+    waitFor([&] { return waiting.load(std::memory_order_acquire) == 1; });
+    push(secondQueue, BookCommand::add(&orders[COLD + 1]));
+    waitFor([&] { return waiting.load(std::memory_order_acquire) == 2; });
+
+    for (size_t i = 0; i < COLD; i++) {
+        push(coldQueue, BookCommand::add(&orders[i]));
+    }
+    push(hotQueue, BookCommand::add(&orders[COLD + 2]));
+
+    // the worker of second runs cold, then blocks in hot with cold queued
+    gates[&second].store(true, std::memory_order_release);
+    waitFor([&] { return waiting.load(std::memory_order_acquire) == 3; });
+    EXPECT_EQ(logs[&cold].ids_.size(), COLD - 1);
+    EXPECT_EQ(coldQueue.size(), 1);
+
+    // only a steal takes cold from the blocked worker
+    gates[&first].store(true, std::memory_order_release);
+    waitFor([&] { return coldQueue.size() == 0; });
+    gates[&hot].store(true, std::memory_order_release);
+    engine.stop();
+
+    uint64_t steals = 0;
+    for (size_t i = 0; i < engine.worker_count(); i++) {
+        steals += engine.stats(i).steals_;
+    }
+    EXPECT_GT(steals, 0);
+
+    std::vector<int> expected(COLD);
+    for (size_t i = 0; i < COLD; i++) {
+        expected[i] = i;
+    }
+    EXPECT_FALSE(logs[&cold].overlapped_);
+    EXPECT_EQ(logs[&cold].ids_, expected);
+    EXPECT_EQ(cold.getOrderCount(), COLD);
+    EXPECT_EQ(hot.getOrderCount(), 1);
+}
+
+TEST(StealingEngineTest, Limits) {
+    std::vector<Book> books(5);
+    StealingEngine<Book, IgnoreResults, 16, 4> engine{testConfig(1)};
+    auto &first = engine.attach(books[0]);
+    for (int i = 1; i < 4; i++) {
+        engine.attach(books[i]);
+    }
+    EXPECT_THROW(engine.attach(books[4]), std::length_error);
+
+    // a full book queue refuses, what was pushed before start runs once it
+    // starts
+    std::vector<Order> orders;
+    orders.reserve(17);
+    for (int i = 0; i < 17; i++) {
+        orders.emplace_back(std::to_string(i), OrderType::GoodTillCancel, Side::Buy, 100.0, 10);
+    }
+    for (int i = 0; i < 16; i++) {
+        EXPECT_TRUE(first.push(BookCommand::add(&orders[i])));
+    }
+    EXPECT_FALSE(first.push(BookCommand::add(&orders[16])));
+    EXPECT_EQ(first.size(), 16);
+
+    engine.start();
+    engine.stop();
+    EXPECT_EQ(books[0].getOrderCount(), 16);
+    EXPECT_EQ(engine.stats(0).commands_, 16);
+    EXPECT_EQ(engine.stats(0).steals_, 0);
+}